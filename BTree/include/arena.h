@@ -0,0 +1,49 @@
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <stddef.h>
+#include <vector>
+
+// Blocks are handed out in multiples of one cache line, aligned to it.
+const size_t ARENA_LINE = 64;
+
+// Size of the chunks the arena gets from the heap.
+const size_t ARENA_CHUNK_SIZE = 64 * 1024;
+
+//-------------------------------------------------------------------
+// Arena
+//
+// A bump allocator for the nodes of an in-memory index.  Blocks are
+// carved from large chunks and are never returned to the heap one by
+// one: Release only puts a block on a free list for the next request
+// of the same size, and Clear gives every chunk back in one go.
+// Blocks may not be larger than a chunk.
+//-------------------------------------------------------------------
+
+class Arena {
+
+public:
+
+	Arena() : next(nullptr), end(nullptr), numBytes(0) {}
+	~Arena() { Clear(); }
+
+	void* Allocate(size_t size);
+	void Release(void* block, size_t size);
+	void Clear();
+
+	size_t GetNumOfBytes() { return chunks.size() * ARENA_CHUNK_SIZE; }
+	size_t GetNumOfBytesUsed() { return numBytes; }
+
+private:
+
+	std::vector<char*> chunks;		// as allocated, before alignment
+	char* next;						// free space of the newest chunk
+	char* end;
+	std::vector<void*> freeLists;	// freeLists[n] - released blocks of n lines, linked through their first word
+	size_t numBytes;				// bytes in blocks handed out and not released
+
+	Arena(const Arena&);
+	Arena& operator=(const Arena&);
+};
+
+#endif // _ARENA_H
@@ -12,17 +12,107 @@
 typedef enum 
 {
 	INDEX_NODE,
-	LEAF_NODE		
+	LEAF_NODE,
+	KV_LEAF_NODE,	// leaf of a BTreeKVFile, values stored inline
+	FROZEN_NODE,	// compressed leaf of a frozen BTreeFile
+	PACKED_INDEX_NODE,	// index page of a BTreeFileT, packed fixed-size entries
+	PACKED_LEAF_NODE	// leaf of a BTreeFileT, packed fixed-size entries
 } NodeType;
 
-struct LeafEntry {
-   	int key;
+// The entries of the B+ trees, for any key type.  BTreeFile uses the
+// int instantiations.
+
+template <class Key>
+struct LeafEntryT {
+	Key key;
+	RecordID rid;
+};
+
+template <class Key>
+struct IndexEntryT {
+	Key key;
+	PageID pid;
+};
+
+typedef LeafEntryT<int> LeafEntry;
+typedef IndexEntryT<int> IndexEntry;
+
+// Largest value a BTreeKVFile stores inline next to its key.
+
+const int BT_MAX_VALUE_SIZE = 255;
+
+// A residual predicate on the key of an index entry.  When modulus is
+// not zero, op is applied to the remainder of key modulo modulus,
+// taken in [0, modulus) also for negative keys, which lets a
+// partitioned consumer ask for key % m == r.  modulus must not be
+// negative.
+
+struct KeyPredicate {
+	AttrOperator op;	// aopEQ, aopNE, aopLT, aopLE, aopGT, aopGE or opRANGE
+	int value;
+	int highValue;		// inclusive upper bound, used by opRANGE only
+	int modulus;
+};
+
+// Restricts the entries of a scan to record ids on pages
+// lowPage..highPage (inclusive).
+
+struct RidPageRange {
+	PageID lowPage;
+	PageID highPage;
+};
+
+// One record move for BTreeFile::UpdateRids: the entry (key, oldRid)
+// is to point to newRid from now on.
+
+struct RidUpdate {
+	int key;
+	RecordID oldRid;
+	RecordID newRid;
+};
+
+// A change BTreeFile::Reorganize applies to its copy once the copy
+// is done, because it hit keys the copy had already taken.  rid is
+// the entry inserted, deleted or updated; newRid is the record id an
+// update repoints it to.
+
+enum BTReorgOp { BT_REORG_INSERT, BT_REORG_DELETE, BT_REORG_UPDATE };
+
+struct BTReorgChange {
+	BTReorgOp op;
+	int key;
 	RecordID rid;
+	RecordID newRid;
 };
 
-struct IndexEntry {
-    int key;
+// BTreeFile::Sample gives up after this many random walks per sample
+// asked for, which bounds its cost when the key range is (nearly)
+// empty.
+
+const int BT_SAMPLE_MAX_WALKS = 64;
+
+// BTreeFile::ParallelScan reads index levels until the range holds
+// this many separators per partition, so the partitions can be cut
+// about even.
+
+const int BT_SCAN_SEPARATORS_PER_PART = 8;
+
+// One level of a root-to-leaf path.  Keys in [lowKey, highKey) are
+// routed through page pid; a bound that is not set is open.
+
+const int BT_MAX_HEIGHT = 16;
+
+struct BTPathEntry {
 	PageID pid;
+	int lowKey;
+	int highKey;
+	bool hasLow;
+	bool hasHigh;
+
+	bool Contains(const int key) const
+	{
+		return (!hasLow || key >= lowKey) && (!hasHigh || key < highKey);
+	}
 };
 
 // There macros might be useful to you.
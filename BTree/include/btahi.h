@@ -0,0 +1,58 @@
+#ifndef _BTAHI_H
+#define _BTAHI_H
+
+#include <unordered_map>
+
+#include "minirel.h"
+
+// A key has to be looked up this many times before it gets an entry.
+const int AHI_HOT_THRESHOLD = 4;
+
+// Upper bound on the number of cached keys and on the number of keys
+// whose lookups are being counted.
+const int AHI_MAX_ENTRIES = 4096;
+
+//-------------------------------------------------------------------
+// BTAdaptiveHash
+//
+// An in-memory hash index over the hot keys of a B+ tree.  It maps a
+// key straight to the leaf page and slot that held it, so a repeated
+// point lookup needs a single pin.  Every leaf has a version counter
+// that the tree bumps whenever the leaf is changed in a way that can
+// move entries (insert, split, delete, merge, redistribution); an
+// entry recorded under an older version is stale and is dropped.
+//-------------------------------------------------------------------
+
+class BTAdaptiveHash {
+
+public:
+
+	BTAdaptiveHash() : hits(0), misses(0) {}
+
+	bool Probe(const int key, PageID& pid, int& slot);
+	void RecordLookup(const int key, const PageID pid, const int slot);
+	void Forget(const int key);
+	void TouchLeaf(const PageID pid);
+	void Clear();
+
+	long GetHits() { return hits; }
+	long GetMisses() { return misses; }
+
+private:
+
+	struct Entry {
+		PageID pid;
+		int slot;
+		unsigned int version;
+	};
+
+	std::unordered_map<int, Entry> entries;
+	std::unordered_map<int, int> lookupCounts;
+	std::unordered_map<PageID, unsigned int> leafVersions;
+	long hits;
+	long misses;
+
+	unsigned int LeafVersion(const PageID pid);
+};
+
+#endif // _BTAHI_H
@@ -0,0 +1,57 @@
+#ifndef _BTBUILD_H
+#define _BTBUILD_H
+
+#include <vector>
+
+#include "minirel.h"
+#include "bt.h"
+#include "btbulk.h"
+#include "cbufmgr.h"
+
+// Keys sampled from every sorted run to choose the key ranges of the
+// merge.
+const int BT_BUILD_SAMPLES_PER_RUN = 64;
+
+//-------------------------------------------------------------------
+// BTParallelBuilder
+//
+// Builds a B+ tree over the records of a heap file on several
+// threads, in four phases:
+//
+//   1. Scan: the heap pages are cut into one contiguous share per
+//      thread, and each thread collects the key and record id of
+//      every record in its share.
+//   2. Sort: each thread sorts what it collected into a run.
+//   3. Merge: the key space is cut into one range per thread at
+//      splitters sampled from the runs, and each thread merges the
+//      parts of all runs that fall into its range.
+//   4. Load: each thread feeds its merge to a BTBulkLoader of its own,
+//      so the leaves of all ranges are written at once, each range
+//      into runs of pages of its own.  The leaf chains are then joined
+//      and the index levels are built over them on one thread; they
+//      are a small fraction of the pages.
+//
+// Equal keys fall into the same range, so a run of duplicates is never
+// split between two loaders.  The threads pin the pages through a
+// ConcurrentBufMgr.  The sorted runs are kept in memory.
+//-------------------------------------------------------------------
+
+class BTParallelBuilder {
+
+public:
+
+	BTParallelBuilder(const int nThreads, const float fillFactor) : nThreads(nThreads > 0 ? nThreads : 1), fillFactor(fillFactor) {}
+
+	Status Build(const std::vector<PageID>& heapPids, const int keyOffset, PageID& rootPid);
+
+private:
+
+	int nThreads;
+	float fillFactor;
+
+	static Status ScanRun(ConcurrentBufMgr& pool, const PageID* pids, const int numPids, const int keyOffset, std::vector<LeafEntry>& run);
+	void ChooseSplitters(const std::vector<std::vector<LeafEntry> >& runs, std::vector<int>& splitters);
+	static Status MergeRange(const std::vector<std::vector<LeafEntry> >& runs, const int* lowKey, const int* highKey, BTBulkLoader& loader);
+};
+
+#endif // _BTBUILD_H
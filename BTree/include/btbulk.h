@@ -0,0 +1,113 @@
+#ifndef _BTBULK_H
+#define _BTBULK_H
+
+#include <vector>
+
+#include "minirel.h"
+#include "btleaf.h"
+#include "btindex.h"
+#include "cbufmgr.h"
+
+// Leaves are allocated in runs of this many pages, so that the leaf
+// chain of a loaded tree is laid out sequentially in the DB file.
+const int BT_BULK_EXTENT = 32;
+
+// Fill factor BTreeFile::Reorganize() packs leaves to.  Some room is
+// left so that the first inserts into a leaf do not split it.
+const float BT_REORG_FILL_FACTOR = 0.9f;
+
+//-------------------------------------------------------------------
+// BTBulkLoader
+//
+// Builds a B+ tree bottom-up from entries added in key order.  Leaves
+// are filled up to fillFactor of a page and written once, in order,
+// into runs of BT_BULK_EXTENT pages.  The lowest key of every leaf is
+// kept in memory, and Finish builds the index levels from that list,
+// spreading the children of a level evenly over its pages.
+//
+// A run of equal keys is kept on one leaf as long as the leaf has room,
+// since a separator equal to the keys on its left would hide them from
+// a descent.
+//
+// Until Finish succeeds the pages belong to the loader; Abort (or the
+// destructor) frees them.
+//
+// Loaders given a ConcurrentBufMgr pin their pages through it, so that
+// several of them can fill the leaves of adjacent key ranges on
+// different threads.  Append then joins their leaf chains into one
+// loader, which builds the index levels over all of them.
+//-------------------------------------------------------------------
+
+class BTBulkLoader {
+
+public:
+
+	BTBulkLoader(Status& status, const float fillFactor, ConcurrentBufMgr* pool = nullptr);
+	~BTBulkLoader();
+
+	Status Add(const int key, const RecordID rid);
+	Status Append(BTBulkLoader& next);
+	Status Finish(PageID& rootPid);
+	Status Abort();
+
+	int GetNumOfPages() { return numPages; }
+	int GetNumOfEntries() { return numEntries; }
+
+private:
+
+	float fillFactor;
+	ConcurrentBufMgr* pool;			// pins the pages, or nullptr for MINIBASE_BM
+	int numPages;					// pages written so far, leaves and index pages
+	int numEntries;
+	bool finished;
+	BTLeafPage* leaf;				// the leaf being filled, pinned; nullptr before the first Add
+	PageID leafPid;
+	int lastKey;					// last key added
+	PageID extentNext;				// next unused page of the current run
+	int extentLeft;					// unused pages left in the run
+	std::vector<int> lowKeys;		// lowest key of every leaf written, in order
+	std::vector<PageID> leafPids;
+	std::vector<PageID> indexPids;	// index pages written by Finish
+
+	Status NewLeaf();
+	Status FreeExtent();
+	Status PinPage(const PageID pid, Page*& page, const bool emptyPage);
+	Status UnpinPage(const PageID pid, const int dirty);
+	Status NewPage(PageID& firstPid, Page*& firstPage, const int howMany);
+	Status FreePage(const PageID pid);
+	Status BuildLevel(const std::vector<int>& keys, const std::vector<PageID>& pids, std::vector<int>& upKeys, std::vector<PageID>& upPids);
+	int IndexCapacity();
+};
+
+//-------------------------------------------------------------------
+// BTLeafChainReader
+//
+// Streams the entries of a leaf chain in key order, the input side of
+// a bulk load.  The current leaf stays pinned until the reader moves
+// past it.
+//-------------------------------------------------------------------
+
+class BTLeafChainReader {
+
+public:
+
+	BTLeafChainReader() : pid(INVALID_PAGE), leaf(nullptr), slot(0) {}
+	~BTLeafChainReader() { Close(); }
+
+	Status Open(const PageID firstPid);
+	Status Next();
+	void Close();
+
+	bool IsValid() { return leaf != nullptr; }
+	LeafEntry* GetEntry() { return leaf->GetEntry(slot); }
+
+private:
+
+	PageID pid;
+	BTLeafPage* leaf;	// pinned, nullptr once the chain is exhausted
+	int slot;
+
+	Status SkipEmpty();
+};
+
+#endif // _BTBULK_H
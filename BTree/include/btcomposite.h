@@ -0,0 +1,174 @@
+#ifndef _BTCOMPOSITE_H
+#define _BTCOMPOSITE_H
+
+#include <string.h>
+
+#include "btfilet.h"
+
+//-------------------------------------------------------------------
+// Composite keys
+//
+// A composite key of several columns is encoded into a FixedKey<N>
+// whose byte order is the order of the column tuple, so a BTreeFileT
+// over FixedKey<N> compares two keys with one memcmp.  Each column is
+// written big-endian in a form whose unsigned byte order matches its
+// value order:
+//
+//   int, long long - two's complement with the sign bit flipped
+//   double         - IEEE bits, all flipped if negative, else the
+//                    sign bit flipped (NaN is not supported)
+//   string         - a fixed width, padded with zero bytes
+//
+// The bytes after the last column are zero, so a key built from the
+// leading columns only is the lowest key with that prefix.  GetHighKey
+// fills them with 0xFF instead, and the pair bounds a prefix scan
+// through the ordinary OpenScan range.
+//-------------------------------------------------------------------
+
+template <int N>
+class CompositeKeyBuilder {
+
+public:
+
+	CompositeKeyBuilder() : len(0), overflow(false) {}
+
+	CompositeKeyBuilder& AddInt(const int value){
+		return AddUnsigned((unsigned int) value ^ 0x80000000u, 4);
+	}
+
+	CompositeKeyBuilder& AddLong(const long long value){
+		return AddUnsigned((unsigned long long) value ^ 0x8000000000000000ull, 8);
+	}
+
+	CompositeKeyBuilder& AddDouble(const double value){
+		unsigned long long bits;
+		memcpy(&bits, &value, sizeof(bits));
+		bits = (bits & 0x8000000000000000ull) ? ~bits : (bits ^ 0x8000000000000000ull);
+		return AddUnsigned(bits, 8);
+	}
+
+	CompositeKeyBuilder& AddString(const char* value, const int width){
+		if (len + width > N){
+			overflow = true;
+			return *this;
+		}
+		int n = (int) strnlen(value, width);
+		memcpy(bytes + len, value, n);
+		memset(bytes + len + n, 0, width - n);
+		len += width;
+		return *this;
+	}
+
+	// false if the columns added do not fit into N bytes
+	bool IsValid() const { return !overflow; }
+	int GetLength() const { return len; }
+
+	// the key, and the lowest key with these leading columns
+	FixedKey<N> GetKey() const { return Fill(0x00); }
+
+	// the highest key with these leading columns
+	FixedKey<N> GetHighKey() const { return Fill(0xFF); }
+
+private:
+
+	unsigned char bytes[N];
+	int len;
+	bool overflow;
+
+	CompositeKeyBuilder& AddUnsigned(unsigned long long value, const int width){
+		if (len + width > N){
+			overflow = true;
+			return *this;
+		}
+		for (int i = width - 1; i >= 0; i--){
+			bytes[len + i] = (unsigned char) value;
+			value >>= 8;
+		}
+		len += width;
+		return *this;
+	}
+
+	FixedKey<N> Fill(const unsigned char pad) const{
+		FixedKey<N> key;
+		memcpy(key.bytes, bytes, len);
+		memset(key.bytes + len, pad, N - len);
+		return key;
+	}
+};
+
+
+//-------------------------------------------------------------------
+// CompositeKeyReader
+//
+// Decodes the columns of a key made by CompositeKeyBuilder, in the
+// order they were added.
+//-------------------------------------------------------------------
+
+template <int N>
+class CompositeKeyReader {
+
+public:
+
+	CompositeKeyReader(const FixedKey<N>& key) : key(key), pos(0) {}
+
+	int ReadInt(){
+		return (int) (ReadUnsigned(4) ^ 0x80000000u);
+	}
+
+	long long ReadLong(){
+		return (long long) (ReadUnsigned(8) ^ 0x8000000000000000ull);
+	}
+
+	double ReadDouble(){
+		unsigned long long bits = ReadUnsigned(8);
+		bits = (bits & 0x8000000000000000ull) ? (bits ^ 0x8000000000000000ull) : ~bits;
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	// value must hold width + 1 bytes
+	void ReadString(char* value, const int width){
+		memcpy(value, key.bytes + pos, width);
+		value[width] = '\0';
+		pos += width;
+	}
+
+private:
+
+	FixedKey<N> key;
+	int pos;
+
+	unsigned long long ReadUnsigned(const int width){
+		unsigned long long value = 0;
+		for (int i = 0; i < width; i++){
+			value = (value << 8) | key.bytes[pos + i];
+		}
+		pos += width;
+		return value;
+	}
+};
+
+
+//-------------------------------------------------------------------
+// OpenPrefixScan
+//
+// Input   : file - a composite key index
+//           prefix - the leading columns to match
+// Output  : None
+// Return  : A scan of all entries whose key starts with prefix, in key
+//           order.  The caller deletes it.
+// Purpose : Prefix scan, e.g. all rows of one tenant of a (tenant,
+//           timestamp) index.
+//-------------------------------------------------------------------
+
+template <int N>
+BTreeFileScanT<FixedKey<N>, std::less<FixedKey<N> > >*
+OpenPrefixScan(BTreeFileT<FixedKey<N> >& file, const CompositeKeyBuilder<N>& prefix)
+{
+	FixedKey<N> low = prefix.GetKey();
+	FixedKey<N> high = prefix.GetHighKey();
+	return file.OpenScan(&low, &high);
+}
+
+#endif // _BTCOMPOSITE_H
@@ -1,27 +1,65 @@
 #ifndef _BTFILE_H
 #define _BTFILE_H
 
+#include <atomic>
+#include <functional>
+#include <map>
+#include <random>
+#include <vector>
+
 #include "btindex.h"
 #include "btleaf.h"
 #include "index.h"
 #include "btfilescan.h"
 #include "bt.h"
+#include "btahi.h"
+#include "btlearned.h"
+#include "btfrozen.h"
+#include "btbulk.h"
+#include "btswizzle.h"
+#include "btlatch.h"
+#include "cbufmgr.h"
+
+// Receives the entries of a BTreeFile::ParallelScan: the partition
+// the entry is in, its key and its record id.
+typedef std::function<void (int part, int key, const RecordID& rid)> BTScanCallback;
 
 class BTreeFile: public IndexFile {
 
 public:
 
 	friend class BTreeFileScan;
+	friend class BTreeRange;
 
 	BTreeFile(Status& status, const char* filename);
 	~BTreeFile();
 
 	Status DestroyFile();
+	Status Freeze();
+	Status Reorganize();
+	Status Reorganize(const float fillFactor, const int pageBudget, bool& finished);
+	Status MergeFrom(BTreeFile& other);
+	Status CreateIndex(const std::vector<PageID>& heapPids, const int keyOffset, const int nThreads);
+	bool IsFrozen() { return frozen != nullptr; }
 
 	Status Insert(const int key, const RecordID rid);
 	Status Delete(const int key, const RecordID rid);
+	Status UpdateRid(const int key, const RecordID oldRid, const RecordID newRid);
+	Status UpdateRids(const RidUpdate* updates, int n);
+	Status RemapRids(const std::map<RecordID, RecordID>& mapping);
 
 	IndexFileScan* OpenScan(const int* lowKey, const int* highKey);
+	IndexFileScan* OpenScan(const int* lowKey, const int* highKey, const KeyPredicate* preds, int numPreds, const RidPageRange* ridRange = nullptr);
+
+	Status Lookup(const int key, RecordID& rid);
+	Status LookupBatch(const int* keys, int n, RecordID* out, bool* found);
+	Status ParallelScan(const int* lowKey, const int* highKey, int nThreads, const BTScanCallback& callback);
+	Status Sample(const int n, const unsigned int seed, std::vector<LeafEntry>& samples, const int* lowKey = nullptr, const int* highKey = nullptr);
+
+	void EnableAdaptiveHash(bool enable);
+	void EnableLearnedRouting(bool enable);
+	void EnableSwizzling(bool enable, const int maxPages = BT_SWIZZLE_MAX_PAGES);
+	void EnableConcurrency(bool enable, const int poolFrames = CBM_NUM_FRAMES);
 
 	Status Print();
 	Status DumpStatistics();
@@ -30,11 +68,45 @@ private:
 
 	// You may add members and methods here.
 
-	PageID rootPid;
+	std::atomic<PageID> rootPid;		// read by optimistic readers, which take no latch
 	const char* fname;
-
-	void setRootPid(PageID pid) { rootPid = pid; }
+	std::atomic<unsigned int> structureVersion;	// bumped whenever a split or an underflow changes separators
+	BTAdaptiveHash* ahi;			// hash index over hot keys, nullptr when disabled
+	BTLearnedRouter* router;		// key -> leaf model replacing index descents, nullptr when disabled
+	BTSwizzleTable* swizzle;		// hot index pages kept pinned by frame pointer, nullptr when disabled
+	BTLatchTable* latches;			// page and tree latches for concurrent use, nullptr when single-threaded
+	ConcurrentBufMgr* pool;			// frames of the pages pinned under latches, nullptr when single-threaded
+	BTFrozenDirectory* frozen;		// top level of a frozen tree, nullptr while the tree is updatable
+	BTBulkLoader* reorg;			// compacted copy being built by Reorganize, nullptr when none
+	int reorgKey;					// last key Reorganize has copied, valid when reorgCopied
+	bool reorgCopied;				// the copy has taken some entries
+	std::vector<BTReorgChange> reorgLog;	// changes to keys the copy has taken, applied when it is done
+	unsigned int generation;		// bumped whenever the tree is rebuilt onto new pages
+
+	void setRootPid(PageID pid) { rootPid.store(pid, std::memory_order_release); }
 	void setFileName(const char* filename){fname=filename;}
+	void TouchLeaf(PageID pid) { if (ahi != nullptr) ahi->TouchLeaf(pid); }
+	void AbortReorganize() { delete reorg; reorg = nullptr; reorgLog.clear(); }
+	void LogReorganize(const BTReorgOp op, const int key, const RecordID rid, const RecordID newRid);
+	void ReleaseFrames() { if (swizzle != nullptr) swizzle->Clear(); if (pool != nullptr) pool->FlushAllPages(); }
+	void LatchTree(const bool exclusive);
+	void UnlatchTree(const bool exclusive);
+	Status PinLatched(const PageID pid, Page*& page, const BTLatchMode mode);
+	Status UnpinLatched(const PageID pid, const BTLatchMode mode, const int dirty);
+	Status NewPageLatched(PageID& pid, Page*& page);
+	unsigned int ReadTreeVersion();
+	bool ValidateRead(const PageID pid, const unsigned int pageVersion, const unsigned int treeVersion);
+	Status PinOptimistic(const PageID pid, Page*& page, unsigned int& pageVersion);
+	PageID FindLeafLatched(const int key, const BTLatchMode mode, Page*& leaf, unsigned int& treeVersion);
+	PageID LatchPath(const int key, const bool inserting, std::vector<PageID>& held);
+	Status UnlatchPath(std::vector<PageID>& held);
+	Status InsertLatched(const int key, const RecordID rid);
+	Status InsertExclusive(const int key, const RecordID rid);
+	Status DeleteLatched(const int key, const RecordID rid);
+	Status DeleteExclusive(const int key, const RecordID rid);
+	Status LookupLatched(const int key, RecordID& rid);
+	Status UpdateRidsLatched(const RidUpdate* updates, int n);
+	Status RemapRidsExclusive(const std::map<RecordID, RecordID>& mapping);
 	Status DestroyFileHelper(PageID curPid);
 	Status InsertHelper (const int key, const RecordID rid, PageID curPid, bool& split, int& child_key, PageID& child_pageid);
 	Status Split_Leaf(BTLeafPage* oldPage, BTLeafPage* newPage, const int key,const RecordID rid);
@@ -47,6 +119,19 @@ private:
 	PageID GetMinimumPid(int & key,int & height );
 	PageID GetMaxKey(int & key);
 	PageID FindPidWithKey(const int key);
+	PageID FindPidSwizzled(const int key);
+	PageID FindPidWithPath(const int key, BTPathEntry* path, int& pathLen);
+	Status SaveRootPid(const PageID pid);
+	Status SwitchRoot(PageID newRootPid);
+	Status BuildRouter();
+	Status LoadFrozenDirectory();
+	Status DumpFrozenStatistics();
+	Status CollectLeafBounds(PageID pid, const int lowKey, std::vector<int>& lowKeys, std::vector<PageID>& pids);
+	Status SplitRange(const int lowKey, const int highKey, const int nParts, std::vector<int>& bounds);
+	Status ScanPartition(ConcurrentBufMgr* scanPool, PageID pid, const int part, const int lowKey, const int highKey, const BTScanCallback& callback);
+	Status ScanPartitionLatched(const int part, const int lowKey, const int highKey, const BTScanCallback& callback);
+	Status SampleWalk(std::mt19937& rng, const int lowKey, const int highKey, LeafEntry& entry, bool& accepted);
+	Status LookupBatchHelper(PageID pid, SortedPage* curPage, const int* keys, const int* order, int lo, int hi, RecordID* out, bool* found);
 	Status PrintTree(PageID pid);
 	Status PrintNode(PageID pid);
 	Status Sum_Index_nodes(PageID curpid, int& nodes, int& num_of_records, float& sum_fill, float& max_fill,float& min_fill);
@@ -1,6 +1,8 @@
 #ifndef _BTREE_FILESCAN_H
 #define _BTREE_FILESCAN_H
 
+#include <vector>
+
 #include "btfile.h"
 
 class BTreeFile;
@@ -13,6 +15,7 @@ public:
 
 	Status GetNext(RecordID& rid,  int& key);
 	Status DeleteCurrent();
+	Status Seek(const int key);
 
 	~BTreeFileScan();
 	
@@ -22,10 +25,22 @@ private:
 	Status s;
 	PageID curPid;
 	int key_scanned;
+	bool scanned;		// key_scanned is valid
 	RecordID dataRid;
 	BTreeFile * btfile; 
+	std::vector<KeyPredicate> preds;	// residual predicates, all must hold
+	bool hasRidRange;
+	RidPageRange ridRange;
+	BTPathEntry path[BT_MAX_HEIGHT];	// root-to-leaf path of the last descent
+	int pathLen;
+	unsigned int pathVersion;			// btfile->structureVersion when path was taken
+	std::vector<LeafEntry> frozenEntries;	// decoded entries of frozenPid
+	PageID frozenPid;
+	unsigned int generation;			// btfile->generation when curPid was found
+	unsigned int treeVersion;			// tree latch version when curPid was found, with concurrency on
 	
-	Status GetNextHelper(PageID pid, RecordID & rid, int& key);
+	Status GetNextHelper(PageID pid, RecordID & rid, int& key, const unsigned int readVersion, bool& retry);
+	bool Matches(const int key, const RecordID& rid);
 };
 
 #endif
@@ -0,0 +1,109 @@
+#ifndef _BTFILESCAN_T_H
+#define _BTFILESCAN_T_H
+
+#include "btfilet.h"
+
+//-------------------------------------------------------------------
+// BTreeFileScanT
+//
+// A range scan of a BTreeFileT.  The scan keeps its position as a
+// leaf and a slot, so the tree must not be changed while it is open
+// except through DeleteCurrent.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+class BTreeFileScanT {
+
+public:
+
+	friend class BTreeFileT<Key, Compare>;
+
+	Status GetNext(RecordID& rid, Key& key);
+	Status DeleteCurrent();
+
+	~BTreeFileScanT() {}
+
+private:
+	BTreeFileT<Key, Compare>* btfile;
+	Key lowKey;
+	Key highKey;
+	bool hasLow;		// lowKey is set
+	bool hasHigh;		// highKey is set
+	PageID curPid;
+	int slot;			// next slot of curPid, -1 until the scan is positioned
+	bool scanned;		// slot - 1 of curPid is the entry returned last
+};
+
+
+//-------------------------------------------------------------------
+// BTreeFileScanT::GetNext
+//
+// Input   : None
+// Output  : rid  - record id of the scanned entry.
+//           key  - key of the scanned entry
+// Purpose : Return the next entry of the range.
+// Return  : OK if successful, DONE if no more entries to read.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+Status
+BTreeFileScanT<Key, Compare>::GetNext(RecordID& rid, Key& key)
+{
+	Compare less;
+	while (this->curPid != INVALID_PAGE){
+		typename BTreeFileT<Key, Compare>::LeafPage* leafPage;
+		PIN(this->curPid,leafPage);
+		if (this->slot < 0){ //first call, find the start of the range
+			this->slot = this->hasLow ? leafPage->LowerBound(this->lowKey) : 0;
+		}
+		if (this->slot < leafPage->GetNumOfRecords()){
+			LeafEntryT<Key>* entry = leafPage->GetEntry(this->slot);
+			if (this->hasHigh && less(this->highKey, entry->key)){
+				UNPIN(this->curPid,CLEAN);
+				this->curPid = INVALID_PAGE;
+				break;
+			}
+			rid = entry->rid;
+			key = entry->key;
+			this->slot++;
+			this->scanned = true;
+			UNPIN(this->curPid,CLEAN);
+			return OK;
+		}
+		PageID nextPid = leafPage->GetNextPage();
+		UNPIN(this->curPid,CLEAN);
+		this->curPid = nextPid;
+		this->slot = 0;
+		this->scanned = false;
+	}
+	this->scanned = false;
+	return DONE;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileScanT::DeleteCurrent
+//
+// Input   : None
+// Output  : None
+// Purpose : Delete the entry returned by the previous GetNext.
+// Return  : OK if successful, DONE if there is no such entry.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+Status
+BTreeFileScanT<Key, Compare>::DeleteCurrent()
+{
+	if (!this->scanned){
+		return DONE;
+	}
+	typename BTreeFileT<Key, Compare>::LeafPage* leafPage;
+	PIN(this->curPid,leafPage);
+	this->slot--;
+	leafPage->Remove(this->slot);
+	UNPIN(this->curPid,DIRTY);
+	this->scanned = false;
+	return OK;
+}
+
+#endif // _BTFILESCAN_T_H
@@ -0,0 +1,476 @@
+#ifndef _BTFILE_T_H
+#define _BTFILE_T_H
+
+#include <type_traits>
+#include <vector>
+
+#include "minirel.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "heappage.h"
+#include "btpaget.h"
+
+template <class Key, class Compare> class BTreeFileScanT;
+
+//-------------------------------------------------------------------
+// BTreeFileT
+//
+// A B+ tree over a fixed-size Key ordered by Compare, for the key
+// types other than int: long long, double or FixedKey<N>.  Everything
+// is instantiated per key type at compile time, so node searches call
+// Compare inline and the pages (BTLeafPageT, BTIndexPageT) pack their
+// entries as a plain array with no slot directory.  int keys belong in
+// BTreeFile, whose slotted pages its frozen, hashed and learned
+// accelerators are built on, so the template refuses them.
+// src/btfilet.cpp instantiates it for long long, double and
+// FixedKey<32>.
+//
+// Duplicate keys are allowed.  An insert goes right of the entries
+// with an equal key, and a search descends to the leftmost leaf that
+// can hold the key and follows the leaf chain, so a run of equal keys
+// split over several leaves is found in full.
+//
+// Delete does not merge or redistribute pages.  A leaf may become
+// empty; it stays in the leaf chain and refills on later inserts.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare = std::less<Key> >
+class BTreeFileT {
+
+	static_assert(!std::is_same<Key, int>::value, "int keys belong in BTreeFile");
+
+public:
+
+	typedef BTLeafPageT<Key, Compare> LeafPage;
+	typedef BTIndexPageT<Key, Compare> IndexPage;
+	typedef BTreeFileScanT<Key, Compare> Scan;
+
+	friend class BTreeFileScanT<Key, Compare>;
+
+	BTreeFileT(Status& status, const char* filename);
+	~BTreeFileT() {}
+
+	Status DestroyFile();
+
+	Status Insert(const Key& key, const RecordID rid);
+	Status Delete(const Key& key, const RecordID rid);
+	Status Lookup(const Key& key, RecordID& rid);
+
+	Scan* OpenScan(const Key* lowKey, const Key* highKey);
+
+private:
+
+	PageID rootPid;
+	const char* fname;
+
+	static bool Equal(const Key& a, const Key& b) { Compare less; return !less(a, b) && !less(b, a); }
+
+	Status SetRoot(PageID pid);
+	Status DestroyFileHelper(PageID curPid);
+	Status InsertHelper(const Key& key, const RecordID rid, PageID curPid, bool& split, Key& child_key, PageID& child_pageid);
+	PageID FindLeaf(const Key* key);
+	Status FindEntry(const Key& key, const RecordID* rid, PageID& pid, int& slot);
+};
+
+#include "btfilescant.h"
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::BTreeFileT
+//
+// Input   : filename - filename of the index.
+// Output  : returnStatus - status of execution of constructor.
+//           OK if successful, FAIL otherwise.
+// Purpose : If the file exists, open it.  Otherwise create a new,
+//           empty tree.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+BTreeFileT<Key, Compare>::BTreeFileT(Status& returnStatus, const char* filename)
+{
+	PageID pid = INVALID_PAGE;
+	Page* page;
+	fname = filename;
+	rootPid = INVALID_PAGE;
+	if (MINIBASE_DB->GetFileEntry(filename, pid) == OK){
+		rootPid = pid;
+		returnStatus = OK;
+		return;
+	}
+	returnStatus = MINIBASE_BM->NewPage(pid, page);
+	if (returnStatus != OK){
+		return;
+	}
+	returnStatus = MINIBASE_DB->AddFileEntry(filename, pid);
+	if (returnStatus == OK){
+		((LeafPage *) page)->InitLeaf(pid);
+		rootPid = pid;
+	}
+	MINIBASE_BM->UnpinPage(pid, DIRTY);
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::DestroyFile
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Free every page of the file and delete its entry.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+Status
+BTreeFileT<Key, Compare>::DestroyFile()
+{
+	if (rootPid != INVALID_PAGE){
+		if (DestroyFileHelper(rootPid) != OK){
+			cerr << "Unable to destroy the BTreeFileT " << endl;
+			return FAIL;
+		}
+		rootPid = INVALID_PAGE;
+	}
+	if (MINIBASE_DB->DeleteFileEntry(fname) != OK){
+		cerr << "unable to delete the file " << endl;
+		return FAIL;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::DestroyFileHelper
+//
+// Input   : curPid - root of the subtree to free
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Free the subtree at curPid, children first.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+Status
+BTreeFileT<Key, Compare>::DestroyFileHelper(PageID curPid)
+{
+	SortedPage* curPage;
+	PIN(curPid,curPage);
+	std::vector<PageID> children;
+	if (curPage->GetType() == PACKED_INDEX_NODE){
+		IndexPage* indexPage = (IndexPage *) curPage;
+		for (int i = 0; i <= indexPage->GetNumOfRecords(); i++){
+			children.push_back(indexPage->GetChild(i));
+		}
+	}
+	UNPIN(curPid,CLEAN);
+	for (size_t i = 0; i < children.size(); i++){
+		if (DestroyFileHelper(children[i]) != OK){
+			return FAIL;
+		}
+	}
+	FREEPAGE(curPid);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::SetRoot
+//
+// Input   : pid - the new root
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Make pid the root and point the file entry at it, so that
+//           reopening the file finds the whole tree.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+Status
+BTreeFileT<Key, Compare>::SetRoot(PageID pid)
+{
+	if (MINIBASE_DB->DeleteFileEntry(fname) != OK || MINIBASE_DB->AddFileEntry(fname, pid) != OK){
+		cerr << "unable to update the file entry of " << fname << endl;
+		return FAIL;
+	}
+	rootPid = pid;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::Insert
+//
+// Input   : key - the value of the key to be inserted.
+//           rid - RecordID of the record to be inserted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert an index entry.  A split of the root grows the tree
+//           by one level.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+Status
+BTreeFileT<Key, Compare>::Insert(const Key& key, const RecordID rid)
+{
+	if (rootPid == INVALID_PAGE){
+		return FAIL;
+	}
+	bool split = false;
+	Key child_key;
+	PageID child_pageid;
+	if (InsertHelper(key, rid, rootPid, split, child_key, child_pageid) != OK){
+		return FAIL;
+	}
+	if (split){
+		IndexPage* newRoot;
+		PageID newRootPid;
+		NEWPAGE(newRootPid,newRoot);
+		newRoot->InitIndex(newRootPid, rootPid);
+		newRoot->Insert(child_key, child_pageid);
+		UNPIN(newRootPid,DIRTY);
+		return SetRoot(newRootPid);
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::InsertHelper
+//
+// Input   : key, rid - the entry to insert
+//           curPid - the page of the subtree key belongs to
+// Output  : split - whether curPid has split
+//           child_key, child_pageid - when split is true, the
+//                     separator and the new page to its right
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert the entry into the subtree at curPid, splitting full
+//           pages on the way back up.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+Status
+BTreeFileT<Key, Compare>::InsertHelper(const Key& key, const RecordID rid, PageID curPid, bool& split, Key& child_key, PageID& child_pageid)
+{
+	Compare less;
+	SortedPage* curPage;
+	PIN(curPid,curPage);
+	if (curPage->GetType() == PACKED_INDEX_NODE){
+		IndexPage* indexPage = (IndexPage *) curPage;
+		PageID childPid = indexPage->GetChild(indexPage->FindChildSlot(key));
+		UNPIN(curPid,CLEAN);
+		bool childSplit = false;
+		Key newKey;
+		PageID newPid;
+		if (InsertHelper(key, rid, childPid, childSplit, newKey, newPid) != OK){
+			return FAIL;
+		}
+		if (!childSplit){
+			return OK;
+		}
+		PIN(curPid,indexPage);
+		if (indexPage->IsFull()){ //no room for the separator, split this page too
+			IndexPage* newIndexPage;
+			PageID newIndexPid;
+			NEWPAGE(newIndexPid,newIndexPage);
+			newIndexPage->InitIndex(newIndexPid, INVALID_PAGE);
+			indexPage->MoveUpperHalf(newIndexPage, child_key);
+			IndexPage* target = less(newKey, child_key) ? indexPage : newIndexPage;
+			target->Insert(newKey, newPid);
+			split = true;
+			child_pageid = newIndexPid;
+			UNPIN(newIndexPid,DIRTY);
+		}
+		else{
+			indexPage->Insert(newKey, newPid);
+		}
+		UNPIN(curPid,DIRTY);
+		return OK;
+	}
+
+	//case when curPage is a leaf
+	LeafPage* leafPage = (LeafPage *) curPage;
+	if (leafPage->IsFull()){
+		LeafPage* newLeafPage;
+		PageID newLeafPid;
+		NEWPAGE(newLeafPid,newLeafPage);
+		newLeafPage->InitLeaf(newLeafPid);
+		leafPage->MoveUpperHalf(newLeafPage);
+		PageID nextPid = leafPage->GetNextPage();
+		if (nextPid != INVALID_PAGE){
+			SortedPage* nextPage;
+			PIN(nextPid,nextPage);
+			nextPage->SetPrevPage(newLeafPid);
+			UNPIN(nextPid,DIRTY);
+		}
+		newLeafPage->SetNextPage(nextPid);
+		newLeafPage->SetPrevPage(curPid);
+		leafPage->SetNextPage(newLeafPid);
+		child_key = newLeafPage->GetEntry(0)->key;
+		LeafPage* target = less(key, child_key) ? leafPage : newLeafPage;
+		target->Insert(key, rid);
+		split = true;
+		child_pageid = newLeafPid;
+		UNPIN(newLeafPid,DIRTY);
+	}
+	else{
+		leafPage->Insert(key, rid);
+	}
+	UNPIN(curPid,DIRTY);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::Delete
+//
+// Input   : key - the value of the key to be deleted.
+//           rid - RecordID of the record to be deleted.
+// Output  : None
+// Return  : OK if successful, FAIL if the entry is not in the index.
+// Purpose : Delete an index entry.  Pages are not merged.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+Status
+BTreeFileT<Key, Compare>::Delete(const Key& key, const RecordID rid)
+{
+	PageID pid;
+	int slot;
+	if (FindEntry(key, &rid, pid, slot) != OK){
+		return FAIL;
+	}
+	LeafPage* leafPage;
+	PIN(pid,leafPage);
+	leafPage->Remove(slot);
+	UNPIN(pid,DIRTY);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::Lookup
+//
+// Input   : key - the key to look up
+// Output  : rid - the record id of the first entry with that key
+// Return  : OK if found, DONE if key is not in the index.
+// Purpose : Point lookup.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+Status
+BTreeFileT<Key, Compare>::Lookup(const Key& key, RecordID& rid)
+{
+	PageID pid;
+	int slot;
+	if (FindEntry(key, nullptr, pid, slot) != OK){
+		return DONE;
+	}
+	LeafPage* leafPage;
+	PIN(pid,leafPage);
+	rid = leafPage->GetEntry(slot)->rid;
+	UNPIN(pid,CLEAN);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::OpenScan
+//
+// Input   : lowKey, highKey - pointer to keys, indicate the range
+//                             to scan; nullptr leaves that end open.
+// Output  : None
+// Return  : A scan returning every entry with lowKey <= key <= highKey
+//           in key order, duplicates included.  The caller deletes it.
+// Purpose : Open a range scan.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+BTreeFileScanT<Key, Compare>*
+BTreeFileT<Key, Compare>::OpenScan(const Key* lowKey, const Key* highKey)
+{
+	Scan* scan = new Scan();
+	scan->btfile = this;
+	scan->hasLow = (lowKey != nullptr);
+	scan->hasHigh = (highKey != nullptr);
+	if (lowKey != nullptr){
+		scan->lowKey = *lowKey;
+	}
+	if (highKey != nullptr){
+		scan->highKey = *highKey;
+	}
+	scan->curPid = FindLeaf(lowKey);
+	scan->slot = -1;
+	scan->scanned = false;
+	return scan;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::FindLeaf
+//
+// Input   : key - the key to search for; nullptr for the smallest
+// Output  : None
+// Return  : the pid of the leftmost leaf that can hold key,
+//           INVALID_PAGE on error.
+// Purpose : Descend from the root.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+PageID
+BTreeFileT<Key, Compare>::FindLeaf(const Key* key)
+{
+	PageID curPid = rootPid;
+	while (curPid != INVALID_PAGE){
+		SortedPage* curPage;
+		if (MINIBASE_BM->PinPage(curPid, (Page *&) curPage) != OK){
+			return INVALID_PAGE;
+		}
+		if (curPage->GetType() != PACKED_INDEX_NODE){
+			MINIBASE_BM->UnpinPage(curPid, CLEAN);
+			return curPid;
+		}
+		IndexPage* indexPage = (IndexPage *) curPage;
+		PageID childPid = indexPage->GetChild((key != nullptr) ? indexPage->FindFirstChildSlot(*key) : 0);
+		MINIBASE_BM->UnpinPage(curPid, CLEAN);
+		curPid = childPid;
+	}
+	return INVALID_PAGE;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeFileT::FindEntry
+//
+// Input   : key - the key to search for
+//           rid - the record id the entry must hold; nullptr for any
+// Output  : pid, slot - where the entry is
+// Return  : OK if found, DONE if not, FAIL on error.
+// Purpose : Walk the run of entries equal to key, which may continue
+//           over several leaves.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+Status
+BTreeFileT<Key, Compare>::FindEntry(const Key& key, const RecordID* rid, PageID& pid, int& slot)
+{
+	pid = FindLeaf(&key);
+	while (pid != INVALID_PAGE){
+		LeafPage* leafPage;
+		PIN(pid,leafPage);
+		int numEntries = leafPage->GetNumOfRecords();
+		for (slot = leafPage->LowerBound(key); slot < numEntries; slot++){
+			typename LeafPage::Entry* entry = leafPage->GetEntry(slot);
+			if (!Equal(entry->key, key)){ //past the run
+				UNPIN(pid,CLEAN);
+				return DONE;
+			}
+			if (rid == nullptr || entry->rid == *rid){
+				UNPIN(pid,CLEAN);
+				return OK;
+			}
+		}
+		PageID nextPid = leafPage->GetNextPage();
+		UNPIN(pid,CLEAN);
+		pid = nextPid;
+	}
+	return DONE;
+}
+
+#endif // _BTFILE_T_H
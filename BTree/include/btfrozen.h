@@ -0,0 +1,78 @@
+#ifndef _BTFROZEN_H
+#define _BTFROZEN_H
+
+#include <vector>
+
+#include "minirel.h"
+#include "sortedpage.h"
+#include "bt.h"
+
+
+// A page of a frozen B+ tree.  The entries are packed into the data
+// area as a byte stream: the key as a delta from the previous key, the
+// record page as a zigzag delta from the previous record page and the
+// slot, each as a varint.  Dense keys and clustered record ids take a
+// few bytes per entry instead of sizeof(LeafEntry) plus a slot.  The
+// page is only ever appended to while the tree is frozen and read
+// afterwards.
+
+class BTFrozenPage : public SortedPage {
+
+public:
+
+	void InitFrozen(PageID pageNo);
+	bool Append(const int key, const RecordID rid);
+	void Decode(std::vector<LeafEntry>& entries);
+	Status Find(const int key, RecordID& rid);
+
+	int GetNumOfEntries() { return Header()->numEntries; }
+	int GetFirstKey() { return Header()->firstKey; }
+	int GetLastKey() { return Header()->lastKey; }
+	int GetUsedBytes() { return Header()->used; }
+
+private:
+
+	struct FrozenHeader {
+		long long lastRidPage;	// 64 bits, so the format does not depend on sizeof(PageID)
+		int numEntries;
+		int firstKey;
+		int lastKey;
+		int used;			// bytes of data taken by the header and the stream
+	};
+
+	FrozenHeader* Header() { return (FrozenHeader *) data; }
+};
+
+
+//-------------------------------------------------------------------
+// BTFrozenDirectory
+//
+// The in-memory top level of a frozen tree: the first key of every
+// frozen page, in page order.  It replaces the index pages, so a
+// lookup pins the one page its key is on.
+//-------------------------------------------------------------------
+
+class BTFrozenDirectory {
+
+public:
+
+	void Add(const int firstKey, const int lastKey, const PageID pid);
+	PageID Find(const int key);
+	PageID FindAny(const int key);
+
+	PageID GetFirstPid() { return pids.front(); }
+	PageID GetLastPid() { return pids.back(); }
+	int GetFirstKey() { return firstKeys.front(); }
+	int GetFirstKey(int i) { return firstKeys[i]; }
+	int GetLastKey() { return lastKey; }
+	int GetNumOfPages() { return (int) pids.size(); }
+	PageID GetPid(int i) { return pids[i]; }
+
+private:
+
+	std::vector<int> firstKeys;
+	std::vector<PageID> pids;
+	int lastKey;
+};
+
+#endif // _BTFROZEN_H
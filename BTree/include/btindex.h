@@ -29,6 +29,8 @@ public:
 	Status FindPageWithKey(const int d_key,int& key, PageID& pid, RecordID& rid);   
 	Status FindPageWithKeys(const int d_key, int& key,int& nextKey, PageID& pid, PageID& prevPid, PageID& nextPid, RecordID& rid);
 	Status GetLast(int& key, PageID& pid, RecordID& rid);
+	int FindChildSlot(const int key);
+	PageID GetChild(int childSlot);
 
 	IndexEntry* GetEntry(int slotNo) 
 	{
@@ -39,6 +41,17 @@ public:
 	{
 		return (AvailableSpace() <= (HEAPPAGE_DATA_SIZE) / 2);
 	}
+	bool CanAbsorb(BTIndexPage* page)
+	{
+		// true if all the entries of page and the separator pulled down
+		// from the parent fit into this page
+		return (page->GetNumOfRecords() + 1) * (int) (sizeof(IndexEntry) + sizeof(Slot)) <= AvailableSpace() + (int) sizeof(Slot);
+	}
+	int GetMaxNumOfRecords()
+	{
+		// upper bound on the entries a page holds, the first slot is in the header
+		return HEAPPAGE_DATA_SIZE / (int) (sizeof(IndexEntry) + sizeof(Slot)) + 1;
+	}
 	bool IsAtLeastHalfFullAfterDelete(){
 		if (! IsAtLeastHalfFull() ){
 			return false;
@@ -48,11 +61,9 @@ public:
 		RecordID rid_tmp;
 		GetFirst(key_tmp,pid_tmp,rid_tmp);
 		Delete(key_tmp,rid_tmp);
-		if (! IsAtLeastHalfFull ()){
-			return false;
-		}
-		Insert(key_tmp,pid_tmp,rid_tmp);
-		return true;
+		bool halfFull = IsAtLeastHalfFull();
+		Insert(key_tmp,pid_tmp,rid_tmp); //put the entry back either way
+		return halfFull;
 	}
 };
 
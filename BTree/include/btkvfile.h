@@ -0,0 +1,53 @@
+#ifndef _BTKVFILE_H
+#define _BTKVFILE_H
+
+#include "btindex.h"
+#include "btkvleaf.h"
+#include "bt.h"
+
+class BTreeKVFileScan;
+
+//-------------------------------------------------------------------
+// BTreeKVFile
+//
+// A B+ tree used as a key-value store for small values.  The index
+// pages are the ones of BTreeFile; the leaves store every value inline
+// next to its key (BTKVLeafPage), so a lookup reads the value from the
+// leaf instead of following a record id into a heap file.  Keys are
+// unique: Put replaces the value of an existing key.
+//
+// Delete does not merge or redistribute leaves.  A leaf may become
+// empty; it stays in the leaf chain and refills on later inserts.
+//-------------------------------------------------------------------
+
+class BTreeKVFile {
+
+public:
+
+	friend class BTreeKVFileScan;
+
+	BTreeKVFile(Status& status, const char* filename);
+	~BTreeKVFile();
+
+	Status DestroyFile();
+
+	Status Put(const int key, const char* value, const int len);
+	Status Get(const int key, char* value, int& len);
+	Status Delete(const int key);
+
+	BTreeKVFileScan* Scan(const int* lowKey, const int* highKey);
+
+private:
+
+	PageID rootPid;
+	const char* fname;
+
+	Status SetRoot(PageID pid);
+	Status DestroyFileHelper(PageID curPid);
+	Status PutHelper(const int key, const char* value, const int len, PageID curPid, bool& split, int& child_key, PageID& child_pageid);
+	Status SplitLeaf(BTKVLeafPage* oldPage, BTKVLeafPage* newPage);
+	Status SplitIndex(BTIndexPage* oldPage, BTIndexPage* newPage, int& upKey);
+	PageID FindLeaf(const int key);
+};
+
+#endif // _BTKVFILE_H
@@ -0,0 +1,27 @@
+#ifndef _BTKVFILE_SCAN_H
+#define _BTKVFILE_SCAN_H
+
+#include "btkvfile.h"
+
+class BTreeKVFileScan {
+
+public:
+
+	friend class BTreeKVFile;
+
+	Status GetNext(int& key, char* value, int& len);
+
+	~BTreeKVFileScan() {}
+
+private:
+	BTreeKVFile* kvfile;
+	PageID curPid;
+	int lowKey;
+	int highKey;
+	bool hasHigh;		// highKey is set, otherwise the scan is open ended
+	int lastKey;
+	bool scanned;		// lastKey is valid
+	Status s;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef BTKVLEAF_PAGE_H
+#define BTKVLEAF_PAGE_H
+
+#include "minirel.h"
+#include "page.h"
+#include "sortedpage.h"
+#include "bt.h"
+
+
+// A leaf of a BTreeKVFile.  Every record is the key followed by the
+// value bytes, so the length of the value is the length of the record
+// minus the key.  The key comes first, which keeps the records sorted
+// by SortedPage::InsertRecord.
+
+class BTKVLeafPage : public SortedPage {
+
+public:
+
+	Status Insert(const int key, const char* value, const int len, RecordID& rid);
+	Status Delete(const int key, RecordID& rid);
+	int FindSlot(const int key, int fromSlot = 0);
+
+	int GetKey(int slotNo)
+	{
+		return *(int *)(data + slots[slotNo].offset);
+	}
+	const char* GetValue(int slotNo, int& len)
+	{
+		len = slots[slotNo].length - (int) sizeof(int);
+		return data + slots[slotNo].offset + sizeof(int);
+	}
+	bool HasSpaceFor(const int len)
+	{
+		return AvailableSpace() >= (int) sizeof(int) + len;
+	}
+	int UsedSpace()
+	{
+		return HEAPPAGE_DATA_SIZE + (int) sizeof(Slot) - freeSpace;
+	}
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef _BTLATCH_H
+#define _BTLATCH_H
+
+#include <atomic>
+#include <vector>
+
+#include "minirel.h"
+#include "page.h"
+
+// Modes a page is latched in by BTreeFile::PinLatched.
+enum BTLatchMode { BT_LATCH_NONE, BT_LATCH_SHARED, BT_LATCH_EXCLUSIVE };
+
+//-------------------------------------------------------------------
+// BTLatch
+//
+// A reader/writer spin latch for short critical sections.  A waiting
+// writer holds new readers back, so a stream of readers cannot starve
+// it.  Waiters yield the CPU between attempts.
+//
+// The latch also carries a version, odd while a writer holds it and
+// bumped again on release, for optimistic readers that do not lock at
+// all: they take ReadVersion, read, and call Validate, and if that
+// fails a writer was there in between and they read again.  Such
+// readers write nothing, so they do not bounce the latch's cache line
+// between cores.  Bump moves the version on without the latch, for a
+// writer that changed what it guards under other latches.
+//-------------------------------------------------------------------
+
+class BTLatch {
+
+public:
+
+	BTLatch() : state(0), waitingWriters(0), version(0) {}
+
+	void LockShared();
+	void UnlockShared() { state.fetch_sub(1, std::memory_order_release); }
+	void LockExclusive();
+	void UnlockExclusive()
+	{
+		version.fetch_add(1, std::memory_order_release);
+		state.store(0, std::memory_order_release);
+	}
+
+	unsigned int ReadVersion();
+	void Bump() { version.fetch_add(2, std::memory_order_release); }
+	bool Validate(const unsigned int v)
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return version.load(std::memory_order_relaxed) == v;
+	}
+
+	void Lock(const bool exclusive) { if (exclusive) LockExclusive(); else LockShared(); }
+	void Unlock(const bool exclusive) { if (exclusive) UnlockExclusive(); else UnlockShared(); }
+
+private:
+
+	std::atomic<int> state;				// number of readers, -1 while a writer holds it
+	std::atomic<int> waitingWriters;
+	std::atomic<unsigned int> version;	// odd while held exclusively
+
+	BTLatch(const BTLatch&);
+	BTLatch& operator=(const BTLatch&);
+};
+
+
+//-------------------------------------------------------------------
+// BTLatchTable
+//
+// The latches of a BTreeFile shared by several threads: one latch per
+// page of the database, indexed by pid, and a latch over the structure
+// of the whole tree.
+//
+// Page latches protect page contents.  Writers take them exclusively,
+// on the one leaf they change or, for a split or merge, on every page
+// it writes (see BTreeFile::LatchPath), and hold the tree latch shared;
+// the tree latch is only taken exclusively to create the root or to
+// sweep every leaf.  Every split or merge bumps the tree version before
+// its page latches are released.  Readers never latch: they validate
+// the versions of the pages they read and of the tree latch instead.
+//-------------------------------------------------------------------
+
+class BTLatchTable {
+
+public:
+
+	BTLatchTable(const int numPages) : pages(numPages) {}
+
+	BTLatch& GetTreeLatch() { return tree; }
+	BTLatch& GetPageLatch(const PageID pid) { return pages[pid]; }
+
+private:
+
+	BTLatch tree;
+	std::vector<BTLatch> pages;
+};
+
+#endif // _BTLATCH_H
@@ -24,6 +24,7 @@ public:
 	Status GetCurrent(int& key, RecordID& dataRid, RecordID rid);
 	Status GetLast(int& key, RecordID& dataRid, RecordID& rid);
 	Status FindAndRemove (int key, RecordID dataRid);
+	int FindSlot(const int key, int fromSlot = 0);
 	LeafEntry* GetEntry(int slotNo)
 	{
 		return (LeafEntry *)(data + slots[slotNo].offset);
@@ -33,6 +34,16 @@ public:
 	{
 		return (AvailableSpace() <= (HEAPPAGE_DATA_SIZE) / 2);
 	}
+	bool CanAbsorb(BTLeafPage* page)
+	{
+		// true if all the entries of page fit into this page
+		return page->GetNumOfRecords() * (int) (sizeof(LeafEntry) + sizeof(Slot)) <= AvailableSpace() + (int) sizeof(Slot);
+	}
+	int GetMaxNumOfRecords()
+	{
+		// upper bound on the entries a page holds, the first slot is in the header
+		return HEAPPAGE_DATA_SIZE / (int) (sizeof(LeafEntry) + sizeof(Slot)) + 1;
+	}
 	bool IsAtLeastHalfFullAfterDelete(){
 		if (! IsAtLeastHalfFull() ){
 			return false;
@@ -41,11 +52,9 @@ public:
 		RecordID dataRid_tmp,rid_tmp;
 		GetFirst(key_tmp,dataRid_tmp,rid_tmp);
 		Delete(key_tmp,dataRid_tmp,rid_tmp);
-		if (! IsAtLeastHalfFull ()){
-			return false;
-		}
-		Insert(key_tmp,dataRid_tmp,rid_tmp);
-		return true;
+		bool halfFull = IsAtLeastHalfFull();
+		Insert(key_tmp,dataRid_tmp,rid_tmp); //put the entry back either way
+		return halfFull;
 	}
 };
 
@@ -0,0 +1,66 @@
+#ifndef _BTLEARNED_H
+#define _BTLEARNED_H
+
+#include <vector>
+
+#include "minirel.h"
+
+// Largest distance, in leaves, between the position the model predicts
+// for a leaf boundary and its real position.
+const int BT_LEARNED_ERROR = 8;
+
+//-------------------------------------------------------------------
+// BTLearnedRouter
+//
+// Routes a key straight to its leaf without reading index pages.  The
+// router keeps the lowest key routed to every leaf, in leaf order, and
+// a piecewise-linear model of key -> position in that list in which
+// every boundary is predicted within BT_LEARNED_ERROR.  A lookup
+// evaluates one segment and binary searches the small window around
+// the prediction.
+//
+// A leaf split adds one boundary and refits only the segment it falls
+// in.  Any other change to the boundaries (redistribution, merge)
+// leaves the router behind the tree's structure version, and the tree
+// rebuilds it before the next use.
+//-------------------------------------------------------------------
+
+class BTLearnedRouter {
+
+public:
+
+	BTLearnedRouter() : version(0), valid(false) {}
+
+	void Build(const std::vector<int>& lowKeys, const std::vector<PageID>& pids, const unsigned int version);
+	void OnSplit(const PageID oldPid, const int newLowKey, const PageID newPid, const unsigned int version);
+	PageID Route(const int key);
+	void Clear() { valid = false; }
+
+	bool IsCurrent(const unsigned int version) { return valid && this->version == version; }
+	int GetNumLeaves() { return (int) lowKeys.size(); }
+	int GetNumSegments() { return (int) segments.size(); }
+
+private:
+
+	struct Segment {
+		int firstKey;	// lowKeys[start]
+		int start;		// first boundary covered by the segment
+		double slope;	// predicted position is start + slope * (key - firstKey)
+	};
+
+	std::vector<int> lowKeys;		// lowest key routed to each leaf, sorted
+	std::vector<PageID> pids;		// pids[i] is the leaf starting at lowKeys[i]
+	std::vector<Segment> segments;
+	unsigned int version;			// structure version the router matches
+	bool valid;
+
+	void Fit(const int from, const int to, std::vector<Segment>& out);
+	int Position(const int key);
+	int SegmentOf(const int key);
+	int SegmentEnd(const int seg)
+	{
+		return (seg + 1 < (int) segments.size()) ? segments[seg + 1].start : (int) lowKeys.size();
+	}
+};
+
+#endif // _BTLEARNED_H
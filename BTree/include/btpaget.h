@@ -0,0 +1,202 @@
+#ifndef BTPAGE_T_H
+#define BTPAGE_T_H
+
+#include <functional>
+#include <string.h>
+
+#include "minirel.h"
+#include "page.h"
+#include "sortedpage.h"
+#include "bt.h"
+
+
+// A fixed-width byte string key.  Keys compare byte by byte, as
+// memcmp does, so the order is the order of the unsigned bytes.
+
+template <int N>
+struct FixedKey {
+	unsigned char bytes[N];
+
+	bool operator<(const FixedKey& other) const { return memcmp(bytes, other.bytes, N) < 0; }
+	bool operator==(const FixedKey& other) const { return memcmp(bytes, other.bytes, N) == 0; }
+};
+
+
+//-------------------------------------------------------------------
+// BTLeafPageT
+//
+// A leaf of a BTreeFileT.  The entries have a fixed size for a given
+// Key, so instead of a slot directory the data area is one array of
+// entries kept in Compare order; the header's slot count is the number
+// of entries.  Searches are binary searches with Compare inlined.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+class BTLeafPageT : public SortedPage {
+
+public:
+
+	typedef LeafEntryT<Key> Entry;
+
+	static const int CAPACITY = HEAPPAGE_DATA_SIZE / (int) sizeof(Entry);
+
+	void InitLeaf(PageID pageNo)
+	{
+		Init(pageNo);
+		SetType(PACKED_LEAF_NODE);
+		SetPrevPage(INVALID_PAGE);
+		SetNextPage(INVALID_PAGE);
+		numOfSlots = 0;
+	}
+
+	Entry* GetEntry(int slotNo) { return (Entry *) data + slotNo; }
+	bool IsFull() { return numOfSlots >= CAPACITY; }
+
+	// first slot whose key is not less than key
+	int LowerBound(const Key& key)
+	{
+		Compare less;
+		int lo = 0, hi = numOfSlots;
+		while (lo < hi)
+		{
+			int mid = (lo + hi) / 2;
+			if (less(GetEntry(mid)->key, key))
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	// first slot whose key is greater than key
+	int UpperBound(const Key& key)
+	{
+		Compare less;
+		int lo = 0, hi = numOfSlots;
+		while (lo < hi)
+		{
+			int mid = (lo + hi) / 2;
+			if (less(key, GetEntry(mid)->key))
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		return lo;
+	}
+
+	// insert after the entries with an equal key, the page must not be full
+	void Insert(const Key& key, const RecordID rid)
+	{
+		int slot = UpperBound(key);
+		memmove(GetEntry(slot + 1), GetEntry(slot), (numOfSlots - slot) * sizeof(Entry));
+		GetEntry(slot)->key = key;
+		GetEntry(slot)->rid = rid;
+		numOfSlots++;
+	}
+
+	void Remove(int slotNo)
+	{
+		memmove(GetEntry(slotNo), GetEntry(slotNo + 1), (numOfSlots - slotNo - 1) * sizeof(Entry));
+		numOfSlots--;
+	}
+
+	// move the upper half of the entries to the empty page right
+	void MoveUpperHalf(BTLeafPageT* right)
+	{
+		int keep = numOfSlots / 2;
+		memcpy(right->GetEntry(0), GetEntry(keep), (numOfSlots - keep) * sizeof(Entry));
+		right->numOfSlots = numOfSlots - keep;
+		numOfSlots = keep;
+	}
+};
+
+
+//-------------------------------------------------------------------
+// BTIndexPageT
+//
+// An index page of a BTreeFileT, laid out like BTLeafPageT.  As in
+// BTIndexPage the left link is kept in prevPage, and child slot 0 is
+// the left link, child slot i the pid of entry i-1.
+//-------------------------------------------------------------------
+
+template <class Key, class Compare>
+class BTIndexPageT : public SortedPage {
+
+public:
+
+	typedef IndexEntryT<Key> Entry;
+
+	static const int CAPACITY = HEAPPAGE_DATA_SIZE / (int) sizeof(Entry);
+
+	void InitIndex(PageID pageNo, PageID leftLink)
+	{
+		Init(pageNo);
+		SetType(PACKED_INDEX_NODE);
+		SetNextPage(INVALID_PAGE);
+		SetPrevPage(leftLink);
+		numOfSlots = 0;
+	}
+
+	Entry* GetEntry(int slotNo) { return (Entry *) data + slotNo; }
+	bool IsFull() { return numOfSlots >= CAPACITY; }
+	PageID GetLeftLink() { return prevPage; }
+	void SetLeftLink(PageID left) { prevPage = left; }
+	PageID GetChild(int childSlot) { return (childSlot == 0) ? prevPage : GetEntry(childSlot - 1)->pid; }
+
+	// the child an insert of key goes to: equal keys go right
+	int FindChildSlot(const Key& key)
+	{
+		Compare less;
+		int lo = 0, hi = numOfSlots;
+		while (lo < hi)
+		{
+			int mid = (lo + hi) / 2;
+			if (less(key, GetEntry(mid)->key))
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		return lo;
+	}
+
+	// the leftmost child that can hold key: a run of equal keys may
+	// start left of the separator that equals it
+	int FindFirstChildSlot(const Key& key)
+	{
+		Compare less;
+		int lo = 0, hi = numOfSlots;
+		while (lo < hi)
+		{
+			int mid = (lo + hi) / 2;
+			if (less(GetEntry(mid)->key, key))
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		return lo;
+	}
+
+	// insert the separator of a new child, the page must not be full
+	void Insert(const Key& key, const PageID pid)
+	{
+		int slot = FindChildSlot(key);
+		memmove(GetEntry(slot + 1), GetEntry(slot), (numOfSlots - slot) * sizeof(Entry));
+		GetEntry(slot)->key = key;
+		GetEntry(slot)->pid = pid;
+		numOfSlots++;
+	}
+
+	// move the entries above the middle one to the empty page right;
+	// the middle entry moves up, its pid becomes the left link of right
+	void MoveUpperHalf(BTIndexPageT* right, Key& upKey)
+	{
+		int mid = numOfSlots / 2;
+		memcpy(right->GetEntry(0), GetEntry(mid + 1), (numOfSlots - mid - 1) * sizeof(Entry));
+		right->numOfSlots = numOfSlots - mid - 1;
+		right->SetLeftLink(GetEntry(mid)->pid);
+		upKey = GetEntry(mid)->key;
+		numOfSlots = mid;
+	}
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef _BTRANGE_H
+#define _BTRANGE_H
+
+#include <climits>
+#include <vector>
+
+#include "minirel.h"
+#include "btfile.h"
+
+//-------------------------------------------------------------------
+// BTreeRange
+//
+// A range of a BTreeFile for range-for loops:
+//
+//     for (const LeafEntry& e : BTreeRange(file, &low, &high)) ...
+//
+// It is the stack-allocated counterpart of OpenScan.  The per-entry
+// step is inline: a slot increment and a compare against the high key,
+// with no virtual call and no Status.  Moving to the next leaf is in
+// src/btrange.cpp.  Unlike BTreeFileScan it returns every entry,
+// duplicates included, and has no residual predicates.
+//
+// Without concurrency the iterator keeps the current leaf pinned and
+// reads it in place, and the tree must not be updated while an
+// iterator is alive.  With concurrency on it reads each leaf
+// optimistically into a copy, as BTreeFileScan::GetNext does, and
+// starts over from the last key returned when a writer got in the
+// way, so other threads may update the tree meanwhile.  Frozen leaves
+// are decoded into the copy as well.
+//-------------------------------------------------------------------
+
+class BTreeRange {
+
+public:
+
+	class Iterator {
+
+	public:
+
+		Iterator() : file(nullptr), pid(INVALID_PAGE), leaf(nullptr), slot(0), numEntries(0), highKey(INT_MAX),
+			copied(false), treeVersion(0), nextPid(INVALID_PAGE), lastKey(0) {}
+		Iterator(Iterator&& other) : pid(INVALID_PAGE), copied(false)
+		{
+			*this = std::move(other);
+		}
+		Iterator& operator=(Iterator&& other);
+		Iterator(const Iterator&) = delete;
+		Iterator& operator=(const Iterator&) = delete;
+		~Iterator() { Release(); }
+
+		const LeafEntry& operator*() const { return copied ? entries[slot] : *leaf->GetEntry(slot); }
+		const LeafEntry* operator->() const { return &**this; }
+
+		Iterator& operator++()
+		{
+			if (++slot >= numEntries)
+			{
+				NextLeaf();
+			}
+			else if ((**this).key > highKey)
+			{
+				Release();
+			}
+			return *this;
+		}
+
+		bool operator==(const Iterator& other) const
+		{
+			return pid == other.pid && (pid == INVALID_PAGE || slot == other.slot);
+		}
+		bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+	private:
+
+		friend class BTreeRange;
+
+		BTreeFile* file;
+		PageID pid;						// current leaf, INVALID_PAGE at the end; pinned unless copied
+		BTLeafPage* leaf;
+		int slot;
+		int numEntries;
+		int highKey;
+		bool copied;					// the entries are read from entries, not from the leaf
+		std::vector<LeafEntry> entries;
+		unsigned int treeVersion;		// tree version the copy was read at
+		PageID nextPid;					// the leaf after the copied one
+		int lastKey;					// key of the last copied entry
+		std::vector<RecordID> lastKeyRids;	// record ids of the entries with lastKey copied so far
+
+		void Start(const int* lowKey);
+		bool Load(const PageID next);
+		void NextLeaf();
+		void Copy(PageID first, const bool refind);
+		PageID FindFirstLeaf(const int key);
+		void Release();
+	};
+
+	BTreeRange(BTreeFile& file, const int* lowKey = nullptr, const int* highKey = nullptr)
+		: file(file), hasLow(lowKey != nullptr), lowKey(hasLow ? *lowKey : 0), highKey(highKey != nullptr ? *highKey : INT_MAX) {}
+
+	Iterator begin();
+	Iterator end() { return Iterator(); }
+
+private:
+
+	BTreeFile& file;
+	bool hasLow;
+	int lowKey;
+	int highKey;
+};
+
+#endif // _BTRANGE_H
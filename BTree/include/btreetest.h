@@ -9,7 +9,40 @@ public:
 	void destroyIndex(BTreeFile* btf, const char* name);
 	void insertHighLow(BTreeFile* btf, int low, int high);
 	void scanHighLow(BTreeFile* btf, int low, int high);
+	void lookupHighLow(BTreeFile* btf, int low, int high);
 	void deleteScanHighLow(BTreeFile* btf, int low, int high);
 	void deleteHighLow(BTreeFile* btf, int low, int high);
 
+	void runCheck(const char* name);
+	void checkLookupBatch();
+	void checkPredicates();
+	void checkUpdateRids();
+	void checkSeek();
+	void checkAdaptiveHash();
+	void checkLearnedRouting();
+	void checkKVFile();
+	void checkFreeze();
+	void checkCrackFile();
+	void checkRemapRids();
+	void checkReorganize();
+	void checkMergeFrom();
+	void checkSample();
+	void checkTemplate();
+	void checkComposite();
+	void checkFrozenRids();
+	void checkRange();
+	void checkSwizzle();
+	void checkCSBTree();
+	void checkLatching();
+	void checkOptimisticReads();
+	void checkBufferPool();
+	void checkParallelScan();
+	void checkCreateIndex();
+	void checkPartitioned();
+
+private:
+
+	int failures;		// failed checks of the running check
+	ostream* report;	// where check results go; cout is muted meanwhile
+
 };
@@ -0,0 +1,74 @@
+#ifndef _BTSWIZZLE_H
+#define _BTSWIZZLE_H
+
+#include <vector>
+
+#include "minirel.h"
+#include "btindex.h"
+
+// Default number of index pages a BTreeFile keeps swizzled.  Every one
+// of them holds a frame of the buffer pool for as long as it stays.
+const int BT_SWIZZLE_MAX_PAGES = 32;
+
+//-------------------------------------------------------------------
+// BTSwizzleTable
+//
+// Main-memory mode for the hot index pages of a BTreeFile.  An index
+// page is swizzled the first time a descent reaches it: the table
+// pins it once, for good, and remembers its frame, so later descents
+// go from a child pid to the page with one array load instead of a
+// PinPage/UnpinPage pair through the buffer manager's hash table.
+// Since the upper levels are on every path, they are the first pages
+// taken, and once the table holds maxPages pages the rest are read
+// the usual way.
+//
+// The child pids stay 4-byte PageIDs on the pages, so the frames are
+// kept in a side table indexed by pid.  A page cannot be evicted
+// while the table pins it; to give it up the table unswizzles it,
+// which drops the table's pin.  Clear must be called before any page
+// of the tree is freed, as a pinned page cannot be.
+//
+// Pids found to be leaves are remembered too, so a descent stops at
+// its leaf without pinning it just to read the page type.
+//-------------------------------------------------------------------
+
+class BTSwizzleTable {
+
+public:
+
+	BTSwizzleTable(const int maxPages) : maxPages(maxPages), hits(0) {}
+	~BTSwizzleTable() { Clear(); }
+
+	// the frame of a swizzled index page, nullptr if pid is not one
+	BTIndexPage* Get(const PageID pid)
+	{
+		if (pid >= 0 && pid < (PageID) kinds.size() && kinds[pid] == SWIZZLED)
+		{
+			hits++;
+			return frames[pid];
+		}
+		return nullptr;
+	}
+
+	Status Resolve(const PageID pid, BTIndexPage*& indexPage, bool& isLeaf, bool& mustUnpin);
+	Status Unswizzle(const PageID pid);
+	Status Clear();
+
+	int GetNumOfPages() { return (int) swizzled.size(); }
+	int GetMaxPages() { return maxPages; }
+	long GetHits() { return hits; }
+
+private:
+
+	enum Kind { UNKNOWN = 0, SWIZZLED, LEAF };
+
+	std::vector<char> kinds;			// Kind of every pid seen, indexed by pid
+	std::vector<BTIndexPage*> frames;	// frame of every swizzled pid
+	std::vector<PageID> swizzled;		// the pids holding a pin of the table
+	int maxPages;
+	long hits;							// descent steps served from the table
+
+	void Grow(const PageID pid);
+};
+
+#endif // _BTSWIZZLE_H
@@ -0,0 +1,102 @@
+#ifndef _CBUFMGR_H
+#define _CBUFMGR_H
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "minirel.h"
+#include "page.h"
+
+// Default number of frames of a ConcurrentBufMgr.  Each one holds a
+// frame of the global buffer pool while it is filled.
+const int CBM_NUM_FRAMES = 64;
+
+// Number of partitions of the page table.
+const int CBM_NUM_PARTITIONS = 32;
+
+// Number of statistics slots; threads past this many share slots.
+const int CBM_NUM_STAT_SLOTS = 64;
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr
+//
+// A buffer pool for threads that pin and unpin pages at the same time.
+// The page table is split by pid into partitions, each under its own
+// latch, so threads working on different pages rarely meet.  The pin
+// counts, reference and dirty bits of the frames are atomics, and the
+// clock hand is a counter each sweeping thread advances by itself: a
+// sweep takes no latch until it has found a frame to claim.  Pins and
+// misses are counted in one slot per thread and only added up by
+// GetStat.
+//
+// The frames are borrowed from the global buffer manager, which is
+// not thread-safe.  A frame is filled by pinning its page there and
+// given back by unpinning it, both under the base latch (LockBase),
+// so the pool and code calling MINIBASE_BM directly work on the same
+// copy of a page.  Only misses, NewPage and FreePage take the base
+// latch.  A page the pool holds cannot be freed through MINIBASE_BM;
+// FreePage drops it from the pool first, and FlushAllPages gives back
+// every frame that is not pinned.
+//-------------------------------------------------------------------
+
+class ConcurrentBufMgr {
+
+public:
+
+	ConcurrentBufMgr(const int numFrames);
+	~ConcurrentBufMgr() { FlushAllPages(); }
+
+	Status PinPage(const PageID pid, Page*& page, const bool emptyPage = false);
+	Status UnpinPage(const PageID pid, const int dirty);
+	Status NewPage(PageID& firstPid, Page*& firstPage, const int howMany = 1);
+	Status FreePage(const PageID pid);
+	Status FlushAllPages();
+
+	Status GetStat(long& pinNo, long& missNo);
+	void ResetStat();
+	int GetNumOfFrames() { return numFrames; }
+
+	static void LockBase();
+	static void UnlockBase();
+
+private:
+
+	// pid and data only change while the frame is claimed (pinCount
+	// -1), and are published through the page table
+	struct PoolFrame {
+		PageID pid;						// INVALID_PAGE when empty
+		Page* data;
+		std::atomic<int> pinCount;		// -1 while claimed by a sweep
+		std::atomic<bool> referenced;
+		std::atomic<bool> dirty;
+	};
+
+	struct Partition {
+		std::mutex latch;
+		std::unordered_map<PageID, int> table;	// pid -> frame
+	};
+
+	struct StatSlot {
+		std::atomic<long> pins;
+		std::atomic<long> misses;
+		char pad[64 - 2 * sizeof(std::atomic<long>)];	// one cache line per slot
+	};
+
+	int numFrames;
+	std::vector<PoolFrame> frames;
+	Partition partitions[CBM_NUM_PARTITIONS];
+	std::atomic<unsigned int> hand;
+	StatSlot stats[CBM_NUM_STAT_SLOTS];
+
+	Partition& PartitionOf(const PageID pid) { return partitions[(unsigned int) pid % CBM_NUM_PARTITIONS]; }
+	int ClaimFrame();
+	Status EmptyFrame(PoolFrame& frame);
+	StatSlot& MyStats();
+
+	ConcurrentBufMgr(const ConcurrentBufMgr&);
+	ConcurrentBufMgr& operator=(const ConcurrentBufMgr&);
+};
+
+#endif // _CBUFMGR_H
@@ -0,0 +1,68 @@
+#ifndef _CRACKFILE_H
+#define _CRACKFILE_H
+
+#include <map>
+#include <vector>
+
+#include "minirel.h"
+#include "page.h"
+#include "index.h"
+#include "bt.h"
+
+// Number of (key, RecordID) entries on one page of the cracker column.
+const int CRACK_ENTRIES_PER_PAGE = MAX_SPACE / sizeof(LeafEntry);
+
+class CrackFileScan;
+
+//-------------------------------------------------------------------
+// CrackFile
+//
+// An adaptive index (database cracking).  The entries start out as an
+// unsorted array spread over a list of pages, the cracker column.
+// Every range scan partitions the pieces its bounds fall into, in
+// place, and records the new piece boundaries in the cracker tree, an
+// in-memory map from boundary key to the position where the keys not
+// less than it begin.  The cost of sorting is spread over the queries,
+// and only the key ranges that are queried become ordered.
+//
+// Insert and Delete keep the pieces intact by rippling: one entry per
+// later piece moves to make (or fill) room in the right piece.
+//
+// The cracker tree is in memory only; the index lives as long as the
+// CrackFile object and its pages are freed with it.
+//-------------------------------------------------------------------
+
+class CrackFile : public IndexFile {
+
+public:
+
+	friend class CrackFileScan;
+
+	CrackFile(Status& status);
+	~CrackFile();
+
+	Status DestroyFile();
+
+	Status Insert(const int key, const RecordID rid);
+	Status Delete(const int key, const RecordID rid);
+
+	IndexFileScan* OpenScan(const int* lowKey, const int* highKey);
+
+	int GetNumOfEntries() { return numEntries; }
+	int GetNumOfPieces() { return (int) boundaries.size() + 1; }
+
+private:
+
+	std::vector<PageID> pages;		// the cracker column, in position order
+	int numEntries;
+	std::map<int, int> boundaries;	// cracker tree: key -> first position of keys >= key
+
+	Status Crack(const int key, int& pos);
+	Status Partition(int lo, int hi, const int key, int& split);
+	void PieceOf(const int key, int& lo, int& hi);
+	Status Move(const int from, const int to);
+	Status Read(const int pos, LeafEntry& entry);
+	Status Write(const int pos, const LeafEntry& entry);
+};
+
+#endif // _CRACKFILE_H
@@ -0,0 +1,30 @@
+#ifndef _CRACKFILE_SCAN_H
+#define _CRACKFILE_SCAN_H
+
+#include "crackfile.h"
+
+// A scan of one cracked range of a CrackFile.  The range is a run of
+// pieces, so the entries come back in no particular order.  Changes
+// to the file other than DeleteCurrent invalidate the scan.
+
+class CrackFileScan : public IndexFileScan {
+
+public:
+
+	friend class CrackFile;
+
+	Status GetNext(RecordID& rid, int& key);
+	Status DeleteCurrent();
+
+	~CrackFileScan() {}
+
+private:
+	CrackFile* crackfile;
+	int cur;			// next position to return
+	int end;			// end of the range
+	int lastKey;
+	RecordID lastRid;
+	bool scanned;		// lastKey, lastRid are valid
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef _CSBFILE_H
+#define _CSBFILE_H
+
+#include "minirel.h"
+#include "index.h"
+#include "arena.h"
+
+// Keys of an internal node: the node is one cache line, a key count,
+// the keys and a single pointer to the group of its children.
+const int CSB_INNER_KEYS = (int) ((ARENA_LINE - sizeof(int) - sizeof(void *)) / sizeof(int));
+
+// Cache lines of a leaf, and the entries that fit in them.
+const int CSB_LEAF_LINES = 4;
+const int CSB_LEAF_KEYS = (int) ((CSB_LEAF_LINES * ARENA_LINE - sizeof(int)) / (sizeof(int) + sizeof(RecordID)));
+
+// Deepest tree a scan can walk; a split node keeps half of its
+// children, so this is far beyond any tree that fits in memory.
+const int CSB_MAX_HEIGHT = 16;
+
+struct alignas(ARENA_LINE) CSBInner {
+	int numKeys;
+	int keys[CSB_INNER_KEYS];
+	void* children;				// group of numKeys + 1 nodes, CSBLeaf at height 1, CSBInner above
+};
+
+struct alignas(ARENA_LINE) CSBLeaf {
+	int numKeys;
+	int keys[CSB_LEAF_KEYS];	// keys first, so a search touches only them
+	RecordID rids[CSB_LEAF_KEYS];
+};
+
+class CSBTreeFileScan;
+
+//-------------------------------------------------------------------
+// CSBTreeFile
+//
+// A transient in-memory index for the intermediate results of a query
+// (join build sides, sort runs) that needs neither the buffer pool nor
+// the DB file.  It is a cache-sensitive B+ tree (CSB+ tree): the
+// children of a node are stored next to each other as one node group,
+// so a node keeps a single child pointer and the rest of its cache
+// line holds keys, which gives a fanout of CSB_INNER_KEYS + 1 per
+// line.  Child i of a node is found by arithmetic on that pointer.
+//
+// A split copies the group of the splitting node into a new group one
+// node larger (or two groups, when the parent splits as well).  Leaves
+// are kept in groups too and have no sibling links; scans walk the
+// tree with a stack.  As in BTreeFileT, Delete does not merge nodes.
+//
+// All nodes come from an Arena and are freed together by DestroyFile
+// or by the destructor.
+//-------------------------------------------------------------------
+
+class CSBTreeFile : public IndexFile {
+
+public:
+
+	friend class CSBTreeFileScan;
+
+	CSBTreeFile(Status& status);
+	~CSBTreeFile() {}
+
+	Status DestroyFile();
+
+	Status Insert(const int key, const RecordID rid);
+	Status Delete(const int key, const RecordID rid);
+	Status Lookup(const int key, RecordID& rid);
+
+	IndexFileScan* OpenScan(const int* lowKey, const int* highKey);
+
+	int GetNumOfEntries() { return numEntries; }
+	int GetHeight() { return height; }
+	size_t GetNumOfBytes() { return arena.GetNumOfBytes(); }
+
+private:
+
+	Arena arena;
+	void* root;					// a group of one node, a CSBLeaf while height is 0
+	int height;					// levels of CSBInner nodes above the leaves
+	int numEntries;
+
+	void Init();
+	void InsertHelper(void* node, const int level, const int key, const RecordID rid, bool& split, int& upKey, void* right);
+	void* NewGroup(const void* nodes, const int n, const size_t nodeSize);
+	static size_t NodeSize(const int level) { return level == 0 ? sizeof(CSBLeaf) : sizeof(CSBInner); }
+	static int LowerBound(const int* keys, const int n, const int key);
+	static int UpperBound(const int* keys, const int n, const int key);
+};
+
+#endif // _CSBFILE_H
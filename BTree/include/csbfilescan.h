@@ -0,0 +1,40 @@
+#ifndef _CSBFILE_SCAN_H
+#define _CSBFILE_SCAN_H
+
+#include "csbfile.h"
+
+// A range scan of a CSBTreeFile, in key order.  The scan holds the
+// path to its leaf, so changes to the file other than DeleteCurrent
+// invalidate it.
+
+class CSBTreeFileScan : public IndexFileScan {
+
+public:
+
+	friend class CSBTreeFile;
+
+	Status GetNext(RecordID& rid, int& key);
+	Status DeleteCurrent();
+
+	~CSBTreeFileScan() {}
+
+private:
+
+	struct Level {
+		CSBInner* node;
+		int slot;			// child of node the scan is in
+	};
+
+	CSBTreeFile* csbfile;
+	int highKey;
+	Level path[CSB_MAX_HEIGHT];	// path[0] is the root
+	CSBLeaf* leaf;				// nullptr once the scan is done
+	int slot;					// next slot of leaf
+	bool scanned;				// slot - 1 of leaf is the entry returned last
+
+	CSBTreeFileScan(CSBTreeFile* file, const int* lowKey, const int* highKey);
+	void Descend(int level, const int* lowKey);
+	void NextLeaf();
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef _PARTFILE_H
+#define _PARTFILE_H
+
+#include <string>
+#include <vector>
+
+#include "minirel.h"
+#include "index.h"
+#include "btfile.h"
+
+// Most partitions of a PartitionedBTreeFile.
+const int PART_MAX_PARTITIONS = 64;
+
+// How a PartitionedBTreeFile assigns keys to its partitions.
+enum PartitionKind {
+	PART_HASH,		// by a hash of the key, which spreads runs of close keys
+	PART_RANGE		// by key range, so a scan reads only the partitions it overlaps
+};
+
+class PartitionedBTreeFileScan;
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFile
+//
+// An index split over several independent B+ trees, one BTreeFile per
+// partition, each with its own root, pages and latches.  Every key
+// belongs to exactly one partition, so Insert, Delete and Lookup go to
+// a single tree, and threads updating different partitions never latch
+// the same page.  Hash partitioning also spreads a stream of ascending
+// keys, which would otherwise all go to the rightmost leaf of one
+// tree.  A scan merges the scans of the partitions it overlaps back
+// into key order.
+//
+// Partition i is stored as the B+ tree "<filename>.<i>".  The kind and
+// the bounds are not stored; a file must be reopened with the ones it
+// was created with.  Threads may use the file at the same time once
+// EnableConcurrency is on.
+//-------------------------------------------------------------------
+
+class PartitionedBTreeFile : public IndexFile {
+
+public:
+
+	friend class PartitionedBTreeFileScan;
+
+	PartitionedBTreeFile(Status& status, const char* filename, const int numParts, const PartitionKind kind, const int* bounds = nullptr);
+	~PartitionedBTreeFile();
+
+	Status DestroyFile();
+
+	Status Insert(const int key, const RecordID rid);
+	Status Delete(const int key, const RecordID rid);
+	Status Lookup(const int key, RecordID& rid);
+
+	IndexFileScan* OpenScan(const int* lowKey, const int* highKey);
+
+	void EnableConcurrency(bool enable, const int poolFrames = CBM_NUM_FRAMES);
+
+	int GetNumOfPartitions() { return (int) parts.size(); }
+	int PartitionOf(const int key);
+
+private:
+
+	PartitionKind kind;
+	std::vector<int> bounds;			// PART_RANGE: partition i holds the keys from bounds[i-1] up to but not including bounds[i]
+	std::vector<std::string> names;		// file names of the partitions, which the BTreeFiles point to
+	std::vector<BTreeFile*> parts;
+};
+
+#endif // _PARTFILE_H
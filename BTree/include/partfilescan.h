@@ -0,0 +1,42 @@
+#ifndef _PARTFILE_SCAN_H
+#define _PARTFILE_SCAN_H
+
+#include <vector>
+
+#include "partfile.h"
+
+// A range scan of a PartitionedBTreeFile, in key order: a k-way merge
+// of one BTreeFileScan per partition the range overlaps.  The next
+// entry of every partition scan is kept in a heap; equal keys of
+// different partitions come in partition order.
+
+class PartitionedBTreeFileScan : public IndexFileScan {
+
+public:
+
+	friend class PartitionedBTreeFile;
+
+	Status GetNext(RecordID& rid, int& key);
+	Status DeleteCurrent();
+
+	~PartitionedBTreeFileScan();
+
+private:
+
+	struct Head {
+		int key;
+		RecordID rid;
+		int part;
+	};
+
+	std::vector<IndexFileScan*> scans;	// by partition, nullptr for partitions outside the range
+	std::vector<Head> heap;				// next entry of each partition scan that is not done
+	int current;						// partition of the entry returned last, -1 if none
+	Status s;							// FAIL once a partition scan has failed
+
+	PartitionedBTreeFileScan(PartitionedBTreeFile* file, const int* lowKey, const int* highKey);
+	Status Advance(const int part);
+	static bool After(const Head& a, const Head& b) { return a.key > b.key || (a.key == b.key && a.part > b.part); }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include <stdint.h>
+
+#include "arena.h"
+
+
+//-------------------------------------------------------------------
+// Arena::Allocate
+//
+// Input   : size - bytes needed, at most ARENA_CHUNK_SIZE
+// Output  : None
+// Return  : A block of size bytes, rounded up to whole cache lines
+//           and aligned to a cache line.
+// Purpose : Take a released block of the same size if there is one,
+//           else cut the block from the newest chunk.
+//-------------------------------------------------------------------
+
+void*
+Arena::Allocate(size_t size)
+{
+	size_t lines = (size + ARENA_LINE - 1) / ARENA_LINE;
+	size = lines * ARENA_LINE;
+	numBytes += size;
+	if (lines < freeLists.size() && freeLists[lines] != nullptr)
+	{
+		void* block = freeLists[lines];
+		freeLists[lines] = *(void **) block;
+		return block;
+	}
+	if (next == nullptr || (size_t) (end - next) < size)
+	{
+		char* chunk = new char[ARENA_CHUNK_SIZE + ARENA_LINE];
+		chunks.push_back(chunk);
+		next = chunk + (ARENA_LINE - (uintptr_t) chunk % ARENA_LINE) % ARENA_LINE;
+		end = next + ARENA_CHUNK_SIZE;
+	}
+	void* block = next;
+	next += size;
+	return block;
+}
+
+
+//-------------------------------------------------------------------
+// Arena::Release
+//
+// Input   : block - a block from Allocate
+//           size - the size it was allocated with
+// Output  : None
+// Return  : None
+// Purpose : Keep the block for a later Allocate of the same size.
+//-------------------------------------------------------------------
+
+void
+Arena::Release(void* block, size_t size)
+{
+	size_t lines = (size + ARENA_LINE - 1) / ARENA_LINE;
+	if (lines >= freeLists.size())
+	{
+		freeLists.resize(lines + 1, nullptr);
+	}
+	*(void **) block = freeLists[lines];
+	freeLists[lines] = block;
+	numBytes -= lines * ARENA_LINE;
+}
+
+
+//-------------------------------------------------------------------
+// Arena::Clear
+//
+// Input   : None
+// Output  : None
+// Return  : None
+// Purpose : Free all chunks.  Every block handed out becomes invalid.
+//-------------------------------------------------------------------
+
+void
+Arena::Clear()
+{
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		delete[] chunks[i];
+	}
+	chunks.clear();
+	freeLists.clear();
+	next = nullptr;
+	end = nullptr;
+	numBytes = 0;
+}
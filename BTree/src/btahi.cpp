@@ -0,0 +1,127 @@
+#include "btahi.h"
+
+
+//-------------------------------------------------------------------
+// BTAdaptiveHash::Probe
+//
+// Input   : key - the key to look up
+// Output  : pid, slot - where the key was found the last time
+// Purpose : Look the key up in the hash index.  An entry whose leaf
+//           has changed since it was recorded is removed.
+// Return  : true if a valid entry exists, false otherwise.
+//-------------------------------------------------------------------
+
+bool
+BTAdaptiveHash::Probe(const int key, PageID& pid, int& slot)
+{
+	std::unordered_map<int, Entry>::iterator it = entries.find(key);
+	if (it == entries.end())
+	{
+		misses++;
+		return false;
+	}
+	if (it->second.version != LeafVersion(it->second.pid))
+	{
+		entries.erase(it);
+		misses++;
+		return false;
+	}
+	pid = it->second.pid;
+	slot = it->second.slot;
+	hits++;
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// BTAdaptiveHash::RecordLookup
+//
+// Input   : key - a key found by a full descent
+//           pid, slot - where it was found
+// Output  : None
+// Purpose : Count a lookup of key and, once the key is hot, remember
+//           its position under the current version of the leaf.
+// Return  : None
+//-------------------------------------------------------------------
+
+void
+BTAdaptiveHash::RecordLookup(const int key, const PageID pid, const int slot)
+{
+	if (lookupCounts.size() >= (size_t) AHI_MAX_ENTRIES && lookupCounts.find(key) == lookupCounts.end())
+	{
+		// start counting afresh rather than let cold keys pile up
+		lookupCounts.clear();
+	}
+	if (++lookupCounts[key] < AHI_HOT_THRESHOLD)
+	{
+		return;
+	}
+	if (entries.size() >= (size_t) AHI_MAX_ENTRIES)
+	{
+		entries.clear();
+	}
+	Entry entry;
+	entry.pid = pid;
+	entry.slot = slot;
+	entry.version = LeafVersion(pid);
+	entries[key] = entry;
+}
+
+
+//-------------------------------------------------------------------
+// BTAdaptiveHash::Forget
+//
+// Input   : key - a key whose entry turned out to be wrong
+// Output  : None
+// Purpose : Drop the entry of key.
+// Return  : None
+//-------------------------------------------------------------------
+
+void
+BTAdaptiveHash::Forget(const int key)
+{
+	entries.erase(key);
+}
+
+
+//-------------------------------------------------------------------
+// BTAdaptiveHash::TouchLeaf
+//
+// Input   : pid - a leaf whose entries may have moved
+// Output  : None
+// Purpose : Bump the version of the leaf, which invalidates every
+//           entry recorded on it.
+// Return  : None
+//-------------------------------------------------------------------
+
+void
+BTAdaptiveHash::TouchLeaf(const PageID pid)
+{
+	leafVersions[pid]++;
+}
+
+
+//-------------------------------------------------------------------
+// BTAdaptiveHash::Clear
+//
+// Input   : None
+// Output  : None
+// Purpose : Forget everything, e.g. when the tree is rebuilt.
+// Return  : None
+//-------------------------------------------------------------------
+
+void
+BTAdaptiveHash::Clear()
+{
+	entries.clear();
+	lookupCounts.clear();
+	leafVersions.clear();
+}
+
+
+unsigned int
+BTAdaptiveHash::LeafVersion(const PageID pid)
+{
+	std::unordered_map<PageID, unsigned int>::iterator it = leafVersions.find(pid);
+	return (it == leafVersions.end()) ? 0 : it->second;
+}
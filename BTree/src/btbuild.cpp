@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <string.h>
+#include <thread>
+
+#include "minirel.h"
+#include "bufmgr.h"
+#include "heappage.h"
+#include "btbuild.h"
+
+// Orders entries by key, and equal keys by record id.
+static bool EntryLess(const LeafEntry& a, const LeafEntry& b)
+{
+	return (a.key < b.key) || (a.key == b.key && a.rid < b.rid);
+}
+
+
+//-------------------------------------------------------------------
+// BTParallelBuilder::Build
+//
+// Input   : heapPids - the pages of the heap file
+//           keyOffset - byte offset of the int key within a record
+// Output  : rootPid - the root of the new tree
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Run the four phases.  No page of the new tree is left
+//           behind if the build fails.
+//-------------------------------------------------------------------
+
+Status
+BTParallelBuilder::Build(const std::vector<PageID>& heapPids, const int keyOffset, PageID& rootPid)
+{
+	ConcurrentBufMgr pool(std::max(3 * nThreads, std::min(CBM_NUM_FRAMES, (int) MINIBASE_BM->GetNumOfUnpinnedFrames() / 2)));
+	int numPids = (int) heapPids.size();
+
+	//scan and sort, one share of the heap pages per thread
+	std::vector<std::vector<LeafEntry> > runs(nThreads);
+	std::vector<Status> results(nThreads, OK);
+	std::vector<std::thread> workers;
+	for (int t = 0; t < nThreads; t++){
+		int first = (int) ((long) numPids * t / nThreads);
+		int last = (int) ((long) numPids * (t + 1) / nThreads);
+		workers.push_back(std::thread([&, t, first, last]() {
+			results[t] = ScanRun(pool, heapPids.data() + first, last - first, keyOffset, runs[t]);
+			std::sort(runs[t].begin(), runs[t].end(), EntryLess);
+		}));
+	}
+	for (size_t t = 0; t < workers.size(); t++){
+		workers[t].join();
+	}
+	for (int t = 0; t < nThreads; t++){
+		if (results[t] != OK){
+			return FAIL;
+		}
+	}
+
+	//merge and load, one key range per thread
+	std::vector<int> splitters;
+	ChooseSplitters(runs, splitters);
+	int numRanges = (int) splitters.size() + 1;
+	std::vector<std::unique_ptr<BTBulkLoader> > loaders;
+	for (int r = 0; r < numRanges; r++){
+		Status s;
+		loaders.push_back(std::unique_ptr<BTBulkLoader>(new BTBulkLoader(s, fillFactor, &pool)));
+		if (s != OK){
+			return FAIL;
+		}
+	}
+	results.assign(numRanges, OK);
+	workers.clear();
+	for (int r = 0; r < numRanges; r++){
+		const int* lowKey = (r > 0) ? &splitters[r - 1] : nullptr;
+		const int* highKey = (r < numRanges - 1) ? &splitters[r] : nullptr;
+		workers.push_back(std::thread([&, r, lowKey, highKey]() {
+			results[r] = MergeRange(runs, lowKey, highKey, *loaders[r]);
+		}));
+	}
+	for (size_t r = 0; r < workers.size(); r++){
+		workers[r].join();
+	}
+	for (int r = 0; r < numRanges; r++){
+		if (results[r] != OK){
+			return FAIL;
+		}
+	}
+
+	//join the leaf chains and build the index levels
+	for (int r = 1; r < numRanges; r++){
+		if (loaders[0]->Append(*loaders[r]) != OK){
+			return FAIL;
+		}
+	}
+	return loaders[0]->Finish(rootPid);
+}
+
+
+//-------------------------------------------------------------------
+// BTParallelBuilder::ScanRun
+//
+// Input   : pool - the pool to pin the pages through
+//           pids, numPids - the heap pages of one thread
+//           keyOffset - byte offset of the int key within a record
+// Output  : run - the key and record id of every record, appended
+// Return  : OK if successful, FAIL if a page cannot be pinned or a
+//           record is too short to hold a key.
+// Purpose : Phase 1 for one thread.
+//-------------------------------------------------------------------
+
+Status
+BTParallelBuilder::ScanRun(ConcurrentBufMgr& pool, const PageID* pids, const int numPids, const int keyOffset, std::vector<LeafEntry>& run)
+{
+	for (int i = 0; i < numPids; i++){
+		HeapPage* page;
+		if (pool.PinPage(pids[i], (Page *&) page) != OK){
+			return FAIL;
+		}
+		RecordID rid;
+		Status s = page->FirstRecord(rid);
+		while (s == OK){
+			char* rec;
+			int len;
+			if (page->ReturnRecord(rid, rec, len) != OK || len < keyOffset + (int) sizeof(int)){
+				cerr << "No key in record " << rid << endl;
+				pool.UnpinPage(pids[i], CLEAN);
+				return FAIL;
+			}
+			LeafEntry entry;
+			memcpy(&entry.key, rec + keyOffset, sizeof(int));
+			entry.rid = rid;
+			run.push_back(entry);
+			s = page->NextRecord(rid, rid);
+		}
+		if (pool.UnpinPage(pids[i], CLEAN) != OK || s != DONE){
+			return FAIL;
+		}
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTParallelBuilder::ChooseSplitters
+//
+// Input   : runs - the sorted runs
+// Output  : splitters - at most nThreads - 1 keys, ascending; range r
+//                       holds the keys from splitters[r - 1] up to
+//                       but not including splitters[r]
+// Return  : None
+// Purpose : Cut the key space into ranges of about as many entries
+//           each.  Every run gives keys at evenly spaced positions, as
+//           many per entry it holds, and the splitters are picked
+//           evenly from all of them.
+//-------------------------------------------------------------------
+
+void
+BTParallelBuilder::ChooseSplitters(const std::vector<std::vector<LeafEntry> >& runs, std::vector<int>& splitters)
+{
+	long total = 0;
+	for (size_t t = 0; t < runs.size(); t++){
+		total += runs[t].size();
+	}
+	std::vector<int> samples;
+	for (size_t t = 0; t < runs.size() && total > 0; t++){
+		long size = runs[t].size();
+		long count = BT_BUILD_SAMPLES_PER_RUN * (long) runs.size() * size / total;
+		for (long i = 0; i < count; i++){
+			samples.push_back(runs[t][size * i / count].key);
+		}
+	}
+	std::sort(samples.begin(), samples.end());
+	splitters.clear();
+	for (int r = 1; r < nThreads && !samples.empty(); r++){
+		int key = samples[(size_t) r * samples.size() / nThreads];
+		if (key > samples.front() && (splitters.empty() || key > splitters.back())){
+			splitters.push_back(key);
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------
+// BTParallelBuilder::MergeRange
+//
+// Input   : runs - the sorted runs
+//           lowKey, highKey - the range, lowKey <= key < highKey;
+//                             nullptr leaves that end open
+//           loader - the loader of the range
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Phases 3 and 4 for one thread: merge the part of every
+//           run in the range with a heap of run cursors, and add the
+//           entries to the loader as they come.
+//-------------------------------------------------------------------
+
+Status
+BTParallelBuilder::MergeRange(const std::vector<std::vector<LeafEntry> >& runs, const int* lowKey, const int* highKey, BTBulkLoader& loader)
+{
+	struct Cursor {
+		const LeafEntry* next;
+		const LeafEntry* end;
+	};
+	auto greater = [](const Cursor& a, const Cursor& b) { return EntryLess(*b.next, *a.next); };
+	std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater);
+	auto keyLess = [](const LeafEntry& e, int key) { return e.key < key; };
+	for (size_t t = 0; t < runs.size(); t++){
+		const LeafEntry* begin = runs[t].data();
+		const LeafEntry* end = begin + runs[t].size();
+		Cursor cursor;
+		cursor.next = (lowKey != nullptr) ? std::lower_bound(begin, end, *lowKey, keyLess) : begin;
+		cursor.end = (highKey != nullptr) ? std::lower_bound(begin, end, *highKey, keyLess) : end;
+		if (cursor.next < cursor.end){
+			heap.push(cursor);
+		}
+	}
+	while (!heap.empty()){
+		Cursor cursor = heap.top();
+		heap.pop();
+		if (loader.Add(cursor.next->key, cursor.next->rid) != OK){
+			return FAIL;
+		}
+		if (++cursor.next < cursor.end){
+			heap.push(cursor);
+		}
+	}
+	return OK;
+}
@@ -0,0 +1,545 @@
+#include "minirel.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "new_error.h"
+#include "heappage.h"
+#include "btbulk.h"
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::BTBulkLoader
+//
+// Input   : fillFactor - fraction of a page to fill, in (0, 1]
+//           pool - the pool to pin pages through, nullptr for the
+//                  global buffer manager
+// Output  : status - OK, FAIL if fillFactor is out of range
+// Purpose : Start an empty load.  No page is written before the first
+//           Add.
+//-------------------------------------------------------------------
+
+BTBulkLoader::BTBulkLoader(Status& status, const float fillFactor, ConcurrentBufMgr* pool)
+{
+	this->fillFactor = fillFactor;
+	this->pool = pool;
+	numPages = 0;
+	numEntries = 0;
+	finished = false;
+	leaf = nullptr;
+	leafPid = INVALID_PAGE;
+	lastKey = 0;
+	extentNext = INVALID_PAGE;
+	extentLeft = 0;
+	status = (fillFactor > 0 && fillFactor <= 1) ? OK : FAIL;
+}
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::~BTBulkLoader
+//
+// Input   : None
+// Output  : None
+// Purpose : Free the pages of a load that was not finished.
+//-------------------------------------------------------------------
+
+BTBulkLoader::~BTBulkLoader()
+{
+	Abort();
+}
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::Add
+//
+// Input   : key, rid - the next entry; keys must not decrease
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Append the entry to the current leaf, or start a new leaf
+//           if the current one has reached the fill factor.
+//-------------------------------------------------------------------
+
+Status
+BTBulkLoader::Add(const int key, const RecordID rid)
+{
+	if (finished || (leaf != nullptr && key < lastKey)){
+		return FAIL;
+	}
+	bool full = false;
+	if (leaf != nullptr){
+		int used = HEAPPAGE_DATA_SIZE - leaf->AvailableSpace();
+		full = leaf->AvailableSpace() < (int) sizeof(LeafEntry)
+			|| (used >= fillFactor * HEAPPAGE_DATA_SIZE && key != lastKey); //keep a run of equal keys together
+	}
+	if (leaf == nullptr || full){
+		if (NewLeaf() != OK){
+			return FAIL;
+		}
+		lowKeys.push_back(key);
+	}
+	RecordID rid_tmp;
+	if (leaf->Insert(key, rid, rid_tmp) != OK){
+		return FAIL;
+	}
+	lastKey = key;
+	numEntries++;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::Append
+//
+// Input   : next - a loader of the same pool whose keys all lie above
+//                  those added here
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Take over the leaves of next, as if its entries had been
+//           added here: its leaf chain is linked after the last leaf
+//           of this one, and its current leaf and run of pages become
+//           the ones of this loader.  next is left empty, and is done.
+//           The lowest key of next must be greater than the last key
+//           added here, as a run of equal keys may not span the two.
+//-------------------------------------------------------------------
+
+Status
+BTBulkLoader::Append(BTBulkLoader& next)
+{
+	if (&next == this || finished || next.finished || next.pool != pool){
+		return FAIL;
+	}
+	if (next.leaf == nullptr){ //nothing was added to next
+		next.finished = true;
+		return OK;
+	}
+	if (leaf != nullptr){
+		if (next.lowKeys.front() <= lastKey){
+			return FAIL;
+		}
+		PageID firstPid = next.leafPids.front();
+		BTLeafPage* first = next.leaf;
+		if (firstPid != next.leafPid && PinPage(firstPid, (Page *&) first, false) != OK){
+			return FAIL;
+		}
+		first->SetPrevPage(leafPid);
+		if (firstPid != next.leafPid && UnpinPage(firstPid, DIRTY) != OK){
+			return FAIL;
+		}
+		leaf->SetNextPage(firstPid);
+		if (UnpinPage(leafPid, DIRTY) != OK){
+			return FAIL;
+		}
+		leaf = nullptr;
+		if (FreeExtent() != OK){
+			return FAIL;
+		}
+	}
+	leaf = next.leaf;
+	leafPid = next.leafPid;
+	lastKey = next.lastKey;
+	extentNext = next.extentNext;
+	extentLeft = next.extentLeft;
+	lowKeys.insert(lowKeys.end(), next.lowKeys.begin(), next.lowKeys.end());
+	leafPids.insert(leafPids.end(), next.leafPids.begin(), next.leafPids.end());
+	numPages += next.numPages;
+	numEntries += next.numEntries;
+
+	next.leaf = nullptr;
+	next.leafPid = INVALID_PAGE;
+	next.extentLeft = 0;
+	next.lowKeys.clear();
+	next.leafPids.clear();
+	next.numPages = 0;
+	next.numEntries = 0;
+	next.finished = true;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::Finish
+//
+// Input   : None
+// Output  : rootPid - the root of the loaded tree
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Write out the last leaf, give back the unused pages of the
+//           last run and build the index levels one above the other
+//           until a single page is left.  That page is the root; it is
+//           a leaf if all entries fit on one.
+//-------------------------------------------------------------------
+
+Status
+BTBulkLoader::Finish(PageID& rootPid)
+{
+	if (finished){
+		return FAIL;
+	}
+	if (leaf == nullptr){ //nothing was added, the tree is one empty leaf
+		if (NewLeaf() != OK){
+			return FAIL;
+		}
+		lowKeys.push_back(0);
+	}
+	if (UnpinPage(leafPid, DIRTY) != OK){
+		return FAIL;
+	}
+	leaf = nullptr;
+	if (FreeExtent() != OK){
+		return FAIL;
+	}
+
+	std::vector<int> keys = lowKeys;
+	std::vector<PageID> pids = leafPids;
+	while (pids.size() > 1){
+		std::vector<int> upKeys;
+		std::vector<PageID> upPids;
+		if (BuildLevel(keys, pids, upKeys, upPids) != OK){
+			return FAIL;
+		}
+		keys.swap(upKeys);
+		pids.swap(upPids);
+	}
+	rootPid = pids[0];
+	finished = true;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::Abort
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Give up the load and free every page it has written.  A
+//           finished load is left alone, its pages belong to a tree.
+//-------------------------------------------------------------------
+
+Status
+BTBulkLoader::Abort()
+{
+	if (finished){
+		return OK;
+	}
+	if (leaf != nullptr){
+		if (UnpinPage(leafPid, CLEAN) != OK){
+			return FAIL;
+		}
+		leaf = nullptr;
+	}
+	if (FreeExtent() != OK){
+		return FAIL;
+	}
+	for (size_t i = 0; i < leafPids.size(); i++){
+		if (FreePage(leafPids[i]) != OK){
+			return FAIL;
+		}
+	}
+	for (size_t i = 0; i < indexPids.size(); i++){
+		if (FreePage(indexPids[i]) != OK){
+			return FAIL;
+		}
+	}
+	leafPids.clear();
+	indexPids.clear();
+	lowKeys.clear();
+	numPages = 0;
+	numEntries = 0;
+	finished = true;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::NewLeaf
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Take the next page of the current run (allocating a new
+//           run when it is used up), link it after the current leaf
+//           and make it the current leaf.
+//-------------------------------------------------------------------
+
+Status
+BTBulkLoader::NewLeaf()
+{
+	if (extentLeft == 0){
+		Page* page;
+		if (NewPage(extentNext, page, BT_BULK_EXTENT) != OK || UnpinPage(extentNext, CLEAN) != OK){
+			return FAIL;
+		}
+		extentLeft = BT_BULK_EXTENT;
+	}
+	PageID pid = extentNext;
+	BTLeafPage* page;
+	if (PinPage(pid, (Page *&) page, true) != OK){
+		return FAIL;
+	}
+	extentNext++;
+	extentLeft--;
+	page->Init(pid);
+	page->SetType(LEAF_NODE);
+	page->SetPrevPage(leafPid);
+	page->SetNextPage(INVALID_PAGE);
+	if (leaf != nullptr){
+		leaf->SetNextPage(pid);
+		if (UnpinPage(leafPid, DIRTY) != OK){
+			return FAIL;
+		}
+	}
+	leaf = page;
+	leafPid = pid;
+	leafPids.push_back(pid);
+	numPages++;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::FreeExtent
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Give back the unused pages of the current run.
+//-------------------------------------------------------------------
+
+Status
+BTBulkLoader::FreeExtent()
+{
+	for (; extentLeft > 0; extentLeft--){
+		if (FreePage(extentNext) != OK){
+			return FAIL;
+		}
+		extentNext++;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::BuildLevel
+//
+// Input   : keys, pids - the lowest key and the pid of every page of
+//                        one level, in order
+// Output  : upKeys, upPids - the same for the level built above it
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Write the index pages over one level as one run.  The
+//           number of pages is the fewest that keeps each at the fill
+//           factor, and the children are spread evenly so that the
+//           last page is not left nearly empty.
+//-------------------------------------------------------------------
+
+Status
+BTBulkLoader::BuildLevel(const std::vector<int>& keys, const std::vector<PageID>& pids, std::vector<int>& upKeys, std::vector<PageID>& upPids)
+{
+	int perPage = (int) ((IndexCapacity() + 1) * fillFactor);
+	if (perPage < 4){
+		perPage = 4;
+	}
+	int n = (int) pids.size();
+	int count = (n + perPage - 1) / perPage;
+	PageID firstPid;
+	Page* first;
+	if (NewPage(firstPid, first, count) != OK || UnpinPage(firstPid, CLEAN) != OK){
+		return FAIL;
+	}
+	for (int i = 0; i < count; i++){
+		indexPids.push_back(firstPid + i);
+	}
+	for (int i = 0; i < count; i++){
+		PageID pid = firstPid + i;
+		BTIndexPage* page;
+		if (PinPage(pid, (Page *&) page, true) != OK){
+			return FAIL;
+		}
+		int lo = (int) ((long) n * i / count);
+		int hi = (int) ((long) n * (i + 1) / count);
+		page->Init(pid);
+		page->SetType(INDEX_NODE);
+		page->SetNextPage(INVALID_PAGE);
+		page->SetPrevPage(INVALID_PAGE);
+		page->SetLeftLink(pids[lo]);
+		for (int j = lo + 1; j < hi; j++){
+			RecordID rid_tmp;
+			if (page->Insert(keys[j], pids[j], rid_tmp) != OK){
+				UnpinPage(pid, DIRTY);
+				return FAIL;
+			}
+		}
+		if (UnpinPage(pid, DIRTY) != OK){
+			return FAIL;
+		}
+		upKeys.push_back(keys[lo]);
+		upPids.push_back(pid);
+		numPages++;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::IndexCapacity
+//
+// Input   : None
+// Output  : None
+// Return  : the number of entries a full index page holds.
+// Purpose : Count them by filling a scratch page, which keeps the
+//           count in step with the page layout.
+//-------------------------------------------------------------------
+
+int
+BTBulkLoader::IndexCapacity()
+{
+	Page scratch;
+	BTIndexPage* page = (BTIndexPage *) &scratch;
+	page->Init(INVALID_PAGE);
+	int n = 0;
+	RecordID rid_tmp;
+	while (page->AvailableSpace() >= (int) sizeof(IndexEntry) && page->Insert(n, INVALID_PAGE, rid_tmp) == OK){
+		n++;
+	}
+	return n;
+}
+
+
+//-------------------------------------------------------------------
+// BTBulkLoader::PinPage, BTBulkLoader::UnpinPage,
+// BTBulkLoader::NewPage, BTBulkLoader::FreePage
+//
+// Input   : as for BufMgr
+// Output  : as for BufMgr
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Call the pool of the loader, or the global buffer manager
+//           if it has none.
+//-------------------------------------------------------------------
+
+Status
+BTBulkLoader::PinPage(const PageID pid, Page*& page, const bool emptyPage)
+{
+	Status s = (pool != nullptr) ? pool->PinPage(pid, page, emptyPage) : MINIBASE_BM->PinPage(pid, page, emptyPage);
+	if (s != OK){
+		cerr << "Unable to pin page " << pid << endl;
+	}
+	return s;
+}
+
+Status
+BTBulkLoader::UnpinPage(const PageID pid, const int dirty)
+{
+	Status s = (pool != nullptr) ? pool->UnpinPage(pid, dirty) : MINIBASE_BM->UnpinPage(pid, dirty);
+	if (s != OK){
+		cerr << "Unable to unpin page " << pid << endl;
+	}
+	return s;
+}
+
+Status
+BTBulkLoader::NewPage(PageID& firstPid, Page*& firstPage, const int howMany)
+{
+	Status s = (pool != nullptr) ? pool->NewPage(firstPid, firstPage, howMany) : MINIBASE_BM->NewPage(firstPid, firstPage, howMany);
+	if (s != OK){
+		cerr << "Unable to allocate " << howMany << " pages" << endl;
+	}
+	return s;
+}
+
+Status
+BTBulkLoader::FreePage(const PageID pid)
+{
+	Status s = (pool != nullptr) ? pool->FreePage(pid) : MINIBASE_BM->FreePage(pid);
+	if (s != OK){
+		cerr << "Unable to free page " << pid << endl;
+	}
+	return s;
+}
+
+
+//-------------------------------------------------------------------
+// BTLeafChainReader::Open
+//
+// Input   : firstPid - the first leaf of the chain
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Position the reader on the first entry of the chain.
+//-------------------------------------------------------------------
+
+Status
+BTLeafChainReader::Open(const PageID firstPid)
+{
+	Close();
+	pid = firstPid;
+	slot = 0;
+	if (pid == INVALID_PAGE){
+		return OK;
+	}
+	PIN(pid,leaf);
+	return SkipEmpty();
+}
+
+
+//-------------------------------------------------------------------
+// BTLeafChainReader::Next
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Move to the next entry, following the sibling link at the
+//           end of a leaf.
+//-------------------------------------------------------------------
+
+Status
+BTLeafChainReader::Next()
+{
+	if (leaf == nullptr){
+		return FAIL;
+	}
+	slot++;
+	return SkipEmpty();
+}
+
+
+//-------------------------------------------------------------------
+// BTLeafChainReader::Close
+//
+// Input   : None
+// Output  : None
+// Purpose : Unpin the current leaf, if any.
+//-------------------------------------------------------------------
+
+void
+BTLeafChainReader::Close()
+{
+	if (leaf != nullptr){
+		MINIBASE_BM->UnpinPage(pid, CLEAN);
+		leaf = nullptr;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// BTLeafChainReader::SkipEmpty
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Move from a position past the end of the current leaf to
+//           the first entry of the next non-empty leaf, or to the end
+//           of the chain.
+//-------------------------------------------------------------------
+
+Status
+BTLeafChainReader::SkipEmpty()
+{
+	while (slot >= leaf->GetNumOfRecords()){
+		PageID nextPid = leaf->GetNextPage();
+		leaf = nullptr;
+		UNPIN(pid,CLEAN);
+		pid = nextPid;
+		slot = 0;
+		if (pid == INVALID_PAGE){
+			return OK;
+		}
+		PIN(pid,leaf);
+	}
+	return OK;
+}
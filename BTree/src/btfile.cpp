@@ -1,9 +1,24 @@
+#include <algorithm>
+#include <climits>
+#include <iterator>
+#include <thread>
+#include <vector>
+
 #include "minirel.h"
 #include "bufmgr.h"
 #include "db.h"
 #include "new_error.h"
 #include "btfile.h"
 #include "btfilescan.h"
+#include "btbuild.h"
+#include "btrange.h"
+
+// The split and merge code pins and allocates its pages through
+// PinLatched and NewPageLatched, which go to the tree's own pool when
+// concurrency is on, so threads split and merge without the base latch.
+#define PIN_TREE(a, b)     if (PinLatched((a), (Page *&)(b), BT_LATCH_NONE) != OK) { return FAIL; }
+#define UNPIN_TREE(a, b)   if (UnpinLatched((a), BT_LATCH_NONE, (b)) != OK) { return FAIL; }
+#define NEWPAGE_TREE(a, b) if (NewPageLatched((a), (Page *&)(b)) != OK) { return FAIL; }
 
 
 //-------------------------------------------------------------------
@@ -21,6 +36,17 @@ BTreeFile::BTreeFile (Status& returnStatus, const char* filename)
 
     PageID pid = INVALID_PAGE;
     Page *page;
+    structureVersion = 0;
+    ahi = nullptr;
+    router = nullptr;
+    swizzle = nullptr;
+    latches = nullptr;
+    pool = nullptr;
+    frozen = nullptr;
+    reorg = nullptr;
+    reorgKey = 0;
+    reorgCopied = false;
+    generation = 0;
     Status s = MINIBASE_DB->GetFileEntry(filename,pid); //try get the first entry of the file.
     if (s == FAIL){//file does not exist, create a file with filename.
       returnStatus = MINIBASE_BM->NewPage(pid,page); //create new page 
@@ -41,7 +67,11 @@ BTreeFile::BTreeFile (Status& returnStatus, const char* filename)
 		returnStatus = MINIBASE_BM->PinPage(pid,page);
 		setRootPid(pid);	//Set the root pid to the pid of first entry of the file.
 		setFileName(filename);
+		bool isFrozen = (returnStatus == OK && ((SortedPage *) page)->GetType() == FROZEN_NODE);
 		MINIBASE_BM->UnpinPage(pid,DIRTY);
+		if (isFrozen){ //the directory of a frozen tree lives in memory only
+			returnStatus = LoadFrozenDirectory();
+		}
 	}
 
 }
@@ -58,6 +88,13 @@ BTreeFile::BTreeFile (Status& returnStatus, const char* filename)
 BTreeFile::~BTreeFile()
 {
 	//unpin the root page
+	AbortReorganize();
+	delete ahi;
+	delete router;
+	delete swizzle;
+	delete latches;
+	delete pool;
+	delete frozen;
 }
 
 
@@ -74,6 +111,23 @@ BTreeFile::~BTreeFile()
 Status
 BTreeFile::DestroyFile()
 {
+	AbortReorganize();
+	if (ahi != nullptr){
+		ahi->Clear();
+	}
+	if (router != nullptr){
+		router->Clear();
+	}
+	ReleaseFrames();
+	if (frozen != nullptr){ //a frozen tree is one run of pages, no index pages to walk
+		for (int i = 0; i < frozen->GetNumOfPages(); i++){
+			FREEPAGE(frozen->GetPid(i));
+		}
+		delete frozen;
+		frozen = nullptr;
+		rootPid = INVALID_PAGE;
+		return MINIBASE_DB->DeleteFileEntry(this->fname);
+	}
 	if (rootPid == INVALID_PAGE){ // if the file is empty, nothing needs to be done;
 		Status s = MINIBASE_DB->DeleteFileEntry(this->fname); //delete the file
 		if (s != OK){
@@ -170,27 +224,118 @@ BTreeFile::DestroyFileHelper(PageID curPid){
 // Output  : None
 // Return  : OK if successful, FAIL otherwise.
 // Purpose : Insert an index entry with this rid and key.
-// Note    : If the root didn't exist, create it.
 //-------------------------------------------------------------------
 
-
 Status
 BTreeFile::Insert(const int key, const RecordID rid)
+{
+	if (latches != nullptr){
+		return InsertLatched(key, rid);
+	}
+	return InsertExclusive(key, rid);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::InsertLatched
+//
+// Input   : key, rid - the entry to insert
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert with other threads in the tree.  The leaf is found
+//           in shared tree mode and latched exclusively; if the entry
+//           fits, it is inserted there while inserts into other
+//           leaves go on in parallel.  A full leaf needs a split: the
+//           pages the split writes are latched by LatchPath, and the
+//           split runs from the highest of them, still in shared tree
+//           mode, so readers and writers elsewhere in the tree go on.
+//           Only the first entry of an empty tree, and inserts while
+//           Reorganize is logging changes, run in exclusive tree mode.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::InsertLatched(const int key, const RecordID rid)
+{
+	if (frozen != nullptr){ //a frozen tree is read-only
+		return FAIL;
+	}
+	LatchTree(false);
+	if (reorg == nullptr && rootPid != INVALID_PAGE){
+		BTLeafPage* leafPage;
+		unsigned int treeVersion;
+		PageID pid = FindLeafLatched(key, BT_LATCH_EXCLUSIVE, (Page *&) leafPage, treeVersion);
+		if (pid != INVALID_PAGE){
+			bool fits = (leafPage->AvailableSpace() >= (int) sizeof(LeafEntry));
+			Status s = OK;
+			if (fits){
+				RecordID dummy;
+				s = leafPage->Insert(key, rid, dummy);
+			}
+			UnpinLatched(pid, BT_LATCH_EXCLUSIVE, fits ? DIRTY : CLEAN);
+			if (fits){
+				UnlatchTree(false);
+				return s;
+			}
+		}
+		std::vector<PageID> held;
+		PageID topPid = LatchPath(key, true, held);
+		Status s = FAIL;
+		if (topPid == rootPid.load(std::memory_order_acquire)){ //the root may split
+			s = InsertExclusive(key, rid);
+		}
+		else if (topPid != INVALID_PAGE){
+			bool split = false;
+			int childKey;
+			PageID childPid;
+			s = InsertHelper(key, rid, topPid, split, childKey, childPid);
+		}
+		if (UnlatchPath(held) != OK){
+			s = FAIL;
+		}
+		UnlatchTree(false);
+		return s;
+	}
+	UnlatchTree(false);
+	LatchTree(true);
+	Status s = InsertExclusive(key, rid);
+	UnlatchTree(true);
+	return s;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::InsertExclusive
+//
+// Input   : key - the value of the key to be inserted.
+//           rid - RecordID of the record to be inserted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Insert an index entry with this rid and key, splitting
+//           the pages on the way that overflow.
+// Note    : If the root didn't exist, create it.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::InsertExclusive(const int key, const RecordID rid)
 {
 
 	Status s;
+	if (frozen != nullptr){ //a frozen tree is read-only
+		return FAIL;
+	}
 	//if there is no root page, create one
 	if (rootPid == INVALID_PAGE ){
 		BTLeafPage* leafpage;
 		RecordID outRid;		
-		NEWPAGE(rootPid,leafpage);
-		leafpage->Init(rootPid);
+		PageID leafPid;
+		NEWPAGE_TREE(leafPid,leafpage);
+		leafpage->Init(leafPid);
 		leafpage->SetPrevPage(INVALID_PAGE);
 		leafpage->SetNextPage(INVALID_PAGE);
 		leafpage->SetType(LEAF_NODE);
-		setRootPid(rootPid);
 		leafpage->Insert(key, rid, outRid);
-		UNPIN(rootPid,DIRTY);
+		setRootPid(leafPid); //published once the page is written
+		TouchLeaf(leafPid);
+		UNPIN_TREE(leafPid,DIRTY);
+		LogReorganize(BT_REORG_INSERT, key, rid, rid);
 		return OK;
 	}
 	
@@ -205,12 +350,12 @@ BTreeFile::Insert(const int key, const RecordID rid)
 	}
 	if (split){// if the root node needs to be split
 		SortedPage* curPage;
-		PIN(rootPid,curPage);
+		PIN_TREE(rootPid,curPage);
 		Status s_t;
 		BTIndexPage* newIndexPage;
 		PageID newIndexPid;
 		RecordID tmp_rid; 
-		NEWPAGE(newIndexPid,newIndexPage);//create a new page and set up the info for the newpage
+		NEWPAGE_TREE(newIndexPid,newIndexPage);//create a new page and set up the info for the newpage
 		if (curPage->GetType()==INDEX_NODE){
 			newIndexPage->Init(newIndexPid);
 			newIndexPage->SetType(INDEX_NODE);
@@ -221,8 +366,12 @@ BTreeFile::Insert(const int key, const RecordID rid)
 			if (s_t != OK ){
 					return FAIL;
 			}
-			setRootPid(newIndexPid);
-			UNPIN(newIndexPid,DIRTY);
+			UNPIN_TREE(rootPid,CLEAN); //the old root keeps its entries
+			s_t = SaveRootPid(newIndexPid);
+			UNPIN_TREE(newIndexPid,DIRTY);
+			if (s_t != OK){
+				return FAIL;
+			}
 		}
 		else{
 			newIndexPage->Init(newIndexPid);
@@ -235,12 +384,16 @@ BTreeFile::Insert(const int key, const RecordID rid)
 					return FAIL;
 			}
 			curPage->SetType(LEAF_NODE);
-			UNPIN(rootPid,DIRTY);
-			setRootPid(newIndexPid);
-			UNPIN(newIndexPid,DIRTY);
+			UNPIN_TREE(rootPid,DIRTY);
+			s_t = SaveRootPid(newIndexPid);
+			UNPIN_TREE(newIndexPid,DIRTY);
+			if (s_t != OK){
+				return FAIL;
+			}
 		}
 		
 	}
+	LogReorganize(BT_REORG_INSERT, key, rid, rid);
     return OK;
 
 }
@@ -266,18 +419,18 @@ BTreeFile::InsertHelper(const int key, const RecordID rid, PageID curPid, bool&
 	bool new_split = false; 
 	int new_child_key;
 	PageID new_child_pageid;
-	PIN(curPid,curPage);
+	PIN_TREE(curPid,curPage);
 	if (curPage->GetType() == INDEX_NODE){//in the page is index node
 		BTIndexPage* indexpage = (BTIndexPage *) curPage;
 		int dummy_key;
 		RecordID dummy_rid;
 		indexpage->FindPageWithKey(key, dummy_key,new_curPid,dummy_rid);//find the next page to insert 
-		UNPIN(curPid,CLEAN);
+		UNPIN_TREE(curPid,CLEAN);
 		Status s = this->InsertHelper(key,rid,new_curPid,new_split,new_child_key,new_child_pageid); //recursively insert rid
 		if (s != OK){
 			return FAIL;
 		}
-		PIN(curPid,curPage);
+		PIN_TREE(curPid,curPage);
 		indexpage = (BTIndexPage *) curPage;
 		if (new_split){//if needs to split the next page
 			//insert the child key into the current page
@@ -286,7 +439,7 @@ BTreeFile::InsertHelper(const int key, const RecordID rid, PageID curPid, bool&
 				//split the current index page
 				BTIndexPage* newIndexPage;
 				PageID newIndexPid;
-				NEWPAGE(newIndexPid,newIndexPage);
+				NEWPAGE_TREE(newIndexPid,newIndexPage);
 				newIndexPage->Init(newIndexPid);
 				newIndexPage->SetType(INDEX_NODE);
 				newIndexPage->SetPrevPage(INVALID_PAGE);
@@ -296,13 +449,13 @@ BTreeFile::InsertHelper(const int key, const RecordID rid, PageID curPid, bool&
 				split = true;
 				child_key=newPageKey; //propogate the child key up to the upper page
 				child_pageid=newIndexPid;
-				UNPIN(newIndexPid,DIRTY);
+				UNPIN_TREE(newIndexPid,DIRTY);
 			}
 			else{
 				indexpage->Insert(new_child_key,new_child_pageid,rid_tmp);
 			}
 		}
-		UNPIN(curPid,DIRTY);
+		UNPIN_TREE(curPid,DIRTY);
 		return OK;
 	}
 	//case when curPage is leaf node
@@ -312,24 +465,38 @@ BTreeFile::InsertHelper(const int key, const RecordID rid, PageID curPid, bool&
 		//case when failed to insert the key as the page is full
 		BTLeafPage* newLeafPage;
 		PageID newLeafPid;
-		NEWPAGE(newLeafPid,newLeafPage); // create new leaf node for split
+		NEWPAGE_TREE(newLeafPid,newLeafPage); // create new leaf node for split
 		newLeafPage->Init(newLeafPid);
 		newLeafPage->SetType(LEAF_NODE);
 		newLeafPage->SetNextPage(INVALID_PAGE);
 		newLeafPage->SetPrevPage(INVALID_PAGE);
 		Status s = this->Split_Leaf(leafpage,newLeafPage,key,rid); //split the node
 		split = true;
+		structureVersion++;
+		TouchLeaf(newLeafPid);
 		RecordID tmp1,tmp2;
 		newLeafPage->GetFirst(child_key,tmp1,tmp2); //propogate the child key and child pageid to the higher level
 		child_pageid=newLeafPid; 
+		if (router != nullptr){
+			router->OnSplit(curPid,child_key,newLeafPid,structureVersion);
+		}
+		PageID oldNextPid = leafpage->GetNextPage();
+		if (oldNextPid != INVALID_PAGE){ //the old right neighbour now follows the new node
+			SortedPage* oldNextPage;
+			PIN_TREE(oldNextPid,oldNextPage);
+			oldNextPage->SetPrevPage(newLeafPid);
+			UNPIN_TREE(oldNextPid,DIRTY);
+		}
+		newLeafPage->SetNextPage(oldNextPid);
 		leafpage->SetNextPage(newLeafPid); //set the links between old and and new node; 
 		newLeafPage->SetPrevPage(curPid);
-		UNPIN(newLeafPid,DIRTY);
+		UNPIN_TREE(newLeafPid,DIRTY);
 	}
 	else{
 		leafpage->Insert(key,rid,dummy);
 	}
-	UNPIN(curPid,DIRTY);
+	TouchLeaf(curPid);
+	UNPIN_TREE(curPid,DIRTY);
 	return OK;
 }
 //-------------------------------------------------------------------
@@ -373,6 +540,8 @@ BTreeFile::Split_Index(BTIndexPage* oldPage, BTIndexPage* newPage, const int key
 				return FAIL;
 			}
 			inserted = true;
+			curKey_tmp=key; //the new key may be the last one moved, and then goes up
+			curPid_tmp=pid;
 		}else{
 			s = oldPage->Insert(curKey,curPid,curRid); // insert the current key to old page
 			if (s != OK){
@@ -487,20 +656,106 @@ BTreeFile::Split_Leaf(BTLeafPage* oldPage, BTLeafPage* newPage, const int key,co
 // Output  : None
 // Return  : OK if successful, FAIL otherwise.
 // Purpose : Delete an index entry with this rid and key.
-// Note    : If the root becomes empty, delete it.
 //-------------------------------------------------------------------
 
 Status
 BTreeFile::Delete(const int key, const RecordID rid)
+{
+	if (latches != nullptr){
+		return DeleteLatched(key, rid);
+	}
+	return DeleteExclusive(key, rid);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::DeleteLatched
+//
+// Input   : key, rid - the entry to delete
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Delete with other threads in the tree.  As in
+//           InsertLatched, the leaf is changed in place under its
+//           latch when it stays at least half full; a delete that
+//           underflows it latches the pages its merges and
+//           redistributions write with LatchPath, and runs from the
+//           highest of them in shared tree mode.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::DeleteLatched(const int key, const RecordID rid)
+{
+	if (frozen != nullptr){ //a frozen tree is read-only
+		return FAIL;
+	}
+	LatchTree(false);
+	if (reorg == nullptr){
+		BTLeafPage* leafPage;
+		unsigned int treeVersion;
+		PageID pid = FindLeafLatched(key, BT_LATCH_EXCLUSIVE, (Page *&) leafPage, treeVersion);
+		if (pid == INVALID_PAGE){
+			UnlatchTree(false);
+			return FAIL;
+		}
+		bool safe = (pid == rootPid || leafPage->IsAtLeastHalfFullAfterDelete());
+		Status s = OK;
+		if (safe){
+			RecordID dummy;
+			s = leafPage->Delete(key, rid, dummy);
+		}
+		UnpinLatched(pid, BT_LATCH_EXCLUSIVE, DIRTY);
+		if (safe){
+			UnlatchTree(false);
+			return (s == OK) ? OK : FAIL;
+		}
+		std::vector<PageID> held;
+		PageID topPid = LatchPath(key, false, held);
+		s = FAIL;
+		if (topPid == rootPid.load(std::memory_order_acquire)){ //the root may lose its last entry
+			s = DeleteExclusive(key, rid);
+		}
+		else if (topPid != INVALID_PAGE){ //the top page does not underflow, so it needs no siblings
+			bool underflow = false;
+			bool merged = false;
+			int childKey, deletedKey;
+			PageID childPid;
+			s = DeleteHelper(key, rid, 0, 0, topPid, INVALID_PAGE, INVALID_PAGE, underflow, merged, childKey, childPid, deletedKey);
+		}
+		if (UnlatchPath(held) != OK){
+			s = FAIL;
+		}
+		UnlatchTree(false);
+		return s;
+	}
+	UnlatchTree(false);
+	LatchTree(true);
+	Status s = DeleteExclusive(key, rid);
+	UnlatchTree(true);
+	return s;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::DeleteExclusive
+//
+// Input   : key - the value of the key to be deleted.
+//           rid - RecordID of the record to be deleted.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Delete an index entry with this rid and key, merging or
+//           redistributing the pages that underflow.
+// Note    : If the root becomes empty, delete it.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::DeleteExclusive(const int key, const RecordID rid)
 {
 
 	
-	if (rootPid == INVALID_PAGE){ // if there is no root page
+	if (rootPid == INVALID_PAGE || frozen != nullptr){ // if there is no root page, or the tree is read-only
 		return FAIL;
 	}
 	SortedPage * curPage,*prevPage,*nextPage;
 	PageID curPid = this->rootPid;
-	PIN(curPid,curPage);
+	PIN_TREE(curPid,curPage);
 	if (curPage->GetType()==LEAF_NODE){ // if the current page is leaf node
 
 		BTLeafPage* leafPage = (BTLeafPage*) curPage;
@@ -509,7 +764,9 @@ BTreeFile::Delete(const int key, const RecordID rid)
 		if (s != OK){
 			return FAIL;
 		}
-		UNPIN(curPid,DIRTY);
+		TouchLeaf(curPid);
+		UNPIN_TREE(curPid,DIRTY);
+		LogReorganize(BT_REORG_DELETE, key, rid, rid);
 		return OK;
 	}
 	//case when the current page is an index page
@@ -521,6 +778,12 @@ BTreeFile::Delete(const int key, const RecordID rid)
 	RecordID rid_dummy;
 	Status s = indexPage->FindPageWithKeys(key,curKey,nextKey,pid,prevPid,nextPid,rid_dummy); // find the curKey, nextKey, curPid, prevPid, and nextPid using key
 	if (s != OK){return FAIL;}
+	if (prevPid == pid) {
+		prevPid = INVALID_PAGE;
+	}
+	if (nextPid == pid){ //the rightmost child has no next sibling
+		nextPid = INVALID_PAGE;
+	}
 
 	s = this->DeleteHelper(key,rid,curKey,nextKey,pid,prevPid,nextPid,underflow,merged,child_key,child_deleted_pageid,deletedKey);// recursively find the key to be deleted
 	if (underflow){ //case if the childnode underflows
@@ -531,8 +794,11 @@ BTreeFile::Delete(const int key, const RecordID rid)
 			int key_dummy;
 			PageID pid_dummy;
 			if (indexPage->GetFirst(key_dummy,pid_dummy,rid_dummy) == DONE){
-				UNPIN(curPid,DIRTY);
-				setRootPid(indexPage->GetLeftLink());
+				UNPIN_TREE(curPid,DIRTY);
+				if (SaveRootPid(indexPage->GetLeftLink()) != OK){
+					return FAIL;
+				}
+				LogReorganize(BT_REORG_DELETE, key, rid, rid);
 				return OK;
 			}
 		}else{//case if use redistribution method, delete the key in the index node and insert and new key based on the child key propogated back
@@ -542,10 +808,279 @@ BTreeFile::Delete(const int key, const RecordID rid)
 		}
 	}
 
-	UNPIN(curPid,DIRTY);
+	UNPIN_TREE(curPid,DIRTY);
+	LogReorganize(BT_REORG_DELETE, key, rid, rid);
     return OK;
 }
 
+//-------------------------------------------------------------------
+// BTreeFile::UpdateRid
+//
+// Input   : key - the key of the entry to be updated.
+//           oldRid - RecordID the entry currently holds.
+//           newRid - RecordID the entry should hold.
+// Output  : None
+// Return  : OK if successful, FAIL if (key, oldRid) is not found.
+// Purpose : Repoint an index entry at a record that has moved.  The
+//           key is unchanged, so the entry keeps its position and is
+//           overwritten in place after a single descent.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::UpdateRid(const int key, const RecordID oldRid, const RecordID newRid)
+{
+	RidUpdate update;
+	update.key = key;
+	update.oldRid = oldRid;
+	update.newRid = newRid;
+	return UpdateRids(&update, 1);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::UpdateRids
+//
+// Input   : updates - record moves sorted by key.
+//           n - number of updates
+// Output  : None
+// Return  : OK if every entry is found, FAIL otherwise.  The entries
+//           that are found are updated either way.
+// Purpose : Apply a batch of in-place record id updates.  The tree is
+//           descended once, with the key before the smallest one since
+//           a run of duplicates may begin left of its separator; the
+//           updates are applied in one sweep along the leaf chain, and
+//           only the leaves that change are written back.  Each update searches
+//           its key's run of entries from the start, going back to the
+//           leaf the run starts on, so updates of one key may come in
+//           any order of oldRid.  With concurrency on each update
+//           latches its own leaves instead (see UpdateRidsLatched).
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::UpdateRids(const RidUpdate* updates, int n)
+{
+	if (n <= 0){
+		return OK;
+	}
+	if (frozen != nullptr){ //a frozen tree is read-only
+		return FAIL;
+	}
+	if (latches != nullptr){
+		bool exclusive = (reorg != nullptr); //the log of a running Reorganize is not shared
+		LatchTree(exclusive);
+		Status s = UpdateRidsLatched(updates, n);
+		UnlatchTree(exclusive);
+		return s;
+	}
+	PageID curPid = FindPidWithKey((updates[0].key > INT_MIN) ? updates[0].key - 1 : updates[0].key);
+	if (curPid == INVALID_PAGE){
+		return FAIL;
+	}
+	BTLeafPage* leafPage;
+	PIN(curPid,leafPage);
+	bool dirty = false;
+	bool missed = false;
+	PageID runPid = INVALID_PAGE; //leaf the entries of the previous update's key start on
+	for (int i = 0; i < n; i++){
+		const RidUpdate& u = updates[i];
+		if (i > 0 && u.key == updates[i-1].key && runPid != curPid && runPid != INVALID_PAGE){ //oldRid may be earlier in the run
+			UNPIN(curPid,dirty);
+			curPid = runPid;
+			PIN(curPid,leafPage);
+			dirty = false;
+		}
+		bool landed = false;
+		bool done = false;
+		while (!done){
+			int slot = leafPage->FindSlot(u.key);
+			int numEntries = leafPage->GetNumOfRecords();
+			if (!landed && slot < numEntries){
+				runPid = curPid;
+				landed = true;
+			}
+			while (slot < numEntries && leafPage->GetEntry(slot)->key == u.key && leafPage->GetEntry(slot)->rid != u.oldRid){
+				slot++; //skip the duplicates of key
+			}
+			if (slot < numEntries){
+				LeafEntry* entry = leafPage->GetEntry(slot);
+				if (entry->key == u.key){
+					entry->rid = u.newRid;
+					dirty = true;
+					LogReorganize(BT_REORG_UPDATE, u.key, u.oldRid, u.newRid);
+				}
+				else{
+					missed = true;
+				}
+				done = true;
+			}
+			else if (leafPage->GetNextPage() == INVALID_PAGE){ //ran off the last leaf
+				missed = true;
+				done = true;
+			}
+			else{ //the key may be on a later leaf, move right
+				PageID nextPid = leafPage->GetNextPage();
+				UNPIN(curPid,dirty);
+				curPid = nextPid;
+				PIN(curPid,leafPage);
+				dirty = false;
+			}
+		}
+	}
+	UNPIN(curPid,dirty);
+	return missed ? FAIL : OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::UpdateRidsLatched
+//
+// Input   : updates, n - as in UpdateRids
+// Output  : None
+// Return  : OK if every entry is found, FAIL otherwise.
+// Purpose : UpdateRids with other threads in the tree.  Each update
+//           latches the leaf the run of its key may start on, found
+//           with the key before it, and moves right with latch
+//           coupling, the next leaf latched before the current one is
+//           released, until it finds oldRid or passes the key.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::UpdateRidsLatched(const RidUpdate* updates, int n)
+{
+	bool missed = false;
+	for (int i = 0; i < n; i++){
+		const RidUpdate& u = updates[i];
+		BTLeafPage* leafPage;
+		unsigned int treeVersion;
+		PageID curPid = FindLeafLatched((u.key > INT_MIN) ? u.key - 1 : u.key, BT_LATCH_EXCLUSIVE, (Page *&) leafPage, treeVersion);
+		if (curPid == INVALID_PAGE){
+			missed = true;
+			continue;
+		}
+		bool dirty = false;
+		while (true){
+			int slot = leafPage->FindSlot(u.key);
+			int numEntries = leafPage->GetNumOfRecords();
+			while (slot < numEntries && leafPage->GetEntry(slot)->key == u.key && leafPage->GetEntry(slot)->rid != u.oldRid){
+				slot++; //skip the duplicates of key
+			}
+			if (slot < numEntries){
+				LeafEntry* entry = leafPage->GetEntry(slot);
+				if (entry->key == u.key){
+					entry->rid = u.newRid;
+					dirty = true;
+					LogReorganize(BT_REORG_UPDATE, u.key, u.oldRid, u.newRid);
+				}
+				else{
+					missed = true;
+				}
+				break;
+			}
+			PageID nextPid = leafPage->GetNextPage();
+			if (nextPid == INVALID_PAGE){ //ran off the last leaf
+				missed = true;
+				break;
+			}
+			Page* nextPage;
+			if (PinLatched(nextPid, nextPage, BT_LATCH_EXCLUSIVE) != OK){
+				UnpinLatched(curPid, BT_LATCH_EXCLUSIVE, dirty);
+				return FAIL;
+			}
+			if (UnpinLatched(curPid, BT_LATCH_EXCLUSIVE, dirty) != OK){
+				UnpinLatched(nextPid, BT_LATCH_EXCLUSIVE, CLEAN);
+				return FAIL;
+			}
+			curPid = nextPid;
+			leafPage = (BTLeafPage *) nextPage;
+			dirty = false;
+		}
+		if (UnpinLatched(curPid, BT_LATCH_EXCLUSIVE, dirty) != OK){
+			return FAIL;
+		}
+	}
+	return missed ? FAIL : OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::RemapRids
+//
+// Input   : mapping - old record id -> new record id, for every record
+//                     the heap file has moved.
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Repoint the index after a heap reorganization.  The keys
+//           are not known, so instead of a descent per record the leaf
+//           chain is swept once from the leftmost leaf, every entry is
+//           looked up in the mapping, and only the leaves that change
+//           are written back.  With other threads in the tree the
+//           sweep runs in exclusive tree mode, and every leaf is
+//           latched while it changes, so that optimistic readers see
+//           the new versions and read again.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::RemapRids(const std::map<RecordID, RecordID>& mapping)
+{
+	if (mapping.empty()){
+		return OK;
+	}
+	if (frozen != nullptr){ //a frozen tree is read-only
+		return FAIL;
+	}
+	LatchTree(true);
+	Status s = RemapRidsExclusive(mapping);
+	UnlatchTree(true);
+	return s;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::RemapRidsExclusive
+//
+// Input   : mapping - as in RemapRids
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : The sweep of RemapRids, run with no writer in the tree.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::RemapRidsExclusive(const std::map<RecordID, RecordID>& mapping)
+{
+	AbortReorganize();
+	int key, height;
+	if (latches != nullptr){ //GetMinimumPid pins through the global buffer manager
+		ConcurrentBufMgr::LockBase();
+	}
+	PageID curPid = GetMinimumPid(key, height);
+	if (latches != nullptr){
+		ConcurrentBufMgr::UnlockBase();
+	}
+	const RecordID lowRid = mapping.begin()->first;
+	const RecordID highRid = mapping.rbegin()->first;
+	while (curPid != INVALID_PAGE){
+		BTLeafPage* leafPage;
+		if (PinLatched(curPid, (Page *&) leafPage, BT_LATCH_EXCLUSIVE) != OK){
+			return FAIL;
+		}
+		bool dirty = false;
+		int numEntries = leafPage->GetNumOfRecords();
+		for (int i = 0; i < numEntries; i++){
+			LeafEntry* entry = leafPage->GetEntry(i);
+			if (entry->rid < lowRid || entry->rid > highRid){ //cannot have moved
+				continue;
+			}
+			std::map<RecordID, RecordID>::const_iterator it = mapping.find(entry->rid);
+			if (it != mapping.end()){
+				entry->rid = it->second;
+				dirty = true;
+			}
+		}
+		PageID nextPid = leafPage->GetNextPage();
+		if (UnpinLatched(curPid, BT_LATCH_EXCLUSIVE, dirty) != OK){
+			return FAIL;
+		}
+		curPid = nextPid;
+	}
+	return OK;
+}
+
 //-------------------------------------------------------------------
 // BTreeFile::DeleteHelper
 //
@@ -565,7 +1100,7 @@ BTreeFile::DeleteHelper(const int key, const RecordID rid, const int curKey,cons
 {
 
 	SortedPage * curPage, *prevPage,*nextPage;
-	PIN(curPid,curPage);
+	PIN_TREE(curPid,curPage);
 
 	if (curPage->GetType() == INDEX_NODE){//case when the curpage is index node
 		BTIndexPage* indexPage = (BTIndexPage *) curPage;
@@ -595,9 +1130,9 @@ BTreeFile::DeleteHelper(const int key, const RecordID rid, const int curKey,cons
 					bool reconstruc = false;
 
 					if (prevPid != INVALID_PAGE){//borrow a key from previous page
-						PIN(prevPid,prevPage);
+						PIN_TREE(prevPid,prevPage);
 						BTIndexPage* prevIndex = (BTIndexPage *) prevPage;
-						if (prevIndex->IsAtLeastHalfFullAfterDelete()){
+						if (prevIndex->IsAtLeastHalfFullAfterDelete() || !prevIndex->CanAbsorb(indexPage)){ //borrow if rich, or if the two would not fit in one page
 							//reconstruction
 							int key_tmp;
 							PageID pid_tmp;
@@ -613,16 +1148,16 @@ BTreeFile::DeleteHelper(const int key, const RecordID rid, const int curKey,cons
 							child_key =	key_tmp;
 							child_pageid=curPid;
 							deletedKey = curKey;
-							UNPIN(prevPid,DIRTY);
+							UNPIN_TREE(prevPid,DIRTY);
 						}else{
-							UNPIN (prevPid,CLEAN);
+							UNPIN_TREE(prevPid,CLEAN);
 						}
 						
 					}
 					if (nextPid != INVALID_PAGE && !reconstruc){//borrow a key from next page
-						PIN(nextPid,nextPage);
+						PIN_TREE(nextPid,nextPage);
 						BTIndexPage* nextIndex = (BTIndexPage *) nextPage;
-						if (nextIndex->IsAtLeastHalfFullAfterDelete()){
+						if (nextIndex->IsAtLeastHalfFullAfterDelete() || !indexPage->CanAbsorb(nextIndex)){
 							int key_tmp;
 							PageID pid_tmp;
 							RecordID rid_tmp;
@@ -637,48 +1172,46 @@ BTreeFile::DeleteHelper(const int key, const RecordID rid, const int curKey,cons
 							child_key =	key_tmp;
 							child_pageid=nextPid;
 							deletedKey = nextKey;
-							UNPIN(nextPid,DIRTY);
+							UNPIN_TREE(nextPid,DIRTY);
 						}else{
-							UNPIN(nextPid,CLEAN);
+							UNPIN_TREE(nextPid,CLEAN);
 						}
 						
 					}
 					if (!reconstruc){//case when need to merge
 						merged = true;
 						if (nextPid != INVALID_PAGE){//merge the next page into current page
-							PIN(nextPid,nextPage);
+							PIN_TREE(nextPid,nextPage);
 							BTIndexPage* nextIndex = (BTIndexPage *) nextPage;
 							
 							int key_tmp;
 							PageID pid_tmp;
 							RecordID rid_tmp;
 							Status s = nextIndex->GetFirst(key_tmp,pid_tmp,rid_tmp);
-							if (s!=OK){return FAIL;}
-							while (s != DONE){
+							while (s == OK){ //the page may already be empty
 								s = indexPage->Insert(key_tmp,pid_tmp,rid_tmp);
 								s = nextIndex->Delete(key_tmp,rid_tmp);
 								s = nextIndex->GetFirst(key_tmp,pid_tmp,rid_tmp);
 							}
 							indexPage->Insert(nextKey,nextIndex->GetLeftLink(),rid_dummy);
-							UNPIN (nextPid,DIRTY);
+							UNPIN_TREE(nextPid,DIRTY);
 							deletedKey = nextKey;
 						}
 						else{//merge the current page into prev page
-							PIN(prevPid,prevPage);
+							PIN_TREE(prevPid,prevPage);
 							BTIndexPage* prevIndex = (BTIndexPage *) prevPage;
 							
 							int key_tmp;
 							PageID pid_tmp;
 							RecordID rid_tmp;
 							Status s = indexPage->GetFirst(key_tmp,pid_tmp,rid_tmp);
-							if (s!=OK){return FAIL;}
-							while (s != DONE){
+							while (s == OK){ //the page may already be empty
 								s = prevIndex->Insert(key_tmp,pid_tmp,rid_tmp);
 								s = indexPage->Delete(key_tmp,rid_tmp);
 								s = indexPage->GetFirst(key_tmp,pid_tmp,rid_tmp);
 							}
 							prevIndex->Insert(curKey,indexPage->GetLeftLink(),rid_tmp);
-							UNPIN (prevPid,DIRTY);
+							UNPIN_TREE(prevPid,DIRTY);
 							deletedKey = curKey;
 						}
 					}
@@ -691,7 +1224,7 @@ BTreeFile::DeleteHelper(const int key, const RecordID rid, const int curKey,cons
 				s=indexPage->Insert(new_child_key,new_child_pageid,rid_dummy);				
 			}
 		}
-		UNPIN(curPid,DIRTY);
+		UNPIN_TREE(curPid,DIRTY);
 		return OK;
 	}
 	//case when curpage is leaf node
@@ -701,61 +1234,67 @@ BTreeFile::DeleteHelper(const int key, const RecordID rid, const int curKey,cons
 	if (s != OK){
 		return FAIL;
 	}
+	TouchLeaf(curPid);
 	if (! leafPage->IsAtLeastHalfFull()){//case when the leaf node is not half full
 		underflow = true;
+		structureVersion++;
 		bool reconstruc = false;
 		if (prevPid != INVALID_PAGE){//borrow the rid from previous page
-			PIN(prevPid,prevPage);
+			PIN_TREE(prevPid,prevPage);
 			BTLeafPage* prevLeaf = (BTLeafPage *) prevPage;
-			if (prevLeaf->IsAtLeastHalfFullAfterDelete()){
+			if (prevLeaf->IsAtLeastHalfFullAfterDelete() || !prevLeaf->CanAbsorb(leafPage)){ //borrow if rich, or if the two would not fit in one page
 				this->DeleteLeaf_prev(prevLeaf,leafPage,child_key);
-				UNPIN(prevPid,DIRTY);
+				TouchLeaf(prevPid);
+				UNPIN_TREE(prevPid,DIRTY);
 				reconstruc = true;
 				child_pageid=curPid;
 				deletedKey = curKey;
 			}else{
-				UNPIN (prevPid,CLEAN);
+				UNPIN_TREE(prevPid,CLEAN);
 			}
 			
 		}
 		if (nextPid != INVALID_PAGE && !reconstruc){//borrow the rid from next page
-			PIN(nextPid,nextPage);			
+			PIN_TREE(nextPid,nextPage);			
 			BTLeafPage* nextLeaf = (BTLeafPage *) nextPage;
-			if (nextLeaf->IsAtLeastHalfFullAfterDelete()){
+			if (nextLeaf->IsAtLeastHalfFullAfterDelete() || !leafPage->CanAbsorb(nextLeaf)){
 				this->DeleteLeaf_next(nextLeaf,leafPage,child_key);
+				TouchLeaf(nextPid);
 				reconstruc = true;
 				child_pageid=nextPid;
 				deletedKey = nextKey;
-				UNPIN(nextPid,DIRTY);
+				UNPIN_TREE(nextPid,DIRTY);
 			}else{
-				UNPIN(nextPid,CLEAN)
+				UNPIN_TREE(nextPid,CLEAN)
 			}
 			
 		}
 		if (!reconstruc){//if neibourgh nodes are not avaliable
 			merged = true;
 			if (nextPid != INVALID_PAGE){//if the current page is not the rightmost page, merge curpage and next page
-				PIN(nextPid,nextPage);
+				PIN_TREE(nextPid,nextPage);
 				BTLeafPage* nextLeaf = (BTLeafPage *) nextPage;
 				PageID nextLink = nextLeaf->GetNextPage();
 				this->MergeLeaf_next(nextLeaf,leafPage);
+				TouchLeaf(nextPid);
 				leafPage->SetNextPage(nextLink);
 				deletedKey = nextKey;
-				UNPIN (nextPid,DIRTY);
+				UNPIN_TREE(nextPid,DIRTY);
 			}
 			else {
-				PIN(prevPid,prevPage);//if the current page is the rightmost page, merge curpage with prev page
+				PIN_TREE(prevPid,prevPage);//if the current page is the rightmost page, merge curpage with prev page
 				BTLeafPage* prevLeaf = (BTLeafPage *) prevPage;
 				PageID nextLink = leafPage->GetNextPage();
 				this->MergeLeaf_prev(prevLeaf,leafPage);
+				TouchLeaf(prevPid);
 				prevLeaf->SetNextPage(nextLink);
 				deletedKey = curKey;
-				UNPIN (prevPid,DIRTY);
+				UNPIN_TREE(prevPid,DIRTY);
 			}
 			
 		}		
 	}
-	UNPIN(curPid,DIRTY);
+	UNPIN_TREE(curPid,DIRTY);
 	return OK;
 }
 
@@ -851,8 +1390,60 @@ BTreeFile::MergeLeaf_prev(BTLeafPage* prevPage, BTLeafPage* curPage){
 IndexFileScan*
 BTreeFile::OpenScan(const int* lowKey, const int* highKey)
 {
+	return OpenScan(lowKey, highKey, nullptr, 0);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::OpenScan
+//
+// Input   : lowKey, highKey - as above.
+//           preds - residual predicates on the key, numPreds of them.
+//           ridRange - if not nullptr, only entries whose record id is
+//                      on a page in this range are returned.
+// Output  : None
+// Return  : A pointer to IndexFileScan class, nullptr if a predicate
+//           has an operator other than those KeyPredicate lists or a
+//           negative modulus.
+// Purpose : Initialize a scan that only returns the entries of
+//           [lowKey, highKey] satisfying every predicate.  The
+//           predicates are evaluated inside the leaf, so rejected
+//           entries never reach the caller.
+//-------------------------------------------------------------------
+
+IndexFileScan*
+BTreeFile::OpenScan(const int* lowKey, const int* highKey, const KeyPredicate* preds, int numPreds, const RidPageRange* ridRange)
+{
+	for (int i = 0; i < numPreds; i++){
+		switch (preds[i].op){
+			case aopEQ: case aopNE: case aopLT: case aopLE: case aopGT: case aopGE: case opRANGE:
+				break;
+			default:
+				return nullptr;
+		}
+		if (preds[i].modulus < 0){
+			return nullptr;
+		}
+	}
 	BTreeFileScan* scan = new BTreeFileScan();	
 	scan->btfile= this;
+	scan->scanned = false;
+	scan->preds.assign(preds, preds + numPreds);
+	scan->hasRidRange = (ridRange != nullptr);
+	if (ridRange != nullptr){
+		scan->ridRange = *ridRange;
+	}
+	scan->pathLen = 0;
+	scan->frozenPid = INVALID_PAGE;
+	scan->generation = generation;
+	scan->treeVersion = 0;
+	if (latches != nullptr){ //other threads keep inserting, so no bound is fixed to the keys there are now
+		scan->lowKey = (lowKey != nullptr) ? *lowKey : INT_MIN;
+		scan->highKey = (highKey != nullptr) ? *highKey : INT_MAX;
+		scan->treeVersion = ReadTreeVersion();
+		scan->curPid = FindPidWithKey(scan->lowKey);
+		scan->s = (scan->curPid == INVALID_PAGE) ? DONE : OK;
+		return scan;
+	}
     if (rootPid == INVALID_PAGE){
 		scan->lowKey = *lowKey;
 		scan->highKey = *highKey;
@@ -885,7 +1476,14 @@ BTreeFile::OpenScan(const int* lowKey, const int* highKey)
 		this->GetMaxKey(key_tmp);
 		scan->highKey = key_tmp;
 	}
-	scan->curPid=this->FindPidWithKey(*lowKey);
+	scan->pathLen = 0;
+	scan->pathVersion = structureVersion;
+	if (router != nullptr || swizzle != nullptr || frozen != nullptr){ //no path to remember, Seek routes again
+		scan->curPid=this->FindPidWithKey(*lowKey);
+	}
+	else{
+		scan->curPid=this->FindPidWithPath(*lowKey,scan->path,scan->pathLen);
+	}
 	scan->s=OK;
 	return scan;
 
@@ -899,6 +1497,26 @@ BTreeFile::FindPidWithKey(const int key){
 	if (curPid == INVALID_PAGE){
 		return INVALID_PAGE;
 	}
+	if (frozen != nullptr){
+		return frozen->Find(key);
+	}
+	if (latches != nullptr){ //other threads may be splitting pages, descend optimistically
+		Page* leafPage;
+		unsigned int treeVersion;
+		PageID pid = FindLeafLatched(key, BT_LATCH_NONE, leafPage, treeVersion);
+		if (pid != INVALID_PAGE && UnpinLatched(pid, BT_LATCH_NONE, CLEAN) != OK){
+			return INVALID_PAGE;
+		}
+		return pid;
+	}
+	if (router != nullptr){ //skip the index pages when the model is usable
+		if (router->IsCurrent(structureVersion) || BuildRouter() == OK){
+			return router->Route(key);
+		}
+	}
+	if (swizzle != nullptr){
+		return FindPidSwizzled(key);
+	}
 	SortedPage* curPage;
 	PIN(curPid,curPage);
 	if (curPage->GetType() == LEAF_NODE){
@@ -921,26 +1539,1484 @@ BTreeFile::FindPidWithKey(const int key){
 	return curPid;
 }
 //-------------------------------------------------------------------
-// BTreeFile::GetMinimumPid
+// BTreeFile::FindPidSwizzled
 //
-// Input   : None
+// Input   : key - the key to search for
 // Output  : None
-// Return  : the minimum Pid which is the leftmost child
-// Purpose : return the pid of the leftmost child
+// Return  : the pid of the leaf key belongs to, INVALID_PAGE on error.
+// Purpose : FindPidWithKey in main-memory mode.  Swizzled index pages
+//           are followed through their frames without a pin, and the
+//           leaf is not pinned once it is known to be one; only pages
+//           the table has not seen yet go through the buffer manager.
 //-------------------------------------------------------------------
-PageID 
-BTreeFile::GetMinimumPid(int & key, int & height ){
-	PageID curPid = this->rootPid;
-	if (curPid == INVALID_PAGE){
-		height = -1;
-		return curPid;
+
+PageID
+BTreeFile::FindPidSwizzled(const int key){
+	PageID curPid = rootPid;
+	while (true){
+		BTIndexPage* indexPage;
+		bool isLeaf, mustUnpin;
+		if (swizzle->Resolve(curPid, indexPage, isLeaf, mustUnpin) != OK){
+			return INVALID_PAGE;
+		}
+		if (isLeaf){
+			return curPid;
+		}
+		PageID childPid = indexPage->GetChild(indexPage->FindChildSlot(key));
+		if (mustUnpin && MINIBASE_BM->UnpinPage(curPid, CLEAN) != OK){
+			cerr << "Unable to unpin page " << curPid << endl;
+			return INVALID_PAGE;
+		}
+		curPid = childPid;
+	}
+}
+//-------------------------------------------------------------------
+// BTreeFile::FindPidWithPath
+//
+// Input   : key - the key to search for
+//           path, pathLen - a valid prefix of the path to key; the
+//                           search starts from path[pathLen-1], or
+//                           from the root when pathLen is 0.
+// Output  : path, pathLen - the full path from the root to the leaf,
+//                           with the key range of every node on it.
+// Return  : the pid of the leaf key belongs to.
+// Purpose : Descend to the leaf of key, remembering the way down so
+//           that a later search can restart from the lowest node that
+//           still covers its key.
+//-------------------------------------------------------------------
+
+PageID
+BTreeFile::FindPidWithPath(const int key, BTPathEntry* path, int& pathLen){
+	if (pathLen == 0){
+		if (rootPid == INVALID_PAGE){
+			return INVALID_PAGE;
+		}
+		path[0].pid = rootPid;
+		path[0].hasLow = false;
+		path[0].hasHigh = false;
+		pathLen = 1;
 	}
+	PageID curPid = path[pathLen-1].pid;
 	SortedPage* curPage;
 	PIN(curPid,curPage);
-	height = 0;
-	while (curPage->GetType() !=LEAF_NODE){
+	while (curPage->GetType() != LEAF_NODE){
+		if (pathLen == BT_MAX_HEIGHT){ //deeper than we can remember, finish without the path
+			UNPIN(curPid,CLEAN);
+			pathLen = 0;
+			return FindPidWithKey(key);
+		}
 		BTIndexPage* indexPage = (BTIndexPage *) curPage;
-		PageID pid_tmp = indexPage->GetLeftLink();
+		int childSlot = indexPage->FindChildSlot(key);
+		BTPathEntry& parent = path[pathLen-1];
+		BTPathEntry& child = path[pathLen];
+		child.pid = indexPage->GetChild(childSlot);
+		child.hasLow = (childSlot > 0) || parent.hasLow;
+		child.lowKey = (childSlot > 0) ? indexPage->GetEntry(childSlot-1)->key : parent.lowKey;
+		child.hasHigh = (childSlot < indexPage->GetNumOfRecords()) || parent.hasHigh;
+		child.highKey = (childSlot < indexPage->GetNumOfRecords()) ? indexPage->GetEntry(childSlot)->key : parent.highKey;
+		pathLen++;
+		UNPIN(curPid,CLEAN);
+		curPid = child.pid;
+		PIN(curPid,curPage);
+	}
+	UNPIN(curPid,CLEAN);
+	return curPid;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::Lookup
+//
+// Input   : key - the key to look up
+// Output  : rid - the record id stored with key
+// Return  : OK if found, DONE if key is not in the index.
+// Purpose : Point lookup.  With the adaptive hash index enabled, a hot
+//           key is served by pinning its leaf directly; otherwise, or
+//           when the cached position is stale, the tree is descended
+//           from the root and the lookup is counted towards making
+//           the key hot.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::Lookup(const int key, RecordID& rid)
+{
+	if (latches != nullptr){
+		return LookupLatched(key, rid);
+	}
+	PageID pid;
+	int slot;
+	BTLeafPage* leafPage;
+	if (frozen != nullptr){ //one pin, no index pages
+		BTFrozenPage* frozenPage;
+		pid = frozen->FindAny(key);
+		PIN(pid,frozenPage);
+		Status s = frozenPage->Find(key, rid);
+		UNPIN(pid,CLEAN);
+		return s;
+	}
+	if (ahi != nullptr && ahi->Probe(key, pid, slot)){
+		PIN(pid,leafPage);
+		if (slot < leafPage->GetNumOfRecords() && leafPage->GetEntry(slot)->key == key){
+			rid = leafPage->GetEntry(slot)->rid;
+			UNPIN(pid,CLEAN);
+			return OK;
+		}
+		UNPIN(pid,CLEAN);
+		ahi->Forget(key);
+	}
+
+	pid = FindPidWithKey(key);
+	if (pid == INVALID_PAGE){
+		return DONE;
+	}
+	PIN(pid,leafPage);
+	slot = leafPage->FindSlot(key);
+	if (slot >= leafPage->GetNumOfRecords() || leafPage->GetEntry(slot)->key != key){
+		UNPIN(pid,CLEAN);
+		return DONE;
+	}
+	rid = leafPage->GetEntry(slot)->rid;
+	UNPIN(pid,CLEAN);
+	if (ahi != nullptr){
+		ahi->RecordLookup(key, pid, slot);
+	}
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::EnableAdaptiveHash
+//
+// Input   : enable - whether to keep an adaptive hash index
+// Output  : None
+// Return  : None
+// Purpose : Turn the in-memory hash index over hot keys on or off.
+//           It starts empty and fills itself from Lookup statistics.
+//           Not available while concurrency is enabled.
+//-------------------------------------------------------------------
+
+void
+BTreeFile::EnableAdaptiveHash(bool enable)
+{
+	if (!enable){
+		delete ahi;
+		ahi = nullptr;
+	}
+	else if (ahi == nullptr && latches == nullptr){
+		ahi = new BTAdaptiveHash();
+	}
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::Freeze
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Rewrite the tree into the read-only frozen format: the
+//           leaf entries are compressed (BTFrozenPage) and packed
+//           100% full into one contiguous run of pages, and the index
+//           pages are replaced by an in-memory directory with the
+//           first key of every page.  Lookups and scans keep working
+//           through the same calls; Insert, Delete and UpdateRid fail
+//           from now on.  The file entry is moved to the first frozen
+//           page, so reopening the file finds the frozen tree.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::Freeze()
+{
+	if (frozen != nullptr){
+		return OK;
+	}
+	if (rootPid == INVALID_PAGE){
+		return FAIL;
+	}
+	AbortReorganize();
+	int key, height;
+	PageID firstLeaf = GetMinimumPid(key, height);
+
+	//first pass: count the pages the entries pack into, so that they
+	//can be allocated as one run
+	Page scratch;
+	BTFrozenPage* packer = (BTFrozenPage *) &scratch;
+	packer->InitFrozen(INVALID_PAGE);
+	int numPages = 1;
+	BTLeafPage* leafPage;
+	for (PageID pid = firstLeaf; pid != INVALID_PAGE; ){
+		PIN(pid,leafPage);
+		for (int i = 0; i < leafPage->GetNumOfRecords(); i++){
+			LeafEntry* entry = leafPage->GetEntry(i);
+			if (!packer->Append(entry->key, entry->rid)){
+				numPages++;
+				packer->InitFrozen(INVALID_PAGE);
+				packer->Append(entry->key, entry->rid);
+			}
+		}
+		PageID nextPid = leafPage->GetNextPage();
+		UNPIN(pid,CLEAN);
+		pid = nextPid;
+	}
+
+	//second pass: fill the run
+	PageID firstPid;
+	BTFrozenPage* page;
+	if (MINIBASE_BM->NewPage(firstPid, (Page *&) page, numPages) != OK){
+		cerr << "Unable to allocate " << numPages << " frozen pages" << endl;
+		return FAIL;
+	}
+	BTFrozenDirectory* directory = new BTFrozenDirectory();
+	PageID curPid = firstPid;
+	page->InitFrozen(curPid);
+	for (PageID pid = firstLeaf; pid != INVALID_PAGE; ){
+		PIN(pid,leafPage);
+		for (int i = 0; i < leafPage->GetNumOfRecords(); i++){
+			LeafEntry* entry = leafPage->GetEntry(i);
+			if (!page->Append(entry->key, entry->rid)){ //page is full, move on to the next one of the run
+				directory->Add(page->GetFirstKey(), page->GetLastKey(), curPid);
+				page->SetNextPage(curPid + 1);
+				UNPIN(curPid,DIRTY);
+				curPid++;
+				if (MINIBASE_BM->PinPage(curPid, (Page *&) page, true) != OK){
+					delete directory;
+					return FAIL;
+				}
+				page->InitFrozen(curPid);
+				page->SetPrevPage(curPid - 1);
+				page->Append(entry->key, entry->rid);
+			}
+		}
+		PageID nextPid = leafPage->GetNextPage();
+		UNPIN(pid,CLEAN);
+		pid = nextPid;
+	}
+	directory->Add(page->GetFirstKey(), page->GetLastKey(), curPid);
+	UNPIN(curPid,DIRTY);
+
+	//drop the old tree and point the file at the frozen one
+	ReleaseFrames();
+	if (DestroyFileHelper(rootPid) != OK || MINIBASE_BM->FreePage(rootPid) != OK){
+		cerr << "Unable to free the pages of the unfrozen tree" << endl;
+		delete directory;
+		return FAIL;
+	}
+	if (MINIBASE_DB->DeleteFileEntry(fname) != OK || MINIBASE_DB->AddFileEntry(fname, firstPid) != OK){
+		cerr << "unable to update the file entry of " << fname << endl;
+		delete directory;
+		return FAIL;
+	}
+	setRootPid(firstPid);
+	frozen = directory;
+	structureVersion++;
+	generation++;
+	if (ahi != nullptr){
+		ahi->Clear();
+	}
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::Reorganize
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Rebuild the whole tree in one go, see below.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::Reorganize()
+{
+	bool finished = false;
+	Status s = Reorganize(BT_REORG_FILL_FACTOR, 0, finished);
+	return (s == OK && finished) ? OK : FAIL;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::Reorganize
+//
+// Input   : fillFactor - fraction of each new page to fill, in (0, 1]
+//           pageBudget - most pages to read and write in this call;
+//                        0 or less for no limit
+// Output  : finished - true once the compacted tree has replaced the
+//                      old one
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Build a compacted copy of the tree, with its leaves in
+//           contiguous runs at fillFactor (BTBulkLoader), then switch
+//           rootPid and the file entry to the copy and free the old
+//           pages.  The copy is built a budget at a time across calls
+//           while the old tree keeps serving lookups, scans and
+//           updates; fillFactor is taken from the call that starts a
+//           copy.  Each call picks up after the last key copied, so
+//           updates above it reach the copy with the old leaves, and
+//           updates at or below it are logged (LogReorganize) and
+//           applied to the copy once it has replaced the old tree.  A
+//           run of equal keys is copied within one call.  The index
+//           levels of the copy are written by the last call on top of
+//           its budget, they are a small fraction of the leaves.  Open
+//           scans move over to the new tree on their next GetNext.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::Reorganize(const float fillFactor, const int pageBudget, bool& finished)
+{
+	finished = false;
+	if (rootPid == INVALID_PAGE || frozen != nullptr){ //nothing to rebuild, or read-only
+		return FAIL;
+	}
+	if (reorg == nullptr){
+		Status s;
+		reorg = new BTBulkLoader(s, fillFactor);
+		if (s != OK){
+			AbortReorganize();
+			return FAIL;
+		}
+		reorgCopied = false;
+	}
+
+	//copy old leaves until the budget is spent, at least one per call
+	const bool resumed = reorgCopied;
+	const int resumeKey = reorgKey; //entries up to here are in the copy
+	int key, height;
+	PageID curPid = resumed ? FindPidWithKey(resumeKey) : GetMinimumPid(key, height);
+	int used = 0;
+	while (curPid != INVALID_PAGE){
+		int pagesBefore = reorg->GetNumOfPages();
+		BTLeafPage* leafPage;
+		PIN(curPid,leafPage);
+		int numEntries = leafPage->GetNumOfRecords();
+		if (pageBudget > 0 && used >= pageBudget && (numEntries == 0 || leafPage->GetEntry(0)->key != reorgKey)){ //spent, and no run to finish
+			UNPIN(curPid,CLEAN);
+			return OK;
+		}
+		for (int i = 0; i < numEntries; i++){
+			LeafEntry* entry = leafPage->GetEntry(i);
+			if (resumed && entry->key <= resumeKey){ //copied by an earlier call
+				continue;
+			}
+			if (reorg->Add(entry->key, entry->rid) != OK){
+				UNPIN(curPid,CLEAN);
+				AbortReorganize();
+				return FAIL;
+			}
+			reorgKey = entry->key;
+			reorgCopied = true;
+		}
+		PageID nextPid = leafPage->GetNextPage();
+		UNPIN(curPid,CLEAN);
+		curPid = nextPid;
+		used += 1 + reorg->GetNumOfPages() - pagesBefore;
+	}
+
+	//switch to the copy, then drop the old tree and catch up on the log
+	PageID newRootPid;
+	if (reorg->Finish(newRootPid) != OK){
+		AbortReorganize();
+		return FAIL;
+	}
+	std::vector<BTReorgChange> changes;
+	changes.swap(reorgLog);
+	AbortReorganize(); //the finished loader no longer owns its pages
+	if (SwitchRoot(newRootPid) != OK){
+		return FAIL;
+	}
+	for (size_t i = 0; i < changes.size(); i++){
+		const BTReorgChange& c = changes[i];
+		Status s;
+		if (c.op == BT_REORG_INSERT){
+			s = InsertExclusive(c.key, c.rid);
+		}
+		else if (c.op == BT_REORG_DELETE){
+			s = DeleteExclusive(c.key, c.rid);
+		}
+		else{
+			s = UpdateRid(c.key, c.rid, c.newRid);
+		}
+		if (s != OK){
+			return FAIL;
+		}
+	}
+	finished = true;
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::LogReorganize
+//
+// Input   : op - the kind of change
+//           key, rid - the entry inserted, deleted or updated
+//           newRid - the record id an update repoints the entry to
+// Output  : None
+// Return  : None
+// Purpose : Record a change that succeeded on the old tree, if a
+//           Reorganize in progress has already copied key and would
+//           miss it.
+//-------------------------------------------------------------------
+
+void
+BTreeFile::LogReorganize(const BTReorgOp op, const int key, const RecordID rid, const RecordID newRid)
+{
+	if (reorg == nullptr || !reorgCopied || key > reorgKey){
+		return;
+	}
+	BTReorgChange change;
+	change.op = op;
+	change.key = key;
+	change.rid = rid;
+	change.newRid = newRid;
+	reorgLog.push_back(change);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::SaveRootPid
+//
+// Input   : pid - the new root
+// Output  : None
+// Return  : OK if successful, FAIL if the file entry cannot be
+//           updated.
+// Purpose : Make pid the root, and point the file entry at it, so
+//           that the tree is found again when the file is reopened.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::SaveRootPid(const PageID pid)
+{
+	setRootPid(pid);
+	if (latches != nullptr){ //the file entries live in pages of the global buffer manager
+		ConcurrentBufMgr::LockBase();
+	}
+	Status s = MINIBASE_DB->DeleteFileEntry(fname);
+	if (s == OK){
+		s = MINIBASE_DB->AddFileEntry(fname, pid);
+	}
+	if (latches != nullptr){
+		ConcurrentBufMgr::UnlockBase();
+	}
+	if (s != OK){
+		cerr << "unable to update the file entry of " << fname << endl;
+		return FAIL;
+	}
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::SwitchRoot
+//
+// Input   : newRootPid - root of a complete tree built on new pages
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Replace the whole tree: point the file entry and rootPid
+//           at the new root, then free every page of the old tree.
+//           Caches keyed by the old pages are dropped, and open scans
+//           re-route on their next call.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::SwitchRoot(PageID newRootPid)
+{
+	PageID oldRootPid = rootPid;
+	if (SaveRootPid(newRootPid) != OK){
+		setRootPid(oldRootPid);
+		return FAIL;
+	}
+	structureVersion++;
+	generation++;
+	if (ahi != nullptr){
+		ahi->Clear();
+	}
+	ReleaseFrames();
+	if (DestroyFileHelper(oldRootPid) != OK || MINIBASE_BM->FreePage(oldRootPid) != OK){
+		cerr << "Unable to free the pages of the old tree" << endl;
+		return FAIL;
+	}
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::MergeFrom
+//
+// Input   : other - another (updatable) B+ tree
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Fold all entries of other into this tree.  The two leaf
+//           chains are merged in one streaming pass into a freshly
+//           bulk-loaded tree, which replaces this tree; other is then
+//           destroyed.  Each page of either tree is read once and each
+//           new page written once.  On equal keys the entries of this
+//           tree come first.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::MergeFrom(BTreeFile& other)
+{
+	if (&other == this || rootPid == INVALID_PAGE || other.rootPid == INVALID_PAGE || frozen != nullptr || other.frozen != nullptr){
+		return FAIL;
+	}
+	AbortReorganize();
+	other.AbortReorganize();
+	Status s;
+	BTBulkLoader loader(s, BT_REORG_FILL_FACTOR);
+	if (s != OK){
+		return FAIL;
+	}
+	int key, height;
+	BTLeafChainReader mine, theirs;
+	if (mine.Open(GetMinimumPid(key, height)) != OK || theirs.Open(other.GetMinimumPid(key, height)) != OK){
+		return FAIL;
+	}
+	while (mine.IsValid() || theirs.IsValid()){
+		bool takeMine = !theirs.IsValid() || (mine.IsValid() && mine.GetEntry()->key <= theirs.GetEntry()->key);
+		BTLeafChainReader& from = takeMine ? mine : theirs;
+		if (loader.Add(from.GetEntry()->key, from.GetEntry()->rid) != OK || from.Next() != OK){
+			return FAIL;
+		}
+	}
+	PageID newRootPid;
+	if (loader.Finish(newRootPid) != OK){
+		return FAIL;
+	}
+	if (SwitchRoot(newRootPid) != OK){
+		return FAIL;
+	}
+	return other.DestroyFile();
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::CreateIndex
+//
+// Input   : heapPids - the pages of a heap file
+//           keyOffset - byte offset of the int key within its records
+//           nThreads - the number of threads to build with
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Replace the entries of the tree with the key and record id
+//           of every record of the heap file.  The new tree is built
+//           on nThreads threads (BTParallelBuilder) and then replaces
+//           the old one, which is left as it was if the build fails.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::CreateIndex(const std::vector<PageID>& heapPids, const int keyOffset, const int nThreads)
+{
+	if (rootPid == INVALID_PAGE || frozen != nullptr || keyOffset < 0){
+		return FAIL;
+	}
+	AbortReorganize();
+	BTParallelBuilder builder(nThreads, BT_REORG_FILL_FACTOR);
+	PageID newRootPid;
+	if (builder.Build(heapPids, keyOffset, newRootPid) != OK){
+		return FAIL;
+	}
+	return SwitchRoot(newRootPid);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::LoadFrozenDirectory
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Rebuild the in-memory directory of a frozen tree that is
+//           being reopened, by reading its pages in order.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::LoadFrozenDirectory()
+{
+	BTFrozenDirectory* directory = new BTFrozenDirectory();
+	for (PageID pid = rootPid; pid != INVALID_PAGE; ){
+		BTFrozenPage* page;
+		if (MINIBASE_BM->PinPage(pid, (Page *&) page) != OK){
+			delete directory;
+			return FAIL;
+		}
+		directory->Add(page->GetFirstKey(), page->GetLastKey(), pid);
+		PageID nextPid = page->GetNextPage();
+		MINIBASE_BM->UnpinPage(pid, CLEAN);
+		pid = nextPid;
+	}
+	delete frozen;
+	frozen = directory;
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::DumpFrozenStatistics
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : DumpStatistics for a frozen tree: the number of pages and
+//           entries, and how many bytes an entry takes.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::DumpFrozenStatistics()
+{
+	int num_entries = 0;
+	long num_bytes = 0;
+	for (int i = 0; i < frozen->GetNumOfPages(); i++){
+		BTFrozenPage* page;
+		PIN(frozen->GetPid(i),page);
+		num_entries += page->GetNumOfEntries();
+		num_bytes += page->GetUsedBytes();
+		UNPIN(frozen->GetPid(i),CLEAN);
+	}
+	cout << "\n---------------- Frozen tree, total number of pages: " << frozen->GetNumOfPages() << "-----------------------------" << endl;
+	cout << "\n---------------- Total number of leaf entries: " << num_entries << "-----------------------------" << endl;
+	cout << "\n---------------- Bytes per entry: " << (num_entries > 0 ? (float) num_bytes / num_entries : 0) << "-----------------------------" << endl;
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::EnableLearnedRouting
+//
+// Input   : enable - whether to route keys with a learned model
+// Output  : None
+// Return  : None
+// Purpose : Turn the learned router on or off.  While it is on, point
+//           lookups and scan starts go straight to the predicted leaf
+//           instead of descending through the index pages.  The model
+//           is built lazily on first use.  Not available while
+//           concurrency is enabled.
+//-------------------------------------------------------------------
+
+void
+BTreeFile::EnableLearnedRouting(bool enable)
+{
+	if (!enable){
+		delete router;
+		router = nullptr;
+	}
+	else if (router == nullptr && latches == nullptr){
+		router = new BTLearnedRouter();
+	}
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::EnableSwizzling
+//
+// Input   : enable - whether to run the index pages in main-memory mode
+//           maxPages - most index pages kept swizzled
+// Output  : None
+// Return  : None
+// Purpose : Turn pointer swizzling on or off.  While it is on, up to
+//           maxPages index pages stay pinned in the buffer pool and
+//           descents follow them by frame pointer instead of pinning
+//           every level (see BTSwizzleTable).  Turning it off gives
+//           the frames back.  Not available while concurrency is
+//           enabled.
+//-------------------------------------------------------------------
+
+void
+BTreeFile::EnableSwizzling(bool enable, const int maxPages)
+{
+	if (!enable){
+		delete swizzle;
+		swizzle = nullptr;
+	}
+	else if (swizzle == nullptr && latches == nullptr){
+		swizzle = new BTSwizzleTable(maxPages);
+	}
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::EnableConcurrency
+//
+// Input   : enable - whether several threads may use the tree at once
+//           poolFrames - frames of the tree's buffer pool
+// Output  : None
+// Return  : None
+// Purpose : Turn latching on or off.  While it is on, Insert, Delete,
+//           UpdateRid(s), Lookup, LookupBatch, Sample, ParallelScan,
+//           scans (GetNext, Seek, DeleteCurrent) and BTreeRange
+//           iterators may be used from any number of threads.
+//           Inserts and deletes that stay within one leaf only latch
+//           that leaf, so they run in parallel on different key
+//           ranges; the rare ones that split or merge pages latch the
+//           pages they write (see LatchPath), and the rest of the
+//           tree stays open.  Readers take no latches at all (see
+//           FindLeafLatched).  Pages are pinned through a
+//           ConcurrentBufMgr, which takes at most half of the free
+//           frames of the global pool.  The accelerators that keep
+//           shared state (adaptive hash, learned router, swizzling)
+//           are turned off.  Every other method, and the switch
+//           itself, still needs the tree to itself.
+//-------------------------------------------------------------------
+
+void
+BTreeFile::EnableConcurrency(bool enable, const int poolFrames)
+{
+	if (!enable){
+		delete latches;
+		latches = nullptr;
+		delete pool;
+		pool = nullptr;
+	}
+	else if (latches == nullptr){
+		EnableAdaptiveHash(false);
+		EnableLearnedRouting(false);
+		EnableSwizzling(false);
+		latches = new BTLatchTable(MINIBASE_DB->GetNumOfPages());
+		pool = new ConcurrentBufMgr(std::max(1, std::min(poolFrames, (int) MINIBASE_BM->GetNumOfUnpinnedFrames() / 2)));
+	}
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::LatchTree, BTreeFile::UnlatchTree
+//
+// Input   : exclusive - the mode of the tree latch
+// Output  : None
+// Return  : None
+// Purpose : Enter and leave the tree as a writer.  Shared mode lets a
+//           thread change the pages it latches, including splits and
+//           merges; exclusive mode keeps every other writer out, for
+//           creating the root or sweeping all leaves.  Nothing is done
+//           when concurrency is off.
+//-------------------------------------------------------------------
+
+void
+BTreeFile::LatchTree(const bool exclusive)
+{
+	if (latches != nullptr){
+		latches->GetTreeLatch().Lock(exclusive);
+	}
+}
+
+void
+BTreeFile::UnlatchTree(const bool exclusive)
+{
+	if (latches != nullptr){
+		latches->GetTreeLatch().Unlock(exclusive);
+	}
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::PinLatched, BTreeFile::UnpinLatched
+//
+// Input   : pid - the page
+//           mode - the latch to take on it along with the pin
+//           dirty - whether the page was changed
+// Output  : page - the pinned page
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Pin and latch a page, and unlatch and unpin it.  When
+//           concurrency is off these are plain PinPage and UnpinPage;
+//           when it is on the page comes from the tree's own pool.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::PinLatched(const PageID pid, Page*& page, const BTLatchMode mode)
+{
+	if (latches == nullptr){
+		PIN(pid,page);
+		return OK;
+	}
+	if (pool->PinPage(pid, page) != OK){
+		return FAIL;
+	}
+	if (mode != BT_LATCH_NONE){
+		latches->GetPageLatch(pid).Lock(mode == BT_LATCH_EXCLUSIVE);
+	}
+	return OK;
+}
+
+Status
+BTreeFile::UnpinLatched(const PageID pid, const BTLatchMode mode, const int dirty)
+{
+	if (latches == nullptr){
+		UNPIN(pid,dirty);
+		return OK;
+	}
+	if (mode != BT_LATCH_NONE){
+		latches->GetPageLatch(pid).Unlock(mode == BT_LATCH_EXCLUSIVE);
+	}
+	return pool->UnpinPage(pid, dirty);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::NewPageLatched
+//
+// Input   : None
+// Output  : pid - the page allocated
+//           page - the page, pinned
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Allocate a page, through the tree's pool when concurrency
+//           is on.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::NewPageLatched(PageID& pid, Page*& page)
+{
+	if (latches == nullptr){
+		NEWPAGE(pid,page);
+		return OK;
+	}
+	return pool->NewPage(pid, page);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::LatchPath, BTreeFile::UnlatchPath
+//
+// Input   : key - the key being inserted or deleted
+//           inserting - whether it is an insert or a delete
+// Output  : held - the pages latched, in the order they were latched
+// Return  : the highest page the insert or delete changes the
+//           structure below, INVALID_PAGE if a page cannot be pinned;
+//           for UnlatchPath, OK if successful, FAIL otherwise.
+// Purpose : Latch coupling for splits and merges.  The path of key is
+//           descended from the root, latching every page exclusively;
+//           the root is read again once latched, and the descent
+//           starts over if a root split or collapse replaced it.
+//           Once a page is safe, i.e. it will not split (it has room
+//           for one more entry) or underflow (it stays at least half
+//           full after a delete, or, for the root, keeps an entry),
+//           the pages above it are released, as nothing above it
+//           changes.  A delete also latches the siblings of every
+//           page below the root, left one first, as a merge or a
+//           redistribution may write them, and a split of the leaf
+//           its right neighbour, whose back link changes.  Pages are
+//           latched top-down, and left to right within a level, and
+//           no thread latches against that order, so two threads
+//           never wait for each other.  The caller runs the split or
+//           merge from the returned page; UnlatchPath then bumps the
+//           tree version, so optimistic readers that crossed the
+//           change read again, and releases the pages.
+//-------------------------------------------------------------------
+
+PageID
+BTreeFile::LatchPath(const int key, const bool inserting, std::vector<PageID>& held)
+{
+	SortedPage* curPage;
+	PageID curPid;
+	while (true){ //the root may change before it is latched
+		curPid = rootPid.load(std::memory_order_acquire);
+		if (curPid == INVALID_PAGE || PinLatched(curPid, (Page *&) curPage, BT_LATCH_EXCLUSIVE) != OK){
+			return INVALID_PAGE;
+		}
+		if (curPid == rootPid.load(std::memory_order_acquire)){
+			break;
+		}
+		UnpinLatched(curPid, BT_LATCH_EXCLUSIVE, CLEAN);
+	}
+	held.push_back(curPid);
+	PageID topPid = curPid;
+	while (true){
+		bool isIndex = (curPage->GetType() == INDEX_NODE);
+		bool safe;
+		if (inserting){
+			safe = (curPage->AvailableSpace() >= (int) (isIndex ? sizeof(IndexEntry) : sizeof(LeafEntry)));
+		}
+		else if (curPid == topPid && topPid == rootPid.load(std::memory_order_acquire)){
+			safe = (!isIndex || curPage->GetNumOfRecords() > 1);
+		}
+		else{
+			safe = isIndex ? ((BTIndexPage *) curPage)->IsAtLeastHalfFullAfterDelete() : ((BTLeafPage *) curPage)->IsAtLeastHalfFullAfterDelete();
+		}
+		if (safe && curPid != topPid){ //release the ancestors, and the siblings latched with it
+			std::vector<PageID> above;
+			for (size_t i = 0; i < held.size(); i++){
+				if (held[i] != curPid){
+					above.push_back(held[i]);
+				}
+			}
+			held.assign(1, curPid);
+			for (size_t i = 0; i < above.size(); i++){
+				UnpinLatched(above[i], BT_LATCH_EXCLUSIVE, CLEAN);
+			}
+			topPid = curPid;
+		}
+		if (!isIndex){
+			PageID nextPid = ((BTLeafPage *) curPage)->GetNextPage();
+			if (inserting && !safe && nextPid != INVALID_PAGE){
+				Page* nextPage;
+				if (PinLatched(nextPid, nextPage, BT_LATCH_EXCLUSIVE) != OK){
+					return INVALID_PAGE;
+				}
+				held.push_back(nextPid);
+			}
+			return topPid;
+		}
+		BTIndexPage* indexPage = (BTIndexPage *) curPage;
+		int curKey, nextKey;
+		PageID childPid, prevPid = INVALID_PAGE, nextPid = INVALID_PAGE;
+		RecordID dummy;
+		if (inserting){ //route as InsertHelper and DeleteHelper do
+			indexPage->FindPageWithKey(key, curKey, childPid, dummy);
+		}
+		else{
+			indexPage->FindPageWithKeys(key, curKey, nextKey, childPid, prevPid, nextPid, dummy);
+			if (prevPid == childPid){
+				prevPid = INVALID_PAGE;
+			}
+			if (nextPid == childPid){
+				nextPid = INVALID_PAGE;
+			}
+		}
+		PageID order[3] = { prevPid, childPid, nextPid };
+		for (int i = 0; i < 3; i++){
+			Page* page;
+			if (order[i] == INVALID_PAGE){
+				continue;
+			}
+			if (PinLatched(order[i], page, BT_LATCH_EXCLUSIVE) != OK){
+				return INVALID_PAGE;
+			}
+			held.push_back(order[i]);
+			if (order[i] == childPid){
+				curPage = (SortedPage *) page;
+			}
+		}
+		curPid = childPid;
+	}
+}
+
+Status
+BTreeFile::UnlatchPath(std::vector<PageID>& held)
+{
+	if (latches != nullptr){
+		latches->GetTreeLatch().Bump();
+	}
+	Status s = OK;
+	for (size_t i = 0; i < held.size(); i++){
+		if (UnpinLatched(held[i], BT_LATCH_EXCLUSIVE, CLEAN) != OK){
+			s = FAIL;
+		}
+	}
+	held.clear();
+	return s;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::ReadTreeVersion, BTreeFile::ValidateRead
+//
+// Input   : pid - a page read optimistically, INVALID_PAGE for none
+//           pageVersion - its version when the read started
+//           treeVersion - the tree version when the read started
+// Output  : None
+// Return  : The tree version; whether neither the tree nor the page
+//           was changed by a writer since the versions were taken.
+// Purpose : Optimistic reads.  A reader takes no latch: it notes the
+//           versions, reads, and starts over if they have moved on.
+//           The tree version moves on with every split and merge, so
+//           a page id read earlier is only followed while it holds.
+//           Without concurrency every read is valid.
+//-------------------------------------------------------------------
+
+unsigned int
+BTreeFile::ReadTreeVersion()
+{
+	return (latches != nullptr) ? latches->GetTreeLatch().ReadVersion() : 0;
+}
+
+bool
+BTreeFile::ValidateRead(const PageID pid, const unsigned int pageVersion, const unsigned int treeVersion)
+{
+	if (latches == nullptr){
+		return true;
+	}
+	return (pid == INVALID_PAGE || latches->GetPageLatch(pid).Validate(pageVersion)) && latches->GetTreeLatch().Validate(treeVersion);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::PinOptimistic
+//
+// Input   : pid - the page
+// Output  : page - the pinned page
+//           pageVersion - its version, for ValidateRead
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Pin a page for an optimistic read.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::PinOptimistic(const PageID pid, Page*& page, unsigned int& pageVersion)
+{
+	if (PinLatched(pid, page, BT_LATCH_NONE) != OK){
+		return FAIL;
+	}
+	pageVersion = (latches != nullptr) ? latches->GetPageLatch(pid).ReadVersion() : 0;
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::FindLeafLatched
+//
+// Input   : key - the key to search for
+//           mode - the latch to take on the leaf
+// Output  : leaf - the leaf, pinned and latched in mode
+//           treeVersion - the tree version the descent is valid for
+// Return  : the pid of the leaf key belongs to, INVALID_PAGE if the
+//           tree is empty or a page cannot be pinned.
+// Purpose : Descend without latching index pages.  Each index page is
+//           read optimistically, and the child read from it is only
+//           followed if neither the page nor the tree version moved
+//           meanwhile; a latched leaf is checked against the tree
+//           version once more after the latch is taken, since a split
+//           or merge that got in between may have moved key to
+//           another leaf.  The descent starts over when either check
+//           fails.  The tree version is read before rootPid: a root
+//           change is published before the version is bumped, so a
+//           reader that started at the old root fails the check.
+//-------------------------------------------------------------------
+
+PageID
+BTreeFile::FindLeafLatched(const int key, const BTLatchMode mode, Page*& leaf, unsigned int& treeVersion)
+{
+	bool restart = true;
+	PageID curPid = INVALID_PAGE;
+	while (restart){
+		restart = false;
+		treeVersion = ReadTreeVersion();
+		curPid = (frozen != nullptr) ? frozen->Find(key) : rootPid.load(std::memory_order_acquire);
+		while (curPid != INVALID_PAGE){
+			unsigned int pageVersion;
+			if (PinOptimistic(curPid, leaf, pageVersion) != OK){
+				return INVALID_PAGE;
+			}
+			SortedPage* curPage = (SortedPage *) leaf;
+			if (curPage->GetType() != INDEX_NODE){
+				if (mode != BT_LATCH_NONE){
+					latches->GetPageLatch(curPid).Lock(mode == BT_LATCH_EXCLUSIVE);
+				}
+				if (ValidateRead(INVALID_PAGE, 0, treeVersion)){
+					return curPid;
+				}
+				UnpinLatched(curPid, mode, CLEAN);
+				restart = true;
+				break;
+			}
+			BTIndexPage* indexPage = (BTIndexPage *) curPage;
+			bool readable = (indexPage->GetNumOfRecords() <= indexPage->GetMaxNumOfRecords()); //a split may be writing it
+			PageID childPid = readable ? indexPage->GetChild(indexPage->FindChildSlot(key)) : INVALID_PAGE;
+			bool valid = readable && ValidateRead(curPid, pageVersion, treeVersion);
+			if (UnpinLatched(curPid, BT_LATCH_NONE, CLEAN) != OK){
+				return INVALID_PAGE;
+			}
+			if (!valid){
+				restart = true;
+				break;
+			}
+			curPid = childPid;
+		}
+	}
+	return curPid;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::LookupLatched
+//
+// Input   : key - the key to look up
+// Output  : rid - the record id stored with key
+// Return  : OK if found, DONE if key is not in the index, FAIL on
+//           error.
+// Purpose : Lookup with other threads in the tree.  The leaf is read
+//           optimistically, and read again if a writer changed it
+//           or the tree meanwhile.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::LookupLatched(const int key, RecordID& rid)
+{
+	while (true){
+		Page* page;
+		unsigned int treeVersion, pageVersion;
+		PageID pid = FindLeafLatched(key, BT_LATCH_NONE, page, treeVersion);
+		if (pid == INVALID_PAGE){
+			return (rootPid == INVALID_PAGE) ? DONE : FAIL;
+		}
+		pageVersion = latches->GetPageLatch(pid).ReadVersion();
+		Status s = DONE;
+		RecordID found;
+		if (frozen != nullptr){
+			s = ((BTFrozenPage *) page)->Find(key, found);
+		}
+		else{
+			BTLeafPage* leafPage = (BTLeafPage *) page;
+			int slot = leafPage->FindSlot(key);
+			if (slot < leafPage->GetNumOfRecords() && leafPage->GetEntry(slot)->key == key){
+				found = leafPage->GetEntry(slot)->rid;
+				s = OK;
+			}
+		}
+		bool valid = ValidateRead(pid, pageVersion, treeVersion);
+		if (UnpinLatched(pid, BT_LATCH_NONE, CLEAN) != OK){
+			return FAIL;
+		}
+		if (valid){
+			if (s == OK){
+				rid = found;
+			}
+			return s;
+		}
+	}
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::BuildRouter
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Refit the learned router from the separators of the index
+//           pages.  Only index pages are read, leaves are not pinned.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::BuildRouter()
+{
+	std::vector<int> lowKeys;
+	std::vector<PageID> pids;
+	if (CollectLeafBounds(rootPid, INT_MIN, lowKeys, pids) != OK){
+		router->Clear();
+		return FAIL;
+	}
+	router->Build(lowKeys, pids, structureVersion);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::CollectLeafBounds
+//
+// Input   : pid - root of the subtree to collect
+//           lowKey - lowest key routed to the subtree
+// Output  : lowKeys, pids - the leaves of the subtree and the lowest
+//                           key routed to each, appended in key order
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Collect the key -> leaf mapping the router is fitted to.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::CollectLeafBounds(PageID pid, const int lowKey, std::vector<int>& lowKeys, std::vector<PageID>& pids)
+{
+	SortedPage* curPage;
+	PIN(pid,curPage);
+	if (curPage->GetType() == LEAF_NODE){
+		UNPIN(pid,CLEAN);
+		lowKeys.push_back(lowKey);
+		pids.push_back(pid);
+		return OK;
+	}
+	BTIndexPage* indexPage = (BTIndexPage *) curPage;
+	int numEntries = indexPage->GetNumOfRecords();
+	std::vector<int> childKeys(1, lowKey);
+	std::vector<PageID> childPids(1, indexPage->GetLeftLink());
+	for (int i = 0; i < numEntries; i++){
+		childKeys.push_back(indexPage->GetEntry(i)->key);
+		childPids.push_back(indexPage->GetEntry(i)->pid);
+	}
+	UNPIN(pid,CLEAN);
+	for (size_t c = 0; c < childPids.size(); c++){
+		if (CollectLeafBounds(childPids[c], childKeys[c], lowKeys, pids) != OK){
+			return FAIL;
+		}
+	}
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::LookupBatch
+//
+// Input   : keys - the keys to look up
+//           n - number of keys
+// Output  : out - out[i] is the record id stored with keys[i]
+//           found - found[i] is true if keys[i] is in the index
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Point lookup of a whole batch of keys.  The probes are
+//           sorted and routed down the tree together, so an index page
+//           shared by several probes is pinned once per batch rather
+//           than once per key.  With concurrency on every key is
+//           looked up by LookupLatched instead.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::LookupBatch(const int* keys, int n, RecordID* out, bool* found)
+{
+	for (int i = 0; i < n; i++){
+		out[i].pageNo = INVALID_PAGE;
+		out[i].slotNo = INVALID_SLOT;
+		found[i] = false;
+	}
+	if (rootPid == INVALID_PAGE || n <= 0){
+		return OK;
+	}
+	if (latches != nullptr){ //the pages may change under a shared descent, look up one key at a time
+		for (int i = 0; i < n; i++){
+			Status s = LookupLatched(keys[i], out[i]);
+			if (s == FAIL){
+				return FAIL;
+			}
+			found[i] = (s == OK);
+		}
+		return OK;
+	}
+	std::vector<int> order(n); //probe positions sorted by key
+	for (int i = 0; i < n; i++){
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [keys](int a, int b) { return keys[a] < keys[b]; });
+	if (router != nullptr || swizzle != nullptr || frozen != nullptr){ //route every probe, then visit each leaf once
+		int runStart = 0;
+		PageID runPid = (frozen != nullptr) ? frozen->FindAny(keys[order[0]]) : FindPidWithKey(keys[order[0]]);
+		for (int i = 1; i <= n; i++){
+			PageID pid = INVALID_PAGE;
+			if (i < n){
+				pid = (frozen != nullptr) ? frozen->FindAny(keys[order[i]]) : FindPidWithKey(keys[order[i]]);
+			}
+			if (pid != runPid){
+				SortedPage* runPage;
+				PIN(runPid,runPage);
+				if (LookupBatchHelper(runPid, runPage, keys, order.data(), runStart, i, out, found) != OK){
+					return FAIL;
+				}
+				runStart = i;
+				runPid = pid;
+			}
+		}
+		return OK;
+	}
+	SortedPage* rootPage;
+	PIN(rootPid,rootPage);
+	return LookupBatchHelper(rootPid, rootPage, keys, order.data(), 0, n, out, found);
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::LookupBatchHelper
+//
+// Input   : pid - the page the probes order[lo..hi) are routed to
+//           curPage - the page, pinned; it is unpinned here
+//           keys, order - the probe keys and their sorted positions
+// Output  : out, found - results for the probes in order[lo..hi)
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Route a sorted run of probes through the subtree at pid.
+//           An index page is pinned once, split into one run per
+//           child, and released before descending into the children.
+//           The child of the next run is pinned and prefetched before
+//           the current run descends, so its first cache lines load
+//           while the current subtree is searched.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::LookupBatchHelper(PageID pid, SortedPage* curPage, const int* keys, const int* order, int lo, int hi, RecordID* out, bool* found)
+{
+	if (curPage->GetType() == INDEX_NODE){
+		BTIndexPage* indexPage = (BTIndexPage *) curPage;
+		std::vector<PageID> childPids;
+		std::vector<int> runEnds;
+		int i = lo;
+		while (i < hi){ //the probes of one child are adjacent as they are sorted
+			int childSlot = indexPage->FindChildSlot(keys[order[i]]);
+			int j = i + 1;
+			if (childSlot == indexPage->GetNumOfRecords()){
+				j = hi;
+			}
+			else{
+				int bound = indexPage->GetEntry(childSlot)->key;
+				while (j < hi && keys[order[j]] < bound){
+					j++;
+				}
+			}
+			childPids.push_back(indexPage->GetChild(childSlot));
+			runEnds.push_back(j);
+			i = j;
+		}
+		UNPIN(pid,CLEAN);
+		SortedPage* child;
+		PIN(childPids[0],child);
+		int runStart = lo;
+		for (size_t c = 0; c < childPids.size(); c++){
+			SortedPage* next = nullptr;
+			if (c + 1 < childPids.size()){
+				if (MINIBASE_BM->PinPage(childPids[c + 1], (Page *&) next) != OK){
+					cerr << "Unable to pin page " << childPids[c + 1] << endl;
+					MINIBASE_BM->UnpinPage(childPids[c], CLEAN);
+					return FAIL;
+				}
+				next->Prefetch();
+			}
+			if (LookupBatchHelper(childPids[c], child, keys, order, runStart, runEnds[c], out, found) != OK){
+				if (next != nullptr){
+					MINIBASE_BM->UnpinPage(childPids[c + 1], CLEAN);
+				}
+				return FAIL;
+			}
+			child = next;
+			runStart = runEnds[c];
+		}
+		return OK;
+	}
+	if (curPage->GetType() == FROZEN_NODE){ //decode the page once for all of its probes
+		std::vector<LeafEntry> entries;
+		((BTFrozenPage *) curPage)->Decode(entries);
+		UNPIN(pid,CLEAN);
+		for (int i = lo; i < hi; i++){
+			std::vector<LeafEntry>::iterator it = std::lower_bound(entries.begin(), entries.end(), keys[order[i]],
+				[](const LeafEntry& e, int k) { return e.key < k; });
+			if (it != entries.end() && it->key == keys[order[i]]){
+				out[order[i]] = it->rid;
+				found[order[i]] = true;
+			}
+		}
+		return OK;
+	}
+	//case when curPage is leaf node, the probes are searched left to right
+	BTLeafPage* leafPage = (BTLeafPage *) curPage;
+	int slot = 0;
+	for (int i = lo; i < hi; i++){
+		slot = leafPage->FindSlot(keys[order[i]], slot);
+		if (slot < leafPage->GetNumOfRecords() && leafPage->GetEntry(slot)->key == keys[order[i]]){
+			out[order[i]] = leafPage->GetEntry(slot)->rid;
+			found[order[i]] = true;
+		}
+	}
+	UNPIN(pid,CLEAN);
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::Sample
+//
+// Input   : n - number of samples wanted
+//           seed - seed of the random walks, equal seeds give equal
+//                  samples of an unchanged tree
+//           lowKey, highKey - pointer to keys, restrict the samples to
+//                             lowKey <= key <= highKey; nullptr leaves
+//                             that end open.
+// Output  : samples - the sampled entries, drawn with replacement
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Draw uniform random entries without scanning.  Every
+//           sample is a random root-to-leaf walk with acceptance-
+//           rejection on the fanout: a node picks one of its children
+//           in range with probability 1/maxFanout each and rejects the
+//           walk with the rest, so each entry is reached with the same
+//           probability however full the nodes are.  A walk costs at
+//           most one pin per level.  Fewer than n samples are returned
+//           only when BT_SAMPLE_MAX_WALKS walks per sample were not
+//           enough, i.e. the range holds (almost) no entries.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::Sample(const int n, const unsigned int seed, std::vector<LeafEntry>& samples, const int* lowKey, const int* highKey)
+{
+	samples.clear();
+	if (rootPid == INVALID_PAGE || frozen != nullptr){ //frozen pages hold a varying number of entries
+		return FAIL;
+	}
+	int low = (lowKey != nullptr) ? *lowKey : INT_MIN;
+	int high = (highKey != nullptr) ? *highKey : INT_MAX;
+	if (n <= 0 || low > high){
+		return OK;
+	}
+	std::mt19937 rng(seed);
+	long maxWalks = (long) n * BT_SAMPLE_MAX_WALKS;
+	for (long walk = 0; (int) samples.size() < n && walk < maxWalks; walk++){
+		LeafEntry entry;
+		bool accepted;
+		if (SampleWalk(rng, low, high, entry, accepted) != OK){
+			return FAIL;
+		}
+		if (accepted){
+			samples.push_back(entry);
+		}
+	}
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::SampleWalk
+//
+// Input   : rng - the random generator of the sample
+//           lowKey, highKey - the key range, inclusive
+// Output  : entry - the entry reached, if accepted
+//           accepted - false if the walk was rejected on the way
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : One random root-to-leaf walk of Sample.  Every page is
+//           read optimistically, and with concurrency on a walk that
+//           a writer got in the way of is started over.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::SampleWalk(std::mt19937& rng, const int lowKey, const int highKey, LeafEntry& entry, bool& accepted)
+{
+	while (true){
+		accepted = false;
+		unsigned int treeVersion = ReadTreeVersion();
+		PageID curPid = rootPid;
+		SortedPage* curPage;
+		unsigned int pageVersion;
+		if (PinOptimistic(curPid, (Page *&) curPage, pageVersion) != OK){
+			return FAIL;
+		}
+		bool isRoot = true;
+		bool valid = true;
+		while (curPage->GetType() == INDEX_NODE){
+			BTIndexPage* indexPage = (BTIndexPage *) curPage;
+			if (indexPage->GetNumOfRecords() > indexPage->GetMaxNumOfRecords()){ //a split is writing it
+				valid = false;
+				break;
+			}
+			int first = indexPage->FindChildSlot(lowKey);
+			int last = indexPage->FindChildSlot(highKey);
+			//every walk passes the root, so its own fanout is as good a bound
+			int maxFanout = isRoot ? last - first + 1 : indexPage->GetMaxNumOfRecords() + 1;
+			isRoot = false;
+			int pick = std::uniform_int_distribution<int>(0, maxFanout - 1)(rng);
+			PageID childPid = (pick > last - first) ? INVALID_PAGE : indexPage->GetChild(first + pick);
+			valid = ValidateRead(curPid, pageVersion, treeVersion);
+			if (!valid || childPid == INVALID_PAGE){
+				break;
+			}
+			if (UnpinLatched(curPid, BT_LATCH_NONE, CLEAN) != OK){
+				return FAIL;
+			}
+			curPid = childPid;
+			if (PinOptimistic(curPid, (Page *&) curPage, pageVersion) != OK){
+				return FAIL;
+			}
+		}
+		if (valid && curPage->GetType() != INDEX_NODE){
+			BTLeafPage* leafPage = (BTLeafPage *) curPage;
+			int slot = std::uniform_int_distribution<int>(0, leafPage->GetMaxNumOfRecords() - 1)(rng);
+			if (slot < leafPage->GetNumOfRecords()){
+				LeafEntry* e = leafPage->GetEntry(slot);
+				if (e->key >= lowKey && e->key <= highKey){
+					entry = *e;
+					accepted = true;
+				}
+			}
+			valid = ValidateRead(curPid, pageVersion, treeVersion);
+		}
+		if (UnpinLatched(curPid, BT_LATCH_NONE, CLEAN) != OK){
+			return FAIL;
+		}
+		if (valid){
+			return OK;
+		}
+	}
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::GetMinimumPid
+//
+// Input   : None
+// Output  : None
+// Return  : the minimum Pid which is the leftmost child
+// Purpose : return the pid of the leftmost child
+//-------------------------------------------------------------------
+PageID 
+BTreeFile::GetMinimumPid(int & key, int & height ){
+	PageID curPid = this->rootPid;
+	if (curPid == INVALID_PAGE){
+		height = -1;
+		return curPid;
+	}
+	if (frozen != nullptr){
+		key = frozen->GetFirstKey();
+		height = 1;
+		return frozen->GetFirstPid();
+	}
+	SortedPage* curPage;
+	PIN(curPid,curPage);
+	height = 0;
+	while (curPage->GetType() !=LEAF_NODE){
+		BTIndexPage* indexPage = (BTIndexPage *) curPage;
+		PageID pid_tmp = indexPage->GetLeftLink();
 		UNPIN(curPid,CLEAN);
 		curPid = pid_tmp;
 		height = height+1;
@@ -959,6 +3035,10 @@ BTreeFile::GetMaxKey(int & key){
 	if (curPid == INVALID_PAGE){
 		return curPid;
 	}
+	if (frozen != nullptr){
+		key = frozen->GetLastKey();
+		return frozen->GetLastPid();
+	}
 	SortedPage* curPage;
 	PIN(curPid,curPage);
 	while (curPage->GetType() !=LEAF_NODE){
@@ -1076,6 +3156,22 @@ BTreeFile::PrintNode(PageID pageID)
 			cout << "\n This page contains  " << i << "  entries." << endl;
 			break;
 		}
+
+		case FROZEN_NODE:
+		{
+			std::vector<LeafEntry> entries;
+			((BTFrozenPage *) page)->Decode(entries);
+			cout << "\n---------------- Content of frozen node " << pageID << "-----------------------------" << endl;
+			for (size_t i = 0; i < entries.size(); i++)
+			{
+				cout << "DataRecord ID: " << entries[i].rid << " Key: " << entries[i].key << endl;
+			}
+			cout << "\n This page contains  " << entries.size() << "  entries." << endl;
+			break;
+		}
+
+		default: //pages of a BTreeKVFile are not part of a BTreeFile
+			break;
 	}
 	UNPIN(pageID, CLEAN);
 
@@ -1096,6 +3192,13 @@ BTreeFile::Print()
 {
 	cout << "\n\n-------------- Now Begin Printing a new whole B+ Tree -----------" << endl;
 
+	if (frozen != nullptr){
+		for (int i = 0; i < frozen->GetNumOfPages(); i++){
+			PrintNode(frozen->GetPid(i));
+		}
+		return OK;
+	}
+
 	if (PrintTree(rootPid) == OK)
 		return OK;
 
@@ -1120,6 +3223,9 @@ Status
 BTreeFile::DumpStatistics()
 {
 	// TODO: add your code here
+	if (frozen != nullptr){
+		return DumpFrozenStatistics();
+	}
 	//print out the total number of nodes;
 	SortedPage * rootPage;
 	PIN(rootPid,rootPage);
@@ -1249,4 +3355,239 @@ BTreeFile::Sum_leaf_nodes(PageID pid, int& nodes, int& num_of_records, float& su
 	}
 	
 	return OK;
-}
\ No newline at end of file
+}
+//-------------------------------------------------------------------
+// BTreeFile::ParallelScan
+//
+// Input   : lowKey, highKey - pointer to keys, the range to scan;
+//                             nullptr leaves that end open
+//           nThreads - most threads to scan with
+//           callback - called as callback(part, key, rid) for every
+//                      entry of the range
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Scan a range on several threads.  The range is cut into at
+//           most nThreads partitions at separators of the upper index
+//           levels (see SplitRange), and each partition is scanned by
+//           a thread of its own with its own cursor.  The entries of
+//           a partition reach callback in key order, from the thread
+//           of the partition, and every key of partition part is less
+//           than those of part + 1: a consumer per partition needs no
+//           latch, and reading the consumers in partition order gives
+//           the range in key order.
+//
+//           With concurrency on, each thread runs a scan of its
+//           partition, and writers may go on meanwhile.  Otherwise the
+//           tree must not change during the scan, and the threads pin
+//           the leaves through a ConcurrentBufMgr of their own.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::ParallelScan(const int* lowKey, const int* highKey, int nThreads, const BTScanCallback& callback)
+{
+	int low = (lowKey != nullptr) ? *lowKey : INT_MIN;
+	int high = (highKey != nullptr) ? *highKey : INT_MAX;
+	if (rootPid == INVALID_PAGE || low > high){
+		return OK;
+	}
+	std::vector<int> bounds;
+	Status s = SplitRange(low, high, std::max(1, nThreads), bounds);
+	if (s != OK){
+		return FAIL;
+	}
+	int nParts = (int) bounds.size() + 1;
+	std::vector<int> lows(1, low), highs;
+	for (size_t i = 0; i < bounds.size(); i++){
+		highs.push_back(bounds[i] - 1);
+		lows.push_back(bounds[i]);
+	}
+	highs.push_back(high);
+
+	ConcurrentBufMgr* scanPool = nullptr;
+	std::vector<PageID> startPids(nParts, INVALID_PAGE);
+	if (latches == nullptr){ //the workers may not use MINIBASE_BM, find their first leaves here
+		for (int p = 0; p < nParts; p++){
+			startPids[p] = FindPidWithKey((lows[p] > INT_MIN) ? lows[p] - 1 : lows[p]); //a run of lows[p] may begin left of its separator
+		}
+		scanPool = new ConcurrentBufMgr(std::max(nParts, std::min(CBM_NUM_FRAMES, (int) MINIBASE_BM->GetNumOfUnpinnedFrames() / 2)));
+	}
+	std::vector<Status> results(nParts, OK);
+	std::vector<std::thread> workers;
+	for (int p = 0; p < nParts; p++){
+		workers.push_back(std::thread([&, p]() {
+			results[p] = (scanPool != nullptr) ? ScanPartition(scanPool, startPids[p], p, lows[p], highs[p], callback)
+				: ScanPartitionLatched(p, lows[p], highs[p], callback);
+		}));
+	}
+	for (size_t i = 0; i < workers.size(); i++){
+		workers[i].join();
+	}
+	delete scanPool;
+	for (int p = 0; p < nParts; p++){
+		if (results[p] != OK){
+			return FAIL;
+		}
+	}
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::SplitRange
+//
+// Input   : lowKey, highKey - the range, inclusive
+//           nParts - most partitions wanted
+// Output  : bounds - the first key of every partition but the first,
+//                    ascending, all in (lowKey, highKey]
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Cut a range into partitions of about as many leaves each.
+//           The index levels are read top-down, collecting the
+//           separators that fall into the range, until there are
+//           BT_SCAN_SEPARATORS_PER_PART of them per partition, and
+//           nParts - 1 evenly spaced ones are picked.  Only the pages
+//           in the range are read, so the pages of a level are
+//           bounded by the separators found above it.  A frozen tree
+//           uses the first keys of its pages.  Fewer partitions are
+//           made when the range spans fewer leaves.  The pages are
+//           read optimistically, and read again from the root if a
+//           split or merge got in the way.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::SplitRange(const int lowKey, const int highKey, const int nParts, std::vector<int>& bounds)
+{
+	bounds.clear();
+	std::vector<int> seps;
+	if (frozen != nullptr){
+		for (int i = 1; i < frozen->GetNumOfPages(); i++){
+			int key = frozen->GetFirstKey(i);
+			if (key > lowKey && key <= highKey && (seps.empty() || key > seps.back())){
+				seps.push_back(key);
+			}
+		}
+	}
+	else{
+		bool restart = true;
+		while (restart){ //a split or merge got in the way, read the levels again
+			restart = false;
+			seps.clear();
+			unsigned int treeVersion = ReadTreeVersion();
+			std::vector<PageID> level(1, rootPid);
+			while ((int) seps.size() < (nParts - 1) * BT_SCAN_SEPARATORS_PER_PART && !level.empty()){
+				std::vector<PageID> children;
+				std::vector<int> levelSeps;
+				for (size_t i = 0; i < level.size(); i++){
+					SortedPage* curPage;
+					unsigned int pageVersion;
+					if (PinOptimistic(level[i], (Page *&) curPage, pageVersion) != OK){
+						return FAIL;
+					}
+					if (curPage->GetType() != INDEX_NODE){ //reached the leaves
+						UnpinLatched(level[i], BT_LATCH_NONE, CLEAN);
+						children.clear();
+						break;
+					}
+					BTIndexPage* indexPage = (BTIndexPage *) curPage;
+					bool readable = (indexPage->GetNumOfRecords() <= indexPage->GetMaxNumOfRecords());
+					int first = readable ? indexPage->FindChildSlot(lowKey) : 0;
+					int last = readable ? indexPage->FindChildSlot(highKey) : -1;
+					for (int c = first; c <= last; c++){
+						if (c > first){
+							levelSeps.push_back(indexPage->GetEntry(c - 1)->key);
+						}
+						children.push_back(indexPage->GetChild(c));
+					}
+					restart = !readable || !ValidateRead(level[i], pageVersion, treeVersion);
+					if (UnpinLatched(level[i], BT_LATCH_NONE, CLEAN) != OK){
+						return FAIL;
+					}
+					if (restart){
+						break;
+					}
+				}
+				if (restart || children.empty()){
+					break;
+				}
+				std::vector<int> merged;
+				std::merge(seps.begin(), seps.end(), levelSeps.begin(), levelSeps.end(), std::back_inserter(merged));
+				seps.swap(merged);
+				level.swap(children);
+			}
+		}
+	}
+	for (int p = 1; p < nParts && !seps.empty(); p++){
+		int key = seps[(size_t) p * seps.size() / nParts];
+		if (bounds.empty() || key > bounds.back()){
+			bounds.push_back(key);
+		}
+	}
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::ScanPartition
+//
+// Input   : scanPool - the pool to pin the leaves through
+//           pid - the leaf lowKey belongs to
+//           part - the partition, passed on to callback
+//           lowKey, highKey - the partition, inclusive
+//           callback - as for ParallelScan
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : The cursor of one ParallelScan thread on a tree that does
+//           not change: walk the leaf chain from pid to highKey.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::ScanPartition(ConcurrentBufMgr* scanPool, PageID pid, const int part, const int lowKey, const int highKey, const BTScanCallback& callback)
+{
+	std::vector<LeafEntry> frozenEntries;
+	while (pid != INVALID_PAGE){
+		SortedPage* curPage;
+		if (scanPool->PinPage(pid, (Page *&) curPage) != OK){
+			return FAIL;
+		}
+		BTLeafPage* leafPage = (BTLeafPage *) curPage;
+		bool isFrozen = (curPage->GetType() == FROZEN_NODE);
+		if (isFrozen){
+			((BTFrozenPage *) curPage)->Decode(frozenEntries);
+		}
+		int numEntries = isFrozen ? (int) frozenEntries.size() : leafPage->GetNumOfRecords();
+		int slot = isFrozen ? (int) (std::lower_bound(frozenEntries.begin(), frozenEntries.end(), lowKey,
+			[](const LeafEntry& e, int k) { return e.key < k; }) - frozenEntries.begin()) : leafPage->FindSlot(lowKey);
+		for (; slot < numEntries; slot++){
+			LeafEntry* entry = isFrozen ? &frozenEntries[slot] : leafPage->GetEntry(slot);
+			if (entry->key > highKey){
+				return scanPool->UnpinPage(pid, CLEAN);
+			}
+			callback(part, entry->key, entry->rid);
+		}
+		PageID nextPid = leafPage->GetNextPage();
+		if (scanPool->UnpinPage(pid, CLEAN) != OK){
+			return FAIL;
+		}
+		pid = nextPid;
+	}
+	return OK;
+}
+
+//-------------------------------------------------------------------
+// BTreeFile::ScanPartitionLatched
+//
+// Input   : part - the partition, passed on to callback
+//           lowKey, highKey - the partition, inclusive
+//           callback - as for ParallelScan
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : The cursor of one ParallelScan thread with concurrency on:
+//           a BTreeRange over the partition, which reads the leaves
+//           optimistically and, unlike OpenScan, returns duplicates.
+//-------------------------------------------------------------------
+
+Status
+BTreeFile::ScanPartitionLatched(const int part, const int lowKey, const int highKey, const BTScanCallback& callback)
+{
+	for (const LeafEntry& e : BTreeRange(*this, &lowKey, &highKey)){
+		callback(part, e.key, e.rid);
+	}
+	return OK;
+}
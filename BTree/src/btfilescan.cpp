@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "minirel.h"
 #include "bufmgr.h"
 #include "db.h"
@@ -5,6 +7,10 @@
 #include "btfile.h"
 #include "btfilescan.h"
 
+// Number of leaves Seek walks along the sibling links before it falls
+// back to climbing the cached path.
+const int SEEK_SIBLING_HOPS = 3;
+
 //-------------------------------------------------------------------
 // BTreeFileScan::~BTreeFileScan
 //
@@ -35,80 +41,239 @@ BTreeFileScan::GetNext(RecordID& rid, int& key)
     if (this->s == DONE){
         return this->s;
     }
-    PageID pid = this->curPid;
-    if (pid == INVALID_PAGE){
-        this-> s = DONE;
-        return this->s;
+    if (this->generation != this->btfile->generation){ //the tree was rebuilt, the old leaves are gone
+        this->curPid = this->btfile->FindPidWithKey(this->lowKey);
+        this->pathLen = 0;
+        this->frozenPid = INVALID_PAGE;
+        this->generation = this->btfile->generation;
     }
-    Status s = this->GetNextHelper(pid,rid,key);
-    if (s == DONE){
+    Status s = DONE;
+    bool retry = false;
+    do{
+        unsigned int readVersion = this->btfile->ReadTreeVersion();
+        if (retry || readVersion != this->treeVersion){ //a writer got in the way, or pages were split or merged since curPid was found
+            this->curPid = this->btfile->FindPidWithKey(this->lowKey);
+            this->treeVersion = readVersion;
+        }
+        PageID pid = this->curPid;
+        if (pid == INVALID_PAGE){
+            this-> s = DONE;
+            return this->s;
+        }
+        s = this->GetNextHelper(pid,rid,key,readVersion,retry);
+    } while (retry);
+    if (s == DONE && this->btfile->latches == nullptr){ //the statistics walk reads every page unlatched
         this->btfile->DumpStatistics();
     }
     return s;
 }
 
+//-------------------------------------------------------------------
+// BTreeFileScan::GetNextHelper
+//
+// Input   : pid - the leaf page to continue the scan from
+//           readVersion - the tree version the read is valid for
+// Output  : rid  - record id of the scanned record.
+//           key  - key of the scanned record
+//           retry - true if a writer changed a page while it was
+//                   read; nothing was returned and the scan is as it
+//                   was
+// Purpose : Walk the leaf chain from pid and return the first entry
+//           past the last scanned key that satisfies the residual
+//           predicates.  Rejected entries are skipped inside the leaf
+//           while it is pinned.  With concurrency on, the leaves are
+//           read optimistically, and what was read is only used once
+//           the read is validated.
+// Return  : OK if successful, DONE if no more records to read.
+//-------------------------------------------------------------------
+
 Status
-BTreeFileScan::GetNextHelper(PageID pid, RecordID & rid, int& key){
+BTreeFileScan::GetNextHelper(PageID pid, RecordID & rid, int& key, const unsigned int readVersion, bool& retry){
 
-    if (pid == INVALID_PAGE){  //if the current page is empty, return DONE
-        this->s = DONE;
-        return DONE;
+    retry = false;
+    while (pid != INVALID_PAGE && this->lowKey <= this->highKey){
+        SortedPage* curPage;
+        unsigned int pageVersion;
+        if (btfile->PinOptimistic(pid, (Page *&) curPage, pageVersion) != OK){
+            return FAIL;
+        }
+        BTLeafPage* leafPage = (BTLeafPage* ) curPage;
+        bool isFrozen = (curPage->GetType() == FROZEN_NODE);
+        if (isFrozen && this->frozenPid != pid){ //decode once per page, frozen pages never change
+            ((BTFrozenPage *) curPage)->Decode(this->frozenEntries);
+            this->frozenPid = pid;
+        }
+        int numEntries = isFrozen ? (int) this->frozenEntries.size() : leafPage->GetNumOfRecords();
+        int firstSlot = isFrozen ? (int) (std::lower_bound(this->frozenEntries.begin(), this->frozenEntries.end(), this->lowKey,
+            [](const LeafEntry& e, int k) { return e.key < k; }) - this->frozenEntries.begin()) : leafPage->FindSlot(this->lowKey);
+        for (int slot = firstSlot; slot < numEntries; slot++){
+            LeafEntry* entry = isFrozen ? &this->frozenEntries[slot] : leafPage->GetEntry(slot);
+            if (this->scanned && entry->key <= this->key_scanned){ //already returned by the previous call
+                continue;
+            }
+            if (this->highKey < entry->key){ //if the cur key is higher the highKey, return DONE
+                retry = !btfile->ValidateRead(pid, pageVersion, readVersion);
+                btfile->UnpinLatched(pid, BT_LATCH_NONE, CLEAN);
+                if (retry){
+                    return FAIL;
+                }
+                this->s = DONE;
+                return DONE;
+            }
+            if (!Matches(entry->key, entry->rid)){
+                continue;
+            }
+            LeafEntry found = *entry;
+            PageID nextPid = (slot == numEntries - 1) ? leafPage->GetNextPage() : pid;
+            retry = !btfile->ValidateRead(pid, pageVersion, readVersion);
+            btfile->UnpinLatched(pid, BT_LATCH_NONE, CLEAN);
+            if (retry){
+                return FAIL;
+            }
+            rid = found.rid;  //return the current key and update member info.
+            key = found.key;
+            lowKey = key;
+            this->s = OK;
+            this->dataRid = rid;
+            this->key_scanned = key;
+            this->scanned = true;
+            this->curPid = nextPid; // if the key is the last key, continue from the next page
+            return OK;
+        }
+        PageID nextPid = leafPage->GetNextPage(); //nothing left on this page, search next page
+        retry = !btfile->ValidateRead(pid, pageVersion, readVersion);
+        btfile->UnpinLatched(pid, BT_LATCH_NONE, CLEAN);
+        if (retry){
+            return FAIL;
+        }
+        pid = nextPid;
+        this->curPid = nextPid;
     }
-    if (this->lowKey > this->highKey){ //if the lowerKey is higher than the higher key, return DONE
-        this->s = DONE;
-        return DONE;
+    this->s = DONE;
+    return DONE;
+}
+
+//-------------------------------------------------------------------
+// BTreeFileScan::Matches
+//
+// Input   : key, rid - the index entry to test
+// Output  : None
+// Purpose : Evaluate the residual predicates of the scan on an entry.
+// Return  : true if the entry satisfies all of them.
+//-------------------------------------------------------------------
+
+bool
+BTreeFileScan::Matches(const int key, const RecordID& rid)
+{
+    if (hasRidRange && (rid.pageNo < ridRange.lowPage || rid.pageNo > ridRange.highPage)){
+        return false;
     }
-    SortedPage* curPage;
-    int key_tmp,key_last;
-    RecordID dataRid_tmp, rid_tmp;
-    //BTLeafPage* curPage;
-    PIN(pid,curPage);
-    BTLeafPage* leafPage = (BTLeafPage* ) curPage;
-    if (leafPage->GetFirst(key_tmp,dataRid_tmp,rid_tmp)== DONE){
-        this->s = DONE;
-        return DONE;
+    for (size_t i = 0; i < preds.size(); i++){
+        const KeyPredicate& p = preds[i];
+        int v = key;
+        if (p.modulus != 0){
+            v = key % p.modulus;
+            if (v < 0){ //C++ keeps the sign of key
+                v += p.modulus;
+            }
+        }
+        bool ok;
+        switch (p.op){
+            case aopEQ: ok = (v == p.value); break;
+            case aopNE: ok = (v != p.value); break;
+            case aopLT: ok = (v < p.value); break;
+            case aopLE: ok = (v <= p.value); break;
+            case aopGT: ok = (v > p.value); break;
+            case aopGE: ok = (v >= p.value); break;
+            case opRANGE: ok = (v >= p.value && v <= p.highValue); break;
+            default: ok = false; break; //OpenScan lets no other operator through
+        }
+        if (!ok){
+            return false;
+        }
     }
+    return true;
+}
 
-    leafPage->GetLast(key_last,dataRid_tmp,rid_tmp); 
- 
-    if (key_last<this->lowKey || key_last == key_scanned){// if the last key is lower than LoKey on this page, or it is scanned search next page
-        PageID nextPid = leafPage->GetNextPage();
-        UNPIN(pid,CLEAN);
-        this->curPid = nextPid;
-        this->s = GetNextHelper(nextPid,rid,key);
-        return this->s;
+//-------------------------------------------------------------------
+// BTreeFileScan::Seek
+//
+// Input   : key - the key to reposition the scan to
+// Output  : None
+// Purpose : Move the scan so that the next GetNext returns the first
+//           entry not less than key.  A short forward jump follows the
+//           sibling links from the current leaf.  Otherwise the cached
+//           root-to-leaf path is climbed only as far as the lowest
+//           node still covering key, and the descent restarts there.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status
+BTreeFileScan::Seek(const int key)
+{
+    // entries past the last one returned are never left of curPid
+    if (this->generation != btfile->generation){ //the tree was rebuilt, route from scratch
+        this->curPid = INVALID_PAGE;
+        this->pathLen = 0;
+        this->frozenPid = INVALID_PAGE;
+        this->generation = btfile->generation;
     }
-    
-    // if the key lower geater than or equal to loKey:
-    leafPage->GetFirst(key_tmp,dataRid_tmp,rid_tmp); // if the high key is smaller than the first key in the page, return DONE
-    while (this->lowKey>key_tmp || key_tmp == this->key_scanned){ //if the lowkey is higher than the current key or the key is scanned, go to the next key
-        if (key_tmp == key_last) {break;}
-        leafPage->GetNext(key_tmp,dataRid_tmp,rid_tmp);
+    bool forward = this->scanned ? (key > this->lowKey) : (key >= this->lowKey);
+    this->lowKey = key;
+    this->scanned = false;
+    this->s = OK;
+
+    if (btfile->frozen != nullptr){ //the directory is in memory, nothing to save by walking
+        this->curPid = btfile->FindPidWithKey(key);
+        return OK;
     }
 
+    if (btfile->latches != nullptr){ //no paths or sibling walks, the pages may change between calls
+        this->treeVersion = btfile->ReadTreeVersion();
+        this->curPid = btfile->FindPidWithKey(key);
+        return OK;
+    }
 
-    if (this->highKey<key_tmp){ //if the cur key is higher the highKey, return DONE
-        UNPIN(pid,CLEAN);
-        this->s=DONE;
-        return DONE;
+    if (pathLen > 0 && pathVersion != btfile->structureVersion){ //the separators have changed since the descent
+        pathLen = 0;
     }
 
-    rid = dataRid_tmp;  //return the current key and update member info.
-    key = key_tmp;
-    lowKey = key_tmp;
-    this->s = OK;
-    this->dataRid = dataRid_tmp;
-    this->key_scanned = key_tmp;
-    if (key_tmp == key_last){ // if the key is the last key, 
-        PageID nextPid = leafPage->GetNextPage();
-        UNPIN(pid,CLEAN);
-        this->curPid = nextPid;
-        this->s = OK;
-        return OK;;
+    if (forward && this->curPid != INVALID_PAGE){
+        PageID pid = this->curPid;
+        for (int hop = 0; hop <= SEEK_SIBLING_HOPS && pid != INVALID_PAGE; hop++){
+            SortedPage* curPage;
+            PIN(pid,curPage);
+            BTLeafPage* leafPage = (BTLeafPage *) curPage;
+            int numEntries = leafPage->GetNumOfRecords();
+            bool here = (numEntries > 0 && leafPage->GetEntry(numEntries-1)->key >= key);
+            PageID nextPid = leafPage->GetNextPage();
+            UNPIN(pid,CLEAN);
+            if (here){
+                this->curPid = pid;
+                return OK;
+            }
+            pid = nextPid;
+        }
+        if (pid == INVALID_PAGE){ //key is past the last leaf
+            this->curPid = INVALID_PAGE;
+            return OK;
+        }
     }
-    UNPIN(pid,CLEAN); 
+
+    while (pathLen > 0 && !path[pathLen-1].Contains(key)){
+        pathLen--;
+    }
+    if (pathLen == 0 && (btfile->router != nullptr || btfile->swizzle != nullptr)){ //the router or swizzled pages beat a pinned descent
+        this->curPid = btfile->FindPidWithKey(key);
+        return OK;
+    }
+    if (pathLen == 0){
+        pathVersion = btfile->structureVersion;
+    }
+    this->curPid = btfile->FindPidWithPath(key, path, pathLen);
     return OK;
 }
+
 //-------------------------------------------------------------------
 // BTreeFileScan::DeleteCurrent
 //
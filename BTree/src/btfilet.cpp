@@ -0,0 +1,18 @@
+#include "btfilet.h"
+#include "btfilescant.h"
+#include "btcomposite.h"
+
+
+// The key types the template is built for.  int keys use BTreeFile.
+
+template class BTreeFileT<long long>;
+template class BTreeFileScanT<long long, std::less<long long> >;
+
+template class BTreeFileT<double>;
+template class BTreeFileScanT<double, std::less<double> >;
+
+// composite keys of up to 32 bytes
+template class BTreeFileT<FixedKey<32> >;
+template class BTreeFileScanT<FixedKey<32>, std::less<FixedKey<32> > >;
+template class CompositeKeyBuilder<32>;
+template class CompositeKeyReader<32>;
@@ -0,0 +1,239 @@
+#include <memory.h>
+
+#include "btfrozen.h"
+
+// Longest encoding of one entry: the key and slot varints take at
+// most five bytes, the record page varint at most ten.
+const int FROZEN_MAX_ENTRY_SIZE = 20;
+
+// The stream is coded in 64 bits whatever the width of PageID, so a
+// frozen page reads the same with 32 and 64 bit page ids, and small
+// ids and deltas still take one or two bytes.
+
+static int PutVarint(unsigned char* buf, unsigned long long v)
+{
+	int n = 0;
+	while (v >= 0x80)
+	{
+		buf[n++] = (unsigned char) (v | 0x80);
+		v >>= 7;
+	}
+	buf[n++] = (unsigned char) v;
+	return n;
+}
+
+static unsigned long long GetVarint(const unsigned char*& p)
+{
+	unsigned long long v = 0;
+	int shift = 0;
+	while (*p & 0x80)
+	{
+		v |= (unsigned long long) (*p++ & 0x7f) << shift;
+		shift += 7;
+	}
+	v |= (unsigned long long) (*p++) << shift;
+	return v;
+}
+
+static unsigned long long ZigZag(long long v) { return ((unsigned long long) v << 1) ^ (unsigned long long) (v >> 63); }
+static long long UnZigZag(unsigned long long v) { return (long long) (v >> 1) ^ -(long long) (v & 1); }
+
+
+//-------------------------------------------------------------------
+// BTFrozenPage::InitFrozen
+//
+// Input   : pageNo - the page id of this page
+// Output  : None
+// Purpose : Initialize an empty frozen page.
+// Return  : None
+//-------------------------------------------------------------------
+
+void
+BTFrozenPage::InitFrozen(PageID pageNo)
+{
+	Init(pageNo);
+	SetType(FROZEN_NODE);
+	FrozenHeader* h = Header();
+	h->numEntries = 0;
+	h->firstKey = 0;
+	h->lastKey = 0;
+	h->lastRidPage = 0;
+	h->used = sizeof(FrozenHeader);
+}
+
+
+//-------------------------------------------------------------------
+// BTFrozenPage::Append
+//
+// Input   : key, rid - the entry; keys must come in sorted order
+// Output  : None
+// Purpose : Encode the entry at the end of the stream.
+// Return  : true if it fit, false if the page is full.
+//-------------------------------------------------------------------
+
+bool
+BTFrozenPage::Append(const int key, const RecordID rid)
+{
+	FrozenHeader* h = Header();
+	unsigned char buf[FROZEN_MAX_ENTRY_SIZE];
+	int prevKey = (h->numEntries == 0) ? key : h->lastKey;
+	int n = PutVarint(buf, (unsigned int) key - (unsigned int) prevKey);
+	n += PutVarint(buf + n, ZigZag((long long) rid.pageNo - h->lastRidPage));
+	n += PutVarint(buf + n, ZigZag(rid.slotNo));
+	if (h->used + n > HEAPPAGE_DATA_SIZE)
+	{
+		return false;
+	}
+	memcpy(data + h->used, buf, n);
+	h->used += n;
+	if (h->numEntries == 0)
+	{
+		h->firstKey = key;
+	}
+	h->numEntries++;
+	h->lastKey = key;
+	h->lastRidPage = rid.pageNo;
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// BTFrozenPage::Decode
+//
+// Input   : None
+// Output  : entries - all entries of the page, in key order
+// Purpose : Decode the whole stream.
+// Return  : None
+//-------------------------------------------------------------------
+
+void
+BTFrozenPage::Decode(std::vector<LeafEntry>& entries)
+{
+	FrozenHeader* h = Header();
+	const unsigned char* p = (const unsigned char *) data + sizeof(FrozenHeader);
+	LeafEntry entry;
+	entry.key = h->firstKey;
+	long long ridPage = 0;
+	entries.resize(h->numEntries);
+	for (int i = 0; i < h->numEntries; i++)
+	{
+		entry.key = (int) ((unsigned int) entry.key + (unsigned int) GetVarint(p));
+		ridPage += UnZigZag(GetVarint(p));
+		entry.rid.pageNo = (PageID) ridPage;
+		entry.rid.slotNo = (int) UnZigZag(GetVarint(p));
+		entries[i] = entry;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// BTFrozenPage::Find
+//
+// Input   : key - the key to look up
+// Output  : rid - the record id of the first entry with key
+// Purpose : Decode the stream up to key.
+// Return  : OK if found, DONE otherwise.
+//-------------------------------------------------------------------
+
+Status
+BTFrozenPage::Find(const int key, RecordID& rid)
+{
+	FrozenHeader* h = Header();
+	if (h->numEntries == 0 || key < h->firstKey || key > h->lastKey)
+	{
+		return DONE;
+	}
+	const unsigned char* p = (const unsigned char *) data + sizeof(FrozenHeader);
+	int k = h->firstKey;
+	long long ridPage = 0;
+	for (int i = 0; i < h->numEntries; i++)
+	{
+		k = (int) ((unsigned int) k + (unsigned int) GetVarint(p));
+		ridPage += UnZigZag(GetVarint(p));
+		int slot = (int) UnZigZag(GetVarint(p));
+		if (k == key)
+		{
+			rid.pageNo = (PageID) ridPage;
+			rid.slotNo = slot;
+			return OK;
+		}
+		if (k > key)
+		{
+			break;
+		}
+	}
+	return DONE;
+}
+
+
+//-------------------------------------------------------------------
+// BTFrozenDirectory::Add
+//
+// Input   : firstKey, lastKey - the key range of the page
+//           pid - the next frozen page, in key order
+// Output  : None
+// Purpose : Append a page to the directory.
+// Return  : None
+//-------------------------------------------------------------------
+
+void
+BTFrozenDirectory::Add(const int firstKey, const int lastKey, const PageID pid)
+{
+	firstKeys.push_back(firstKey);
+	pids.push_back(pid);
+	this->lastKey = lastKey;
+}
+
+
+//-------------------------------------------------------------------
+// BTFrozenDirectory::Find
+//
+// Input   : key - the key to look up
+// Output  : None
+// Purpose : Binary search for the last page whose first key is less
+//           than key, or the first page.  With duplicates spanning
+//           pages this is the first page that may hold key.
+// Return  : the pid of the page key belongs to.
+//-------------------------------------------------------------------
+
+PageID
+BTFrozenDirectory::Find(const int key)
+{
+	int lo = 0, hi = (int) firstKeys.size() - 1;
+	while (lo < hi)
+	{
+		int mid = (lo + hi + 1) / 2;
+		if (firstKeys[mid] < key)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return pids[lo];
+}
+
+
+//-------------------------------------------------------------------
+// BTFrozenDirectory::FindAny
+//
+// Input   : key - the key to look up
+// Output  : None
+// Purpose : Binary search for the last page whose first key is not
+//           greater than key.  If key is in the tree, this page holds
+//           an entry with key, which is all a point lookup needs.
+// Return  : the pid of the page.
+//-------------------------------------------------------------------
+
+PageID
+BTFrozenDirectory::FindAny(const int key)
+{
+	int lo = 0, hi = (int) firstKeys.size() - 1;
+	while (lo < hi)
+	{
+		int mid = (lo + hi + 1) / 2;
+		if (firstKeys[mid] <= key)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return pids[lo];
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <string.h>
 #include "btindex.h"
 
@@ -251,6 +252,53 @@ BTIndexPage::FindPageWithKeys(const int d_key, int& key,int& nextKey, PageID& pi
 	return OK;
 }
 
+//-------------------------------------------------------------------
+// BTIndexPage::FindChildSlot
+//
+// Input   : key - the key we use to compare
+// Output  : None
+// Purpose : Binary search for the child that key belongs to.  The
+//           entries of the probes the search may visit next are
+//           prefetched before the current entry is compared.
+// Return  : 0 for the left link, i for the pid of the (i-1)th entry.
+//-------------------------------------------------------------------
+
+int
+BTIndexPage::FindChildSlot(const int key)
+{
+	int lo = 0, hi = numOfSlots;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		__builtin_prefetch(data + slots[(lo + mid) / 2].offset);
+		__builtin_prefetch(data + slots[std::min((mid + 1 + hi) / 2, numOfSlots - 1)].offset);
+		if (key < ((IndexEntry *)(data + slots[mid].offset))->key)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+//-------------------------------------------------------------------
+// BTIndexPage::GetChild
+//
+// Input   : childSlot - value returned by FindChildSlot
+// Output  : None
+// Purpose : Translate a child slot into the page id it refers to.
+// Return  : The page id of the child.
+//-------------------------------------------------------------------
+
+PageID
+BTIndexPage::GetChild(int childSlot)
+{
+	if (childSlot == 0)
+	{
+		return GetLeftLink();
+	}
+	return GetEntry(childSlot - 1)->pid;
+}
+
 //-------------------------------------------------------------------
 //BTLeafPage::GetLast
 //-------------------------------------------------------------------
@@ -258,8 +306,12 @@ Status
 BTIndexPage::GetLast(int& key, PageID& pid, RecordID& rid)
 {
 	Status s = GetFirst(key,pid,rid);
-	while (s != DONE){
-		s = GetNext(key,pid,rid);
+	if (s != OK){return FAIL;}
+	int key_tmp;
+	PageID pid_tmp;
+	while (GetNext(key_tmp,pid_tmp,rid) == OK){ //GetNext invalidates rid on DONE
+		key = key_tmp;
+		pid = pid_tmp;
 	}
 	return OK;
 }
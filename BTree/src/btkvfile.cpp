@@ -0,0 +1,461 @@
+#include <climits>
+#include <memory.h>
+#include <vector>
+
+#include "minirel.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "new_error.h"
+#include "btkvfile.h"
+#include "btkvfilescan.h"
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::BTreeKVFile
+//
+// Input   : filename - filename of the key-value file.
+// Output  : returnStatus - status of execution of constructor.
+//           OK if successful, FAIL otherwise.
+// Purpose : If the file exists, open it.  Otherwise create a new,
+//           empty key-value B+ tree.
+//-------------------------------------------------------------------
+
+BTreeKVFile::BTreeKVFile(Status& returnStatus, const char* filename)
+{
+	PageID pid = INVALID_PAGE;
+	Page* page;
+	fname = filename;
+	rootPid = INVALID_PAGE;
+	if (MINIBASE_DB->GetFileEntry(filename, pid) == OK){
+		rootPid = pid;
+		returnStatus = OK;
+		return;
+	}
+	returnStatus = MINIBASE_BM->NewPage(pid, page);
+	if (returnStatus != OK){
+		return;
+	}
+	returnStatus = MINIBASE_DB->AddFileEntry(filename, pid);
+	if (returnStatus == OK){
+		BTKVLeafPage* leafPage = (BTKVLeafPage *) page;
+		leafPage->Init(pid);
+		leafPage->SetType(KV_LEAF_NODE);
+		rootPid = pid;
+	}
+	MINIBASE_BM->UnpinPage(pid, DIRTY);
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::~BTreeKVFile
+//
+// Input   : None
+// Output  : None
+// Purpose : Clean up.  Nothing stays pinned between calls.
+//-------------------------------------------------------------------
+
+BTreeKVFile::~BTreeKVFile()
+{
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::DestroyFile
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Free every page of the file and delete its entry.
+//-------------------------------------------------------------------
+
+Status
+BTreeKVFile::DestroyFile()
+{
+	if (rootPid != INVALID_PAGE){
+		if (DestroyFileHelper(rootPid) != OK){
+			cerr << "Unable to destroy the BTreeKVFile " << endl;
+			return FAIL;
+		}
+		rootPid = INVALID_PAGE;
+	}
+	if (MINIBASE_DB->DeleteFileEntry(fname) != OK){
+		cerr << "unable to delete the file " << endl;
+		return FAIL;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::DestroyFileHelper
+//
+// Input   : curPid - root of the subtree to free
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Free the subtree at curPid, children first.
+//-------------------------------------------------------------------
+
+Status
+BTreeKVFile::DestroyFileHelper(PageID curPid)
+{
+	SortedPage* curPage;
+	PIN(curPid,curPage);
+	std::vector<PageID> children;
+	if (curPage->GetType() == INDEX_NODE){
+		BTIndexPage* indexPage = (BTIndexPage *) curPage;
+		for (int i = 0; i <= indexPage->GetNumOfRecords(); i++){
+			children.push_back(indexPage->GetChild(i));
+		}
+	}
+	UNPIN(curPid,CLEAN);
+	for (size_t i = 0; i < children.size(); i++){
+		if (DestroyFileHelper(children[i]) != OK){
+			return FAIL;
+		}
+	}
+	FREEPAGE(curPid);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::Put
+//
+// Input   : key - the key to store the value under
+//           value, len - the value, at most BT_MAX_VALUE_SIZE bytes
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Store value under key, replacing any value the key had.
+//           A split of the root grows the tree by one level.
+//-------------------------------------------------------------------
+
+Status
+BTreeKVFile::Put(const int key, const char* value, const int len)
+{
+	if (rootPid == INVALID_PAGE || len < 0 || len > BT_MAX_VALUE_SIZE){
+		return FAIL;
+	}
+	bool split = false;
+	int child_key;
+	PageID child_pageid;
+	if (PutHelper(key, value, len, rootPid, split, child_key, child_pageid) != OK){
+		return FAIL;
+	}
+	if (split){
+		BTIndexPage* newRoot;
+		PageID newRootPid;
+		RecordID rid;
+		NEWPAGE(newRootPid,newRoot);
+		newRoot->Init(newRootPid);
+		newRoot->SetType(INDEX_NODE);
+		newRoot->SetLeftLink(rootPid);
+		if (newRoot->Insert(child_key, child_pageid, rid) != OK){
+			UNPIN(newRootPid,DIRTY);
+			return FAIL;
+		}
+		UNPIN(newRootPid,DIRTY);
+		return SetRoot(newRootPid);
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::PutHelper
+//
+// Input   : key, value, len - the pair to store
+//           curPid - the page of the subtree key belongs to
+// Output  : split - whether curPid has split
+//           child_key, child_pageid - when split is true, the
+//                     separator and the new page to its right
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Store the pair in the subtree at curPid, splitting pages
+//           that run out of space on the way back up.
+//-------------------------------------------------------------------
+
+Status
+BTreeKVFile::PutHelper(const int key, const char* value, const int len, PageID curPid, bool& split, int& child_key, PageID& child_pageid)
+{
+	SortedPage* curPage;
+	RecordID rid;
+	PIN(curPid,curPage);
+	if (curPage->GetType() == INDEX_NODE){
+		BTIndexPage* indexPage = (BTIndexPage *) curPage;
+		PageID childPid = indexPage->GetChild(indexPage->FindChildSlot(key));
+		UNPIN(curPid,CLEAN);
+		bool childSplit = false;
+		int newKey;
+		PageID newPid;
+		if (PutHelper(key, value, len, childPid, childSplit, newKey, newPid) != OK){
+			return FAIL;
+		}
+		if (!childSplit){
+			return OK;
+		}
+		PIN(curPid,indexPage);
+		Status s;
+		if (indexPage->AvailableSpace() < (int) sizeof(IndexEntry)){ //no room for the separator, split this page too
+			BTIndexPage* newIndexPage;
+			PageID newIndexPid;
+			NEWPAGE(newIndexPid,newIndexPage);
+			newIndexPage->Init(newIndexPid);
+			newIndexPage->SetType(INDEX_NODE);
+			s = SplitIndex(indexPage, newIndexPage, child_key);
+			if (s == OK){
+				BTIndexPage* target = (newKey >= child_key) ? newIndexPage : indexPage;
+				s = target->Insert(newKey, newPid, rid);
+			}
+			split = true;
+			child_pageid = newIndexPid;
+			UNPIN(newIndexPid,DIRTY);
+		}
+		else{
+			s = indexPage->Insert(newKey, newPid, rid);
+		}
+		UNPIN(curPid,DIRTY);
+		return s;
+	}
+
+	//case when curPage is a leaf, replace the old value if there is one
+	BTKVLeafPage* leafPage = (BTKVLeafPage *) curPage;
+	int slot = leafPage->FindSlot(key);
+	if (slot < leafPage->GetNumOfRecords() && leafPage->GetKey(slot) == key){
+		leafPage->Delete(key, rid);
+	}
+	Status s;
+	if (!leafPage->HasSpaceFor(len)){
+		BTKVLeafPage* newLeafPage;
+		PageID newLeafPid;
+		NEWPAGE(newLeafPid,newLeafPage);
+		newLeafPage->Init(newLeafPid);
+		newLeafPage->SetType(KV_LEAF_NODE);
+		s = SplitLeaf(leafPage, newLeafPage);
+		if (s == OK){
+			child_key = newLeafPage->GetKey(0);
+			BTKVLeafPage* target = (key >= child_key) ? newLeafPage : leafPage;
+			s = target->Insert(key, value, len, rid);
+		}
+		split = true;
+		child_pageid = newLeafPid;
+		UNPIN(newLeafPid,DIRTY);
+	}
+	else{
+		s = leafPage->Insert(key, value, len, rid);
+	}
+	UNPIN(curPid,DIRTY);
+	return s;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::SplitLeaf
+//
+// Input   : oldPage - a full leaf
+//           newPage - an empty leaf
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Move the largest records of oldPage to newPage until the
+//           two hold about the same number of bytes (the values have
+//           different sizes, so counting records is not enough), and
+//           link newPage into the leaf chain after oldPage.
+//-------------------------------------------------------------------
+
+Status
+BTreeKVFile::SplitLeaf(BTKVLeafPage* oldPage, BTKVLeafPage* newPage)
+{
+	RecordID rid;
+	while (oldPage->GetNumOfRecords() > 1 && newPage->UsedSpace() < oldPage->UsedSpace()){
+		int last = oldPage->GetNumOfRecords() - 1;
+		int key = oldPage->GetKey(last);
+		int len;
+		const char* value = oldPage->GetValue(last, len);
+		if (newPage->Insert(key, value, len, rid) != OK || oldPage->Delete(key, rid) != OK){
+			return FAIL;
+		}
+	}
+	PageID nextPid = oldPage->GetNextPage();
+	if (nextPid != INVALID_PAGE){
+		SortedPage* nextPage;
+		PIN(nextPid,nextPage);
+		nextPage->SetPrevPage(newPage->PageNo());
+		UNPIN(nextPid,DIRTY);
+	}
+	newPage->SetNextPage(nextPid);
+	newPage->SetPrevPage(oldPage->PageNo());
+	oldPage->SetNextPage(newPage->PageNo());
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::SplitIndex
+//
+// Input   : oldPage - a full index page
+//           newPage - an empty index page
+// Output  : upKey - the separator to insert into the parent
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Move the upper half of the entries of oldPage to newPage.
+//           The middle entry moves up: its key becomes upKey and its
+//           pid the left link of newPage.
+//-------------------------------------------------------------------
+
+Status
+BTreeKVFile::SplitIndex(BTIndexPage* oldPage, BTIndexPage* newPage, int& upKey)
+{
+	RecordID rid;
+	int mid = oldPage->GetNumOfRecords() / 2;
+	for (int i = oldPage->GetNumOfRecords() - 1; i > mid; i--){
+		IndexEntry entry = *oldPage->GetEntry(i);
+		if (newPage->Insert(entry.key, entry.pid, rid) != OK || oldPage->Delete(entry.key, rid) != OK){
+			return FAIL;
+		}
+	}
+	IndexEntry middle = *oldPage->GetEntry(mid);
+	upKey = middle.key;
+	newPage->SetLeftLink(middle.pid);
+	return oldPage->Delete(middle.key, rid);
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::Get
+//
+// Input   : key - the key to look up
+// Output  : value - the value of key; the buffer must hold
+//                   BT_MAX_VALUE_SIZE bytes
+//           len - the length of the value
+// Return  : OK if found, DONE if key is not in the file, FAIL on
+//           error.
+// Purpose : Point lookup.  The value is copied out of the leaf, so a
+//           lookup pins one page per level and nothing else.
+//-------------------------------------------------------------------
+
+Status
+BTreeKVFile::Get(const int key, char* value, int& len)
+{
+	PageID pid = FindLeaf(key);
+	if (pid == INVALID_PAGE){
+		return FAIL;
+	}
+	BTKVLeafPage* leafPage;
+	PIN(pid,leafPage);
+	int slot = leafPage->FindSlot(key);
+	if (slot >= leafPage->GetNumOfRecords() || leafPage->GetKey(slot) != key){
+		UNPIN(pid,CLEAN);
+		return DONE;
+	}
+	const char* stored = leafPage->GetValue(slot, len);
+	memcpy(value, stored, len);
+	UNPIN(pid,CLEAN);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::Delete
+//
+// Input   : key - the key to remove
+// Output  : None
+// Return  : OK if successful, FAIL if key is not in the file.
+// Purpose : Remove key and its value.  The leaf is not rebalanced.
+//-------------------------------------------------------------------
+
+Status
+BTreeKVFile::Delete(const int key)
+{
+	PageID pid = FindLeaf(key);
+	if (pid == INVALID_PAGE){
+		return FAIL;
+	}
+	BTKVLeafPage* leafPage;
+	RecordID rid;
+	PIN(pid,leafPage);
+	if (leafPage->Delete(key, rid) != OK){
+		UNPIN(pid,CLEAN);
+		return FAIL;
+	}
+	UNPIN(pid,DIRTY);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::Scan
+//
+// Input   : lowKey, highKey - pointer to keys, indicate the range
+//                             to scan; nullptr leaves that end open.
+// Output  : None
+// Return  : A scan returning the pairs with lowKey <= key <= highKey
+//           in key order.  The caller deletes it.
+// Purpose : Open a range scan that returns values directly.
+//-------------------------------------------------------------------
+
+BTreeKVFileScan*
+BTreeKVFile::Scan(const int* lowKey, const int* highKey)
+{
+	BTreeKVFileScan* scan = new BTreeKVFileScan();
+	scan->kvfile = this;
+	scan->lowKey = (lowKey != nullptr) ? *lowKey : INT_MIN;
+	scan->hasHigh = (highKey != nullptr);
+	scan->highKey = (highKey != nullptr) ? *highKey : INT_MAX;
+	scan->scanned = false;
+	scan->curPid = FindLeaf(scan->lowKey);
+	scan->s = (scan->curPid == INVALID_PAGE) ? DONE : OK;
+	return scan;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::FindLeaf
+//
+// Input   : key - the key to search for
+// Output  : None
+// Return  : the pid of the leaf key belongs to, INVALID_PAGE on error.
+// Purpose : Descend from the root to the leaf of key.
+//-------------------------------------------------------------------
+
+PageID
+BTreeKVFile::FindLeaf(const int key)
+{
+	PageID curPid = rootPid;
+	if (curPid == INVALID_PAGE){
+		return INVALID_PAGE;
+	}
+	SortedPage* curPage;
+	if (MINIBASE_BM->PinPage(curPid, (Page *&) curPage) != OK){
+		return INVALID_PAGE;
+	}
+	while (curPage->GetType() == INDEX_NODE){
+		BTIndexPage* indexPage = (BTIndexPage *) curPage;
+		PageID childPid = indexPage->GetChild(indexPage->FindChildSlot(key));
+		MINIBASE_BM->UnpinPage(curPid, CLEAN);
+		curPid = childPid;
+		if (MINIBASE_BM->PinPage(curPid, (Page *&) curPage) != OK){
+			return INVALID_PAGE;
+		}
+	}
+	MINIBASE_BM->UnpinPage(curPid, CLEAN);
+	return curPid;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeKVFile::SetRoot
+//
+// Input   : pid - the new root
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Make pid the root and point the file entry at it, so the
+//           file can be opened again by name.
+//-------------------------------------------------------------------
+
+Status
+BTreeKVFile::SetRoot(PageID pid)
+{
+	rootPid = pid;
+	if (MINIBASE_DB->DeleteFileEntry(fname) != OK || MINIBASE_DB->AddFileEntry(fname, pid) != OK){
+		cerr << "unable to update the file entry of " << fname << endl;
+		return FAIL;
+	}
+	return OK;
+}
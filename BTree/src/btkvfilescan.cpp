@@ -0,0 +1,59 @@
+#include <memory.h>
+
+#include "minirel.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "new_error.h"
+#include "btkvfile.h"
+#include "btkvfilescan.h"
+
+
+//-------------------------------------------------------------------
+// BTreeKVFileScan::GetNext
+//
+// Input   : None
+// Output  : key - key of the next pair
+//           value - its value; the buffer must hold BT_MAX_VALUE_SIZE
+//                   bytes
+//           len - the length of the value
+// Purpose : Return the next pair of the scan.  The position is kept as
+//           the last key returned, so the scan stays correct when the
+//           file is changed between calls.
+// Return  : OK if successful, DONE if no more pairs to read.
+//-------------------------------------------------------------------
+
+Status
+BTreeKVFileScan::GetNext(int& key, char* value, int& len)
+{
+	if (this->s == DONE){
+		return DONE;
+	}
+	while (this->curPid != INVALID_PAGE){
+		BTKVLeafPage* leafPage;
+		PIN(this->curPid,leafPage);
+		int numRecords = leafPage->GetNumOfRecords();
+		int slot = leafPage->FindSlot(this->scanned ? this->lastKey : this->lowKey);
+		if (this->scanned && slot < numRecords && leafPage->GetKey(slot) == this->lastKey){
+			slot++; //returned already
+		}
+		if (slot < numRecords){
+			int k = leafPage->GetKey(slot);
+			if (this->hasHigh && k > this->highKey){
+				UNPIN(this->curPid,CLEAN);
+				break;
+			}
+			const char* stored = leafPage->GetValue(slot, len);
+			memcpy(value, stored, len);
+			key = k;
+			this->lastKey = k;
+			this->scanned = true;
+			UNPIN(this->curPid,CLEAN);
+			return OK;
+		}
+		PageID nextPid = leafPage->GetNextPage();
+		UNPIN(this->curPid,CLEAN);
+		this->curPid = nextPid;
+	}
+	this->s = DONE;
+	return DONE;
+}
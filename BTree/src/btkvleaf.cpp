@@ -0,0 +1,82 @@
+#include <memory.h>
+#include "btkvleaf.h"
+
+
+//-------------------------------------------------------------------
+// BTKVLeafPage::Insert
+//
+// Input   : key - value of the key to be inserted.
+//           value, len - the bytes stored with key.
+// Output  : rid - record id of the inserted record
+// Purpose : Insert the pair (key, value) into this leaf node.
+// Return  : OK if insertion is successful.  FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status
+BTKVLeafPage::Insert(const int key, const char* value, const int len, RecordID& rid)
+{
+	char record[sizeof(int) + BT_MAX_VALUE_SIZE];
+	if (len < 0 || len > BT_MAX_VALUE_SIZE)
+	{
+		return FAIL;
+	}
+	memcpy(record, &key, sizeof(int));
+	memcpy(record + sizeof(int), value, len);
+
+	Status s = SortedPage::InsertRecord(record, sizeof(int) + len, rid);
+	if (s != OK)
+	{
+		cerr << "Fail to insert record into KV LeafPage" << endl;
+		return FAIL;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTKVLeafPage::Delete
+//
+// Input   : key - value of the key to be deleted
+// Output  : rid - record id of the deleted record.
+// Purpose : Find the record with key and delete it.
+// Return  : OK if successful, FAIL otherwise.
+//-------------------------------------------------------------------
+
+Status
+BTKVLeafPage::Delete(const int key, RecordID& rid)
+{
+	int slot = FindSlot(key);
+	if (slot >= numOfSlots || GetKey(slot) != key)
+	{
+		return FAIL;
+	}
+	rid.pageNo = PageNo();
+	rid.slotNo = slot;
+	return SortedPage::DeleteRecord(rid);
+}
+
+
+//-------------------------------------------------------------------
+// BTKVLeafPage::FindSlot
+//
+// Input   : key - the key we use to compare
+//           fromSlot - the first slot to consider
+// Output  : None
+// Purpose : Binary search for the first record not less than key.
+// Return  : its slot, or the number of records if there is none.
+//-------------------------------------------------------------------
+
+int
+BTKVLeafPage::FindSlot(const int key, int fromSlot)
+{
+	int lo = fromSlot, hi = numOfSlots;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (GetKey(mid) < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
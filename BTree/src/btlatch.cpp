@@ -0,0 +1,84 @@
+#include <thread>
+
+#include "btlatch.h"
+
+
+//-------------------------------------------------------------------
+// BTLatch::LockShared
+//
+// Input   : None
+// Output  : None
+// Return  : None
+// Purpose : Wait until no writer holds or waits for the latch, then
+//           join the readers.
+//-------------------------------------------------------------------
+
+void
+BTLatch::LockShared()
+{
+	while (true)
+	{
+		if (waitingWriters.load(std::memory_order_relaxed) == 0)
+		{
+			int s = state.load(std::memory_order_relaxed);
+			if (s >= 0 && state.compare_exchange_weak(s, s + 1, std::memory_order_acquire))
+			{
+				return;
+			}
+		}
+		std::this_thread::yield();
+	}
+}
+
+
+//-------------------------------------------------------------------
+// BTLatch::LockExclusive
+//
+// Input   : None
+// Output  : None
+// Return  : None
+// Purpose : Announce the writer, then wait for the latch to be free.
+//-------------------------------------------------------------------
+
+void
+BTLatch::LockExclusive()
+{
+	waitingWriters.fetch_add(1, std::memory_order_relaxed);
+	while (true)
+	{
+		int s = 0;
+		if (state.compare_exchange_weak(s, -1, std::memory_order_acquire))
+		{
+			waitingWriters.fetch_sub(1, std::memory_order_relaxed);
+			version.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			return;
+		}
+		std::this_thread::yield();
+	}
+}
+
+
+//-------------------------------------------------------------------
+// BTLatch::ReadVersion
+//
+// Input   : None
+// Output  : None
+// Return  : The current version, to be passed to Validate.
+// Purpose : Start an optimistic read: wait until no writer holds the
+//           latch.
+//-------------------------------------------------------------------
+
+unsigned int
+BTLatch::ReadVersion()
+{
+	while (true)
+	{
+		unsigned int v = version.load(std::memory_order_acquire);
+		if ((v & 1) == 0)
+		{
+			return v;
+		}
+		std::this_thread::yield();
+	}
+}
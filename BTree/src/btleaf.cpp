@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <memory.h>
 #include "btleaf.h"
 
@@ -182,6 +183,34 @@ BTLeafPage::FindAndRemove (int key, RecordID dataRid)
 	return FAIL;	
 }
 //-------------------------------------------------------------------
+// BTLeafPage::FindSlot
+//
+// Input   : key - the key to search for
+//           fromSlot - first slot that may hold key
+// Output  : None
+// Purpose : Binary search for the first entry whose key is not less
+//           than key.  The entries of the probes the search may visit
+//           next are prefetched before the current entry is compared.
+// Return  : The slot number found, numOfSlots if every key is smaller.
+//-------------------------------------------------------------------
+
+int
+BTLeafPage::FindSlot(const int key, int fromSlot)
+{
+	int lo = fromSlot, hi = numOfSlots;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		__builtin_prefetch(data + slots[(lo + mid) / 2].offset);
+		__builtin_prefetch(data + slots[std::min((mid + 1 + hi) / 2, numOfSlots - 1)].offset);
+		if (GetEntry(mid)->key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+//-------------------------------------------------------------------
 //BTLeafPage::GetLast
 //-------------------------------------------------------------------
 Status
@@ -189,8 +218,11 @@ BTLeafPage::GetLast(int& key, RecordID& dataRid, RecordID& rid)
 {
 	Status s = GetFirst(key,dataRid,rid);
 	if (s != OK){return FAIL;}
-	while (s != DONE){
-		s = GetNext(key,dataRid,rid);
+	int key_tmp;
+	RecordID dataRid_tmp;
+	while (GetNext(key_tmp,dataRid_tmp,rid) == OK){ //GetNext clobbers dataRid on DONE
+		key = key_tmp;
+		dataRid = dataRid_tmp;
 	}
 	return OK;
 }
@@ -0,0 +1,206 @@
+#include <algorithm>
+
+#include "btlearned.h"
+
+
+//-------------------------------------------------------------------
+// BTLearnedRouter::Build
+//
+// Input   : lowKeys - the lowest key routed to every leaf, in leaf
+//                     order; lowKeys[0] stands for minus infinity
+//           pids - the leaves
+//           version - the structure version of the tree they describe
+// Output  : None
+// Purpose : Replace the leaf list and fit the model over all of it.
+// Return  : None
+//-------------------------------------------------------------------
+
+void
+BTLearnedRouter::Build(const std::vector<int>& lowKeys, const std::vector<PageID>& pids, const unsigned int version)
+{
+	this->lowKeys = lowKeys;
+	this->pids = pids;
+	segments.clear();
+	Fit(0, (int) lowKeys.size(), segments);
+	this->version = version;
+	valid = !lowKeys.empty();
+}
+
+
+//-------------------------------------------------------------------
+// BTLearnedRouter::OnSplit
+//
+// Input   : oldPid - the leaf that split
+//           newLowKey, newPid - the new leaf to the right of oldPid
+//           version - the structure version after the split
+// Output  : None
+// Purpose : Add the new leaf and refit the segment it lands in.  The
+//           later segments only move one position to the right.  If
+//           the router has missed an earlier change it stays stale.
+// Return  : None
+//-------------------------------------------------------------------
+
+void
+BTLearnedRouter::OnSplit(const PageID oldPid, const int newLowKey, const PageID newPid, const unsigned int version)
+{
+	if (!valid || this->version + 1 != version)
+	{
+		valid = false;
+		return;
+	}
+	int pos = Position(newLowKey);
+	if (pids[pos] != oldPid)
+	{
+		// duplicate boundaries make the leaf ambiguous, start over
+		valid = false;
+		return;
+	}
+	lowKeys.insert(lowKeys.begin() + pos + 1, newLowKey);
+	pids.insert(pids.begin() + pos + 1, newPid);
+
+	int seg = SegmentOf(newLowKey);
+	for (size_t s = seg + 1; s < segments.size(); s++)
+	{
+		segments[s].start++;
+	}
+	std::vector<Segment> refit;
+	Fit(segments[seg].start, SegmentEnd(seg), refit);
+	segments.erase(segments.begin() + seg);
+	segments.insert(segments.begin() + seg, refit.begin(), refit.end());
+	this->version = version;
+}
+
+
+//-------------------------------------------------------------------
+// BTLearnedRouter::Route
+//
+// Input   : key - the key to route
+// Output  : None
+// Purpose : Find the leaf key belongs to, the same leaf a descent
+//           from the root reaches.
+// Return  : the pid of the leaf.
+//-------------------------------------------------------------------
+
+PageID
+BTLearnedRouter::Route(const int key)
+{
+	return pids[Position(key)];
+}
+
+
+//-------------------------------------------------------------------
+// BTLearnedRouter::Fit
+//
+// Input   : from, to - the boundaries lowKeys[from..to) to fit
+// Output  : out - the segments, appended in key order
+// Purpose : Greedy piecewise-linear fit.  A segment grows while some
+//           slope still predicts all of its boundaries within
+//           BT_LEARNED_ERROR; the feasible slopes form a cone that
+//           narrows with every boundary added.
+// Return  : None
+//-------------------------------------------------------------------
+
+void
+BTLearnedRouter::Fit(const int from, const int to, std::vector<Segment>& out)
+{
+	int i = from;
+	while (i < to)
+	{
+		double slopeLow = 0.0;
+		double slopeHigh = -1.0;	// no bound yet
+		int j = i + 1;
+		while (j < to)
+		{
+			double dx = (double) lowKeys[j] - (double) lowKeys[i];
+			double dy = (double) (j - i);
+			if (dx == 0.0)
+			{
+				if (dy > BT_LEARNED_ERROR)
+					break;
+			}
+			else
+			{
+				double low = (dy - BT_LEARNED_ERROR) / dx;
+				double high = (dy + BT_LEARNED_ERROR) / dx;
+				if (slopeHigh >= 0.0 && (low > slopeHigh || high < slopeLow))
+					break;
+				slopeLow = std::max(slopeLow, low);
+				slopeHigh = (slopeHigh < 0.0) ? high : std::min(slopeHigh, high);
+			}
+			j++;
+		}
+		Segment seg;
+		seg.firstKey = lowKeys[i];
+		seg.start = i;
+		seg.slope = (slopeHigh < 0.0) ? 0.0 : (slopeLow + slopeHigh) / 2;
+		out.push_back(seg);
+		i = j;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// BTLearnedRouter::Position
+//
+// Input   : key - the key to route
+// Output  : None
+// Purpose : Predict the position of the last boundary not greater than
+//           key and correct the prediction with a binary search of the
+//           error window.  The window is widened to the whole segment
+//           if it turns out not to bracket key, so the answer is exact
+//           even for keys between the fitted boundaries.
+// Return  : the position of the leaf key belongs to.
+//-------------------------------------------------------------------
+
+int
+BTLearnedRouter::Position(const int key)
+{
+	int seg = SegmentOf(key);
+	const Segment& s = segments[seg];
+	int end = SegmentEnd(seg);
+	long predicted = s.start + (long) (s.slope * ((double) key - (double) s.firstKey));
+	predicted = std::max((long) s.start, std::min((long) end - 1, predicted));
+
+	int lo = std::max((long) s.start, predicted - BT_LEARNED_ERROR - 1);
+	int hi = std::min((long) end - 1, predicted + BT_LEARNED_ERROR + 1);
+	if (lowKeys[lo] > key)
+		lo = s.start;
+	if (hi < end - 1 && lowKeys[hi + 1] <= key)
+		hi = end - 1;
+	while (lo < hi)
+	{
+		int mid = (lo + hi + 1) / 2;
+		if (lowKeys[mid] <= key)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return lo;
+}
+
+
+//-------------------------------------------------------------------
+// BTLearnedRouter::SegmentOf
+//
+// Input   : key - the key to route
+// Output  : None
+// Purpose : Find the last segment whose first boundary is not greater
+//           than key.  The first boundary of the first segment is
+//           minus infinity, so there always is one.
+// Return  : the index of the segment.
+//-------------------------------------------------------------------
+
+int
+BTLearnedRouter::SegmentOf(const int key)
+{
+	int lo = 0, hi = (int) segments.size() - 1;
+	while (lo < hi)
+	{
+		int mid = (lo + hi + 1) / 2;
+		if (segments[mid].firstKey <= key)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return lo;
+}
@@ -0,0 +1,338 @@
+#include <algorithm>
+#include <utility>
+
+#include "btrange.h"
+
+//-------------------------------------------------------------------
+// BTreeRange::begin
+//
+// Input   : None
+// Output  : None
+// Return  : An iterator on the first entry of the range, end() if the
+//           range is empty.
+// Purpose : Position an iterator on the low key.
+//-------------------------------------------------------------------
+
+BTreeRange::Iterator
+BTreeRange::begin()
+{
+	Iterator it;
+	it.file = &file;
+	it.highKey = highKey;
+	if (!hasLow || lowKey <= highKey)
+	{
+		it.Start(hasLow ? &lowKey : nullptr);
+	}
+	return it;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeRange::Iterator::operator=
+//
+// Input   : other - the iterator to move from
+// Output  : None
+// Return  : this iterator
+// Purpose : Take over the position of other, and its pin if it holds
+//           one.  other is left at the end.
+//-------------------------------------------------------------------
+
+BTreeRange::Iterator&
+BTreeRange::Iterator::operator=(Iterator&& other)
+{
+	Release();
+	file = other.file;
+	pid = other.pid;
+	leaf = other.leaf;
+	slot = other.slot;
+	numEntries = other.numEntries;
+	highKey = other.highKey;
+	copied = other.copied;
+	entries.swap(other.entries);
+	treeVersion = other.treeVersion;
+	nextPid = other.nextPid;
+	lastKey = other.lastKey;
+	lastKeyRids.swap(other.lastKeyRids);
+	other.pid = INVALID_PAGE;	// the pin moves along
+	other.leaf = nullptr;
+	return *this;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeRange::Iterator::Start
+//
+// Input   : lowKey - the low end of the range, nullptr for none
+// Output  : None
+// Return  : None
+// Purpose : Position on the first entry not less than lowKey, or at
+//           the end if there is none up to the high key.  Trees that
+//           other threads may change, and frozen trees, are read into
+//           a copy of each leaf.
+//-------------------------------------------------------------------
+
+void
+BTreeRange::Iterator::Start(const int* lowKey)
+{
+	copied = (file->latches != nullptr || file->IsFrozen());
+	if (copied)
+	{
+		lastKey = (lowKey != nullptr) ? *lowKey : INT_MIN;
+		lastKeyRids.clear();
+		Copy(INVALID_PAGE, true);
+		return;
+	}
+	int key, height;
+	PageID first = (lowKey != nullptr) ? FindFirstLeaf(*lowKey) : file->GetMinimumPid(key, height);
+	if (first == INVALID_PAGE || !Load(first))
+	{
+		return;
+	}
+	slot = (lowKey != nullptr) ? leaf->FindSlot(*lowKey) : 0;
+	if (slot >= numEntries)
+	{
+		NextLeaf();
+	}
+	else if ((**this).key > highKey)
+	{
+		Release();
+	}
+}
+
+
+//-------------------------------------------------------------------
+// BTreeRange::Iterator::Load
+//
+// Input   : next - the leaf to read in place
+// Output  : None
+// Return  : true if the leaf is pinned, false otherwise.
+// Purpose : Pin a leaf and make it the current one.
+//-------------------------------------------------------------------
+
+bool
+BTreeRange::Iterator::Load(const PageID next)
+{
+	Page* page;
+	if (file->PinLatched(next, page, BT_LATCH_NONE) != OK)
+	{
+		leaf = nullptr;
+		return false;
+	}
+	pid = next;
+	leaf = (BTLeafPage *) page;
+	numEntries = leaf->GetNumOfRecords();
+	return true;
+}
+
+
+//-------------------------------------------------------------------
+// BTreeRange::Iterator::NextLeaf
+//
+// Input   : None
+// Output  : None
+// Return  : None
+// Purpose : Move to the first entry of the next leaf that has one, or
+//           to the end.  A copied leaf is followed by its right
+//           sibling unless pages were split or merged since it was
+//           read, in which case the sibling may be gone and the next
+//           leaf is found again from the last key returned.
+//-------------------------------------------------------------------
+
+void
+BTreeRange::Iterator::NextLeaf()
+{
+	if (copied)
+	{
+		bool refind = (file->ReadTreeVersion() != treeVersion);
+		pid = INVALID_PAGE;
+		if (refind || nextPid != INVALID_PAGE)
+		{
+			Copy(nextPid, refind);
+		}
+		return;
+	}
+	while (pid != INVALID_PAGE)
+	{
+		PageID next = leaf->GetNextPage();
+		Release();
+		if (next == INVALID_PAGE || !Load(next))
+		{
+			return;
+		}
+		slot = 0;
+		if (numEntries > 0)
+		{
+			if ((**this).key > highKey)
+			{
+				Release();
+			}
+			return;
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------
+// BTreeRange::Iterator::Copy
+//
+// Input   : first - the leaf to read from, unless refind
+//           refind - find the leaf of lastKey instead of using first
+// Output  : None
+// Return  : None
+// Purpose : Read leaves optimistically into entries until one has an
+//           entry that was not returned yet, and position on it.  A
+//           read a writer got in the way of is thrown away, and the
+//           walk starts over from the leaf of lastKey, passing over
+//           the entries below lastKey and those with lastKey and one
+//           of lastKeyRids, which were returned already.  Splits and
+//           merges need not keep equal keys in order, so they are told
+//           apart by record id.  Without concurrency every read is
+//           valid.
+//-------------------------------------------------------------------
+
+void
+BTreeRange::Iterator::Copy(PageID first, const bool refind)
+{
+	const int maxEntries = HEAPPAGE_DATA_SIZE / (int) sizeof(LeafEntry);
+	std::vector<RecordID> returned;		// entries with lastKey still to pass over
+	bool passing = false;				// still within the entries returned already
+	bool descend = refind;
+	unsigned int linkVersion = treeVersion;	// the version next was read at
+	PageID next = first;
+	std::vector<LeafEntry> read;
+	while (true)
+	{
+		unsigned int readVersion = file->ReadTreeVersion();
+		if (descend || readVersion != linkVersion)
+		{
+			next = FindFirstLeaf(lastKey);
+			returned = lastKeyRids;
+			passing = true;
+			descend = false;
+		}
+		if (next == INVALID_PAGE)
+		{
+			return;
+		}
+		Page* page;
+		unsigned int pageVersion;
+		if (file->PinOptimistic(next, page, pageVersion) != OK)
+		{
+			return;
+		}
+		BTLeafPage* leafPage = (BTLeafPage *) page;
+		read.clear();
+		bool readable = true;
+		if (leafPage->GetType() == FROZEN_NODE)
+		{
+			((BTFrozenPage *) page)->Decode(read);
+		}
+		else if (leafPage->GetType() == LEAF_NODE && leafPage->GetNumOfRecords() <= maxEntries)
+		{
+			for (int i = 0; i < leafPage->GetNumOfRecords(); i++)
+			{
+				read.push_back(*leafPage->GetEntry(i));
+			}
+		}
+		else
+		{
+			readable = false;				// a writer is reusing the page
+		}
+		PageID after = leafPage->GetNextPage();
+		bool valid = file->ValidateRead(next, pageVersion, readVersion) && readable;
+		file->UnpinLatched(next, BT_LATCH_NONE, CLEAN);
+		if (!valid)
+		{
+			descend = true;
+			continue;
+		}
+		treeVersion = linkVersion = readVersion;
+
+		entries.clear();
+		for (const LeafEntry& e : read)
+		{
+			if (passing && e.key < lastKey)
+			{
+				continue;
+			}
+			if (passing && e.key == lastKey)
+			{
+				std::vector<RecordID>::iterator it = std::find(returned.begin(), returned.end(), e.rid);
+				if (it != returned.end())
+				{
+					returned.erase(it);
+					continue;
+				}
+			}
+			passing = passing && e.key == lastKey;
+			entries.push_back(e);
+		}
+		if (!entries.empty())
+		{
+			pid = next;
+			nextPid = after;
+			slot = 0;
+			numEntries = (int) entries.size();
+			if (entries.back().key != lastKey)
+			{
+				lastKey = entries.back().key;
+				lastKeyRids.clear();
+			}
+			for (int i = numEntries - 1; i >= 0 && entries[i].key == lastKey; i--)
+			{
+				lastKeyRids.push_back(entries[i].rid);
+			}
+			if (entries[0].key > highKey)
+			{
+				Release();
+			}
+			return;
+		}
+		next = after;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// BTreeRange::Iterator::FindFirstLeaf
+//
+// Input   : key - the key to search for
+// Output  : None
+// Return  : the pid of the leaf to look for entries not less than
+//           key from.
+// Purpose : A key equal to a separator descends right of it, so a run
+//           of entries equal to key may begin on an earlier leaf than
+//           the one key descends to.  The key before it descends to
+//           that leaf.
+//-------------------------------------------------------------------
+
+PageID
+BTreeRange::Iterator::FindFirstLeaf(const int key)
+{
+	return file->FindPidWithKey((key > INT_MIN) ? key - 1 : key);
+}
+
+
+//-------------------------------------------------------------------
+// BTreeRange::Iterator::Release
+//
+// Input   : None
+// Output  : None
+// Return  : None
+// Purpose : Move to the end, and unpin the current leaf if it is read
+//           in place.
+//-------------------------------------------------------------------
+
+void
+BTreeRange::Iterator::Release()
+{
+	if (pid != INVALID_PAGE)
+	{
+		if (!copied)
+		{
+			file->UnpinLatched(pid, BT_LATCH_NONE, CLEAN);
+		}
+		pid = INVALID_PAGE;
+		leaf = nullptr;
+	}
+}
@@ -5,15 +5,150 @@
 #include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #include "bufmgr.h"
 #include "db.h"
+#include "heappage.h"
 #include "btfile.h"
+#include "btfrozen.h"
+#include "btfilescant.h"
+#include "btcomposite.h"
+#include "btrange.h"
+#include "csbfile.h"
+#include "btfilescan.h"
+#include "btkvfilescan.h"
+#include "crackfilescan.h"
+#include "partfile.h"
 #include "btreetest.h"
 
 #define MAX_COMMAND_SIZE 1000
 
+// Counts a failed check of the running check command and reports it.
+#define CHECK(cond) do { if (!(cond)) { failures++; \
+		*report << "  Check failed at line " << __LINE__ << ": " << #cond << endl; } } while (0)
+
+// Name of the index files a check creates.  Every check destroys its
+// files before it returns.
+#define CHECK_INDEX "CheckIndex"
+
+// The record id a check stores with key, so that a reader can tell
+// whether it got the entry that belongs to the key.
+static RecordID CheckRid(int key)
+{
+	RecordID rid;
+	rid.pageNo = key / 8 + 1;
+	rid.slotNo = key & 7;
+	return rid;
+}
+
+// Orders entries by key, then record id.
+static bool EntryLess(const LeafEntry& a, const LeafEntry& b)
+{
+	return a.key < b.key || (a.key == b.key && a.rid < b.rid);
+}
+
+static bool EntryEqual(const LeafEntry& a, const LeafEntry& b)
+{
+	return a.key == b.key && a.rid == b.rid;
+}
+
+static LeafEntry MakeEntry(int key, RecordID rid)
+{
+	LeafEntry entry;
+	entry.key = key;
+	entry.rid = rid;
+	return entry;
+}
+
+// Every entry of [lowKey, highKey], duplicates included, sorted by key
+// and record id.
+static vector<LeafEntry> RangeEntries(BTreeFile& btf, const int* lowKey = nullptr, const int* highKey = nullptr)
+{
+	vector<LeafEntry> entries;
+	for (const LeafEntry& e : BTreeRange(btf, lowKey, highKey)) {
+		entries.push_back(e);
+	}
+	sort(entries.begin(), entries.end(), EntryLess);
+	return entries;
+}
+
+static bool SameEntries(vector<LeafEntry> a, vector<LeafEntry> b)
+{
+	sort(a.begin(), a.end(), EntryLess);
+	sort(b.begin(), b.end(), EntryLess);
+	return a.size() == b.size() && equal(a.begin(), a.end(), b.begin(), EntryEqual);
+}
+
+// The number of keys of [low, high) whose Lookup disagrees with ref.
+template <class File>
+static int LookupMismatches(File* btf, const map<int, RecordID>& ref, int low, int high)
+{
+	int mismatches = 0;
+	for (int key = low; key < high; key++) {
+		RecordID rid;
+		map<int, RecordID>::const_iterator it = ref.find(key);
+		Status s = btf->Lookup(key, rid);
+		if ((s == OK) != (it != ref.end()) || (s == OK && !(rid == it->second))) {
+			mismatches++;
+		}
+	}
+	return mismatches;
+}
+
+// Reads a scan to its end and deletes it.  An entry whose record id is
+// not CheckRid(key) is returned as key INT_MIN.
+static vector<int> ScanKeys(IndexFileScan* scan)
+{
+	vector<int> keys;
+	RecordID rid;
+	int key;
+	while (scan != nullptr && scan->GetNext(rid, key) == OK) {
+		keys.push_back(rid == CheckRid(key) ? key : INT_MIN);
+	}
+	delete scan;
+	return keys;
+}
+
+// Every entry of a BTreeFileT in [lowKey, highKey], read by a scan and
+// sorted by key and record id.
+template <class Key>
+static vector<pair<Key, RecordID> > TemplateEntries(BTreeFileT<Key>& btf, const Key* lowKey, const Key* highKey)
+{
+	vector<pair<Key, RecordID> > entries;
+	BTreeFileScanT<Key, less<Key> >* scan = btf.OpenScan(lowKey, highKey);
+	RecordID rid;
+	Key key;
+	while (scan != nullptr && scan->GetNext(rid, key) == OK) {
+		entries.push_back(make_pair(key, rid));
+	}
+	delete scan;
+	sort(entries.begin(), entries.end());
+	return entries;
+}
+
+// The entries of ref in [low, high], sorted like TemplateEntries.
+template <class Key>
+static vector<pair<Key, RecordID> > TemplateEntries(const multimap<Key, RecordID>& ref, const Key* low, const Key* high)
+{
+	vector<pair<Key, RecordID> > entries;
+	for (const pair<const Key, RecordID>& e : ref) {
+		if ((low == nullptr || !(e.first < *low)) && (high == nullptr || !(*high < e.first))) {
+			entries.push_back(e);
+		}
+	}
+	sort(entries.begin(), entries.end());
+	return entries;
+}
+
 Status BTreeTest::RunTests(istream& in) {
 
 	const char* dbname = "btdb";
@@ -48,6 +183,11 @@ Status BTreeTest::RunTests(istream& in) {
 			in >> low >> high;
 			scanHighLow(btf, low, high);
 		}
+		else if (!strcmp(command, "lookup")) {
+			int low, high;
+			in >> low >> high;
+			lookupHighLow(btf, low, high);
+		}
 		else if (!strcmp(command, "delete")) {
 			int low, high;
 			in >> low >> high;
@@ -64,6 +204,11 @@ Status BTreeTest::RunTests(istream& in) {
 		else if (!strcmp(command, "stats")) {
 			btf->DumpStatistics();
 		}
+		else if (!strcmp(command, "check")) {
+			char name[MAX_COMMAND_SIZE];
+			in >> name;
+			runCheck(name);
+		}
 		else if (!strcmp(command, "quit")) {
 			break;
 		}
@@ -171,6 +316,43 @@ void BTreeTest::scanHighLow(BTreeFile* btf, int low, int high) {
 }
 
 
+void BTreeTest::lookupHighLow(BTreeFile* btf, int low, int high) {
+	cout << "Looking up (" << low << " to " << high << "):" << endl;
+
+	int numKeys = high - low + 1;
+	if (numKeys <= 0) {
+		cout << "  0 records found." << endl;
+		return;
+	}
+	int* keys = new int[numKeys];
+	RecordID* rids = new RecordID[numKeys];
+	bool* found = new bool[numKeys];
+	for (int i = 0; i < numKeys; i++) {
+		keys[i] = low + i;
+	}
+
+	Status status = btf->LookupBatch(keys, numKeys, rids, found);
+	int count = 0;
+	for (int i = 0; status == OK && i < numKeys; i++) {
+		if (found[i]) {
+			count++;
+			cout << "  Found @[pg,slot]=[" << rids[i].pageNo << "," << rids[i].slotNo << "]";
+			cout << " key=" << keys[i] << endl;
+		}
+	}
+	delete [] keys;
+	delete [] rids;
+	delete [] found;
+	cout << "  " << count << " records found." << endl;
+
+	if (status != OK) {
+		minibase_errors.show_errors();
+		return;
+	}
+	cout << "  Success." << endl;
+}
+
+
 void BTreeTest::deleteHighLow(BTreeFile* btf, int low, int high) {
 	cout << "Deleting (" << low << "-" << high << "):" << endl;
 
@@ -260,3 +442,2058 @@ void BTreeTest::deleteScanHighLow(BTreeFile* btf, int low, int high) {
     }
 	cout << "  Success." << endl;
 }
+
+
+void BTreeTest::runCheck(const char* name) {
+	static const struct {
+		const char* name;
+		void (BTreeTest::*run)();
+	} checks[] = {
+		{ "lookupbatch", &BTreeTest::checkLookupBatch },
+		{ "predicates", &BTreeTest::checkPredicates },
+		{ "updaterids", &BTreeTest::checkUpdateRids },
+		{ "seek", &BTreeTest::checkSeek },
+		{ "adaptivehash", &BTreeTest::checkAdaptiveHash },
+		{ "router", &BTreeTest::checkLearnedRouting },
+		{ "kvfile", &BTreeTest::checkKVFile },
+		{ "freeze", &BTreeTest::checkFreeze },
+		{ "crackfile", &BTreeTest::checkCrackFile },
+		{ "remaprids", &BTreeTest::checkRemapRids },
+		{ "reorganize", &BTreeTest::checkReorganize },
+		{ "mergefrom", &BTreeTest::checkMergeFrom },
+		{ "sample", &BTreeTest::checkSample },
+		{ "template", &BTreeTest::checkTemplate },
+		{ "composite", &BTreeTest::checkComposite },
+		{ "frozenrids", &BTreeTest::checkFrozenRids },
+		{ "range", &BTreeTest::checkRange },
+		{ "swizzle", &BTreeTest::checkSwizzle },
+		{ "csbtree", &BTreeTest::checkCSBTree },
+		{ "latching", &BTreeTest::checkLatching },
+		{ "optimistic", &BTreeTest::checkOptimisticReads },
+		{ "bufpool", &BTreeTest::checkBufferPool },
+		{ "parallelscan", &BTreeTest::checkParallelScan },
+		{ "createindex", &BTreeTest::checkCreateIndex },
+		{ "partitioned", &BTreeTest::checkPartitioned },
+	};
+
+	cout << "Checking " << name << ":" << endl;
+	int c = 0;
+	int numChecks = (int) (sizeof(checks) / sizeof(checks[0]));
+	while (c < numChecks && strcmp(checks[c].name, name)) {
+		c++;
+	}
+	if (c == numChecks) {
+		cout << "  Error: Unknown check: " << name << endl;
+		return;
+	}
+
+	// the statistics finished scans print are not part of the result
+	ostringstream muted;
+	streambuf* out = cout.rdbuf(muted.rdbuf());
+	ostream result(out);
+	report = &result;
+	failures = 0;
+	(this->*checks[c].run)();
+	cout.rdbuf(out);
+
+	if (failures > 0) {
+		cout << "  " << failures << " checks failed." << endl;
+		return;
+	}
+	cout << "  Success." << endl;
+}
+
+
+// LookupBatch: a batch of unsorted probes, with repeated
+// and absent keys, finds what a map of the inserted entries holds.
+void BTreeTest::checkLookupBatch() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	map<int, RecordID> ref;
+	for (int i = 0; i < 3000; i++) {
+		int key = (i * 7919) % 6000;
+		if (ref.count(key) == 0 && btf->Insert(key, CheckRid(key)) == OK) {
+			ref[key] = CheckRid(key);
+		}
+	}
+	CHECK(ref.size() == 3000);
+
+	const int n = 2500;
+	vector<int> keys(n);
+	for (int i = 0; i < n; i++) {
+		keys[i] = (i * 4241) % 6200 - 100;
+	}
+	keys[7] = keys[3];
+	vector<RecordID> rids(n);
+	bool* found = new bool[n];
+	CHECK(btf->LookupBatch(keys.data(), n, rids.data(), found) == OK);
+	for (int i = 0; i < n; i++) {
+		map<int, RecordID>::iterator it = ref.find(keys[i]);
+		CHECK(found[i] == (it != ref.end()));
+		if (found[i] && it != ref.end()) {
+			CHECK(rids[i] == it->second);
+		}
+	}
+	CHECK(btf->LookupBatch(keys.data(), 0, rids.data(), found) == OK);
+	delete [] found;
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// Predicate pushdown: scans with residual predicates return
+// exactly the keys a filter of the inserted keys keeps, including
+// negative keys under a modulus; unsupported operators are refused.
+void BTreeTest::checkPredicates() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	vector<int> all;
+	for (int key = -500; key < 1500; key++) {
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		all.push_back(key);
+	}
+
+	KeyPredicate mod3 = { aopEQ, 3, 0, 4 };
+	KeyPredicate range = { opRANGE, 100, 300, 0 };
+	KeyPredicate ne = { aopNE, 150, 0, 0 };
+	KeyPredicate preds[] = { range, ne };
+	RidPageRange pages = { 10, 50 };
+	int low = -100, high = 1000;
+
+	vector<int> ref;
+	for (size_t i = 0; i < all.size(); i++) {
+		if (((all[i] % 4) + 4) % 4 == 3) ref.push_back(all[i]);
+	}
+	CHECK(ScanKeys(btf->OpenScan(nullptr, nullptr, &mod3, 1)) == ref);
+
+	ref.clear();
+	for (size_t i = 0; i < all.size(); i++) {
+		if (all[i] >= 100 && all[i] <= 300 && all[i] != 150) ref.push_back(all[i]);
+	}
+	CHECK(ScanKeys(btf->OpenScan(&low, &high, preds, 2)) == ref);
+
+	ref.clear();
+	for (size_t i = 0; i < all.size(); i++) {
+		PageID page = CheckRid(all[i]).pageNo;
+		if (all[i] >= low && all[i] <= high && page >= 10 && page <= 50) ref.push_back(all[i]);
+	}
+	CHECK(ScanKeys(btf->OpenScan(&low, &high, nullptr, 0, &pages)) == ref);
+
+	KeyPredicate nop = { aopNOP, 0, 0, 0 };
+	KeyPredicate negative = { aopEQ, 0, 0, -4 };
+	CHECK(btf->OpenScan(nullptr, nullptr, &nop, 1) == nullptr);
+	CHECK(btf->OpenScan(nullptr, nullptr, &negative, 1) == nullptr);
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// UpdateRid and UpdateRids: record moves land on exactly the
+// entries named, also when the updates of one key come in a different
+// order than its entries; a batch with a missing entry fails but
+// applies the rest.
+void BTreeTest::checkUpdateRids() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	vector<LeafEntry> ref;
+	for (int key = 0; key < 2000; key++) {
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref.push_back(MakeEntry(key, CheckRid(key)));
+	}
+	RecordID dupRids[20];
+	for (int j = 0; j < 20; j++) {
+		dupRids[j].pageNo = 9000 + j;
+		dupRids[j].slotNo = j;
+		CHECK(btf->Insert(500, dupRids[j]) == OK);
+		ref.push_back(MakeEntry(500, dupRids[j]));
+	}
+
+	vector<RidUpdate> updates;
+	RidUpdate u;
+	u.key = 100; u.oldRid = CheckRid(100); u.newRid.pageNo = 7100; u.newRid.slotNo = 1;
+	updates.push_back(u);
+	for (int j = 19; j >= 0; j -= 2) {	// later entries of the run first
+		u.key = 500; u.oldRid = dupRids[j]; u.newRid.pageNo = 7500 + j; u.newRid.slotNo = j;
+		updates.push_back(u);
+	}
+	u.key = 1500; u.oldRid = CheckRid(1500); u.newRid.pageNo = 7150; u.newRid.slotNo = 2;
+	updates.push_back(u);
+	CHECK(btf->UpdateRids(updates.data(), (int) updates.size()) == OK);
+	for (size_t i = 0; i < updates.size(); i++) {
+		for (size_t r = 0; r < ref.size(); r++) {
+			if (ref[r].key == updates[i].key && ref[r].rid == updates[i].oldRid) {
+				ref[r].rid = updates[i].newRid;
+			}
+		}
+	}
+	CHECK(SameEntries(RangeEntries(*btf), ref));
+
+	RecordID moved;
+	moved.pageNo = 7777;
+	moved.slotNo = 7;
+	CHECK(btf->UpdateRid(1999, CheckRid(1999), moved) == OK);
+	ref[1999].rid = moved;
+	CHECK(btf->UpdateRid(1999, CheckRid(1999), moved) == FAIL);
+	u.key = 1200; u.oldRid = CheckRid(1201); u.newRid = moved;		// no such entry
+	updates.assign(1, u);
+	u.key = 1300; u.oldRid = CheckRid(1300); u.newRid = moved;
+	updates.push_back(u);
+	CHECK(btf->UpdateRids(updates.data(), 2) == FAIL);
+	ref[1300].rid = moved;
+	CHECK(SameEntries(RangeEntries(*btf), ref));
+
+	const int runKey = 800, runLength = 150;	// a run over several leaves, not starting on one
+	vector<RecordID> runRids, newRids;
+	for (int j = 0; j < runLength; j++) {
+		RecordID rid;
+		rid.pageNo = 8000 + j;
+		rid.slotNo = j & 7;
+		runRids.push_back(rid);
+		rid.pageNo = 6000 + j;
+		newRids.push_back(rid);
+		CHECK(btf->Insert(runKey, runRids[j]) == OK);
+		ref.push_back(MakeEntry(runKey, runRids[j]));
+	}
+	int failedUpdates = 0;
+	for (int j = 1; j < runLength; j += 2) {
+		failedUpdates += btf->UpdateRid(runKey, runRids[j], newRids[j]) != OK;
+	}
+	CHECK(failedUpdates == 0);
+	updates.clear();
+	for (int j = runLength - 2; j >= 0; j -= 2) {
+		u.key = runKey; u.oldRid = runRids[j]; u.newRid = newRids[j];
+		updates.push_back(u);
+	}
+	CHECK(btf->UpdateRids(updates.data(), (int) updates.size()) == OK);
+	vector<LeafEntry> run;
+	for (size_t r = 0; r < ref.size(); r++) {
+		if (ref[r].key == runKey && ref[r].rid.pageNo >= 8000) {
+			ref[r].rid.pageNo -= 2000;
+		}
+		if (ref[r].key == runKey) {
+			run.push_back(ref[r]);
+		}
+	}
+	CHECK(SameEntries(RangeEntries(*btf, &runKey, &runKey), run));
+	CHECK(SameEntries(RangeEntries(*btf), ref));
+	RecordID rid;
+	CHECK(btf->Lookup(runKey, rid) == OK && rid.pageNo >= 6000 && rid.pageNo < 6000 + runLength);
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// BTreeFileScan::Seek: after a short or long jump, forwards
+// or backwards, the next entry is the first key not less than the
+// target, and the scan still stops at its high key.
+void BTreeTest::checkSeek() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	for (int key = 0; key < 4000; key += 2) {
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+	}
+
+	int low = 100, high = 3000;
+	BTreeFileScan* scan = (BTreeFileScan *) btf->OpenScan(&low, &high);
+	CHECK(scan != nullptr);
+	RecordID rid;
+	int key = -1;
+	CHECK(scan->GetNext(rid, key) == OK && key == 100);
+	const int targets[] = { 103, 110, 111, 2500, 2501, 40, 1201, 2999, 100 };
+	for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+		int expected = max(targets[i] + (targets[i] & 1), 0);
+		CHECK(scan->Seek(targets[i]) == OK);
+		for (int step = 0; step < 3; step++) {
+			Status s = scan->GetNext(rid, key);
+			if (expected > high) {
+				CHECK(s == DONE);
+				break;
+			}
+			CHECK(s == OK && key == expected && rid == CheckRid(key));
+			expected += 2;
+		}
+	}
+	CHECK(scan->Seek(3001) == OK);
+	CHECK(scan->GetNext(rid, key) == DONE);
+	delete scan;
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// Adaptive hash index: repeated lookups of hot keys, with
+// inserts and deletes moving entries between them, give what a map of
+// the entries gives, and turning the index off changes nothing.
+void BTreeTest::checkAdaptiveHash() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	map<int, RecordID> ref;
+	for (int key = 0; key < 3000; key += 3) {
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref[key] = CheckRid(key);
+	}
+	btf->EnableAdaptiveHash(true);
+	for (int round = 0; round < 6; round++) {
+		CHECK(LookupMismatches(btf, ref, 0, 600) == 0);	// hot after AHI_HOT_THRESHOLD rounds
+		for (int key = 1 + round * 100; key < 600; key += 7) {	// splits and shifts the hot leaves
+			if (ref.count(key) == 0) {
+				CHECK(btf->Insert(key, CheckRid(key)) == OK);
+				ref[key] = CheckRid(key);
+			}
+		}
+		for (int key = round * 90; key < round * 90 + 60; key += 3) {
+			if (ref.count(key) > 0) {
+				CHECK(btf->Delete(key, ref[key]) == OK);
+				ref.erase(key);
+			}
+		}
+	}
+	CHECK(LookupMismatches(btf, ref, -10, 3010) == 0);
+	btf->EnableAdaptiveHash(false);
+	CHECK(LookupMismatches(btf, ref, -10, 3010) == 0);
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// Learned routing: lookups and scans routed by the model
+// agree with a map of the entries, before and after splits and merges
+// change the leaves the model was fitted to.
+void BTreeTest::checkLearnedRouting() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	map<int, RecordID> ref;
+	for (int i = 0; i < 4000; i++) {
+		int key = (i * 7919) % 16000;
+		if (ref.count(key) == 0) {
+			CHECK(btf->Insert(key, CheckRid(key)) == OK);
+			ref[key] = CheckRid(key);
+		}
+	}
+	btf->EnableLearnedRouting(true);
+	for (int round = 0; round < 3; round++) {
+		CHECK(LookupMismatches(btf, ref, -20, 16020) == 0);
+		const int bounds[][2] = { { -5, 40 }, { 5000, 5600 }, { 15900, 17000 }, { 800, 799 } };
+		for (size_t b = 0; b < sizeof(bounds) / sizeof(bounds[0]); b++) {
+			vector<int> expected;
+			for (map<int, RecordID>::iterator it = ref.lower_bound(bounds[b][0]);
+				 it != ref.end() && it->first <= bounds[b][1]; ++it) {
+				expected.push_back(it->first);
+			}
+			CHECK(ScanKeys(btf->OpenScan(&bounds[b][0], &bounds[b][1])) == expected);
+		}
+		for (int key = 1 + round; key < 16000; key += 5) {	// splits the leaves the model knows
+			if (ref.count(key) == 0) {
+				CHECK(btf->Insert(key, CheckRid(key)) == OK);
+				ref[key] = CheckRid(key);
+			}
+		}
+		for (int key = round * 4000; key < round * 4000 + 3000; key++) {	// merges some of them away
+			if (ref.count(key) > 0) {
+				CHECK(btf->Delete(key, ref[key]) == OK);
+				ref.erase(key);
+			}
+		}
+	}
+	CHECK(LookupMismatches(btf, ref, -20, 16020) == 0);
+	btf->EnableLearnedRouting(false);
+	CHECK(LookupMismatches(btf, ref, -20, 16020) == 0);
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// The value a check stores under key; version tells overwrites apart.
+static string CheckValue(int key, int version)
+{
+	string value((key * 37 + version * 11) % (BT_MAX_VALUE_SIZE + 1), ' ');
+	for (size_t i = 0; i < value.size(); i++) {
+		value[i] = (char) ('a' + (key + version + (int) i) % 26);
+	}
+	return value;
+}
+
+
+// BTreeKVFile: values of every length up to
+// BT_MAX_VALUE_SIZE survive splits, overwrites and deletes, and Get and
+// Scan return what a map of the pairs holds.
+void BTreeTest::checkKVFile() {
+	Status status;
+	BTreeKVFile* kvf = new BTreeKVFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	map<int, string> ref;
+	for (int i = 0; i < 2000; i++) {
+		int key = (i * 7919) % 4000;
+		ref[key] = CheckValue(key, 0);
+		CHECK(kvf->Put(key, ref[key].data(), (int) ref[key].size()) == OK);
+	}
+	for (int key = 0; key < 4000; key += 3) {	// overwrite, with a different length
+		if (ref.count(key) > 0) {
+			ref[key] = CheckValue(key, 1);
+			CHECK(kvf->Put(key, ref[key].data(), (int) ref[key].size()) == OK);
+		}
+	}
+	for (int key = 1000; key < 1800; key++) {
+		CHECK((kvf->Delete(key) == OK) == (ref.erase(key) > 0));
+	}
+
+	char value[BT_MAX_VALUE_SIZE];
+	int len;
+	for (int key = -10; key < 4010; key++) {
+		Status s = kvf->Get(key, value, len);
+		map<int, string>::iterator it = ref.find(key);
+		CHECK((s == OK) == (it != ref.end()));
+		if (s == OK && it != ref.end()) {
+			CHECK(string(value, len) == it->second);
+		}
+	}
+
+	const int bounds[][2] = { { -5, 60 }, { 900, 1900 }, { 1200, 1700 }, { 3950, 5000 } };
+	for (size_t b = 0; b < sizeof(bounds) / sizeof(bounds[0]); b++) {
+		BTreeKVFileScan* scan = kvf->Scan(&bounds[b][0], &bounds[b][1]);
+		map<int, string>::iterator it = ref.lower_bound(bounds[b][0]);
+		int key;
+		while (scan->GetNext(key, value, len) == OK) {
+			CHECK(it != ref.end() && key == it->first && string(value, len) == it->second);
+			if (it != ref.end()) {
+				++it;
+			}
+		}
+		CHECK(it == ref.end() || it->first > bounds[b][1]);
+		delete scan;
+	}
+	BTreeKVFileScan* scan = kvf->Scan(nullptr, nullptr);
+	int key;
+	size_t scanned = 0;
+	while (scan->GetNext(key, value, len) == OK) {
+		scanned++;
+	}
+	CHECK(scanned == ref.size());
+	delete scan;
+
+	CHECK(kvf->DestroyFile() == OK);
+	delete kvf;
+}
+
+
+// Freeze: the frozen tree answers Lookup, LookupBatch and
+// scans like a map of the entries, also after the file is reopened,
+// and refuses changes.
+void BTreeTest::checkFreeze() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	map<int, RecordID> ref;
+	for (int i = 0; i < 5000; i++) {
+		int key = (i * 7919) % 5000;
+		key = key * 3 + key % 7 * 1000;	// gaps of several widths for the compression
+		if (ref.count(key) == 0) {
+			CHECK(btf->Insert(key, CheckRid(key)) == OK);
+			ref[key] = CheckRid(key);
+		}
+	}
+	for (int key = 3000; key < 9000; key++) {
+		if (ref.count(key) > 0) {
+			CHECK(btf->Delete(key, ref[key]) == OK);
+			ref.erase(key);
+		}
+	}
+	CHECK(btf->Freeze() == OK);
+	CHECK(btf->IsFrozen());
+
+	for (int pass = 0; pass < 2; pass++) {
+		int high = ref.rbegin()->first + 10;
+		CHECK(LookupMismatches(btf, ref, -10, high) == 0);
+
+		const int n = 3000;
+		vector<int> keys(n);
+		for (int i = 0; i < n; i++) {
+			keys[i] = (i * 4241) % high - 5;
+		}
+		vector<RecordID> rids(n);
+		bool* found = new bool[n];
+		CHECK(btf->LookupBatch(keys.data(), n, rids.data(), found) == OK);
+		for (int i = 0; i < n; i++) {
+			map<int, RecordID>::iterator it = ref.find(keys[i]);
+			CHECK(found[i] == (it != ref.end()));
+			if (found[i] && it != ref.end()) {
+				CHECK(rids[i] == it->second);
+			}
+		}
+		delete [] found;
+
+		const int bounds[][2] = { { -5, 100 }, { 2900, 9100 }, { 5000, 5001 }, { high - 200, high + 50 } };
+		for (size_t b = 0; b < sizeof(bounds) / sizeof(bounds[0]); b++) {
+			vector<int> expected;
+			for (map<int, RecordID>::iterator it = ref.lower_bound(bounds[b][0]);
+				 it != ref.end() && it->first <= bounds[b][1]; ++it) {
+				expected.push_back(it->first);
+			}
+			CHECK(ScanKeys(btf->OpenScan(&bounds[b][0], &bounds[b][1])) == expected);
+		}
+		CHECK(ScanKeys(btf->OpenScan(nullptr, nullptr)).size() == ref.size());
+
+		int key = ref.begin()->first;
+		CHECK(btf->Insert(key + 1, CheckRid(key + 1)) != OK);
+		CHECK(btf->Delete(key, ref[key]) != OK);
+		CHECK(btf->UpdateRid(key, ref[key], CheckRid(key + 1)) != OK);
+
+		delete btf;	// the file entry points at the frozen pages
+		btf = new BTreeFile(status, CHECK_INDEX);
+		CHECK(status == OK);
+		CHECK(btf->IsFrozen());
+	}
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// The entries of ref in [low, high].
+static vector<LeafEntry> EntriesIn(const vector<LeafEntry>& ref, int low, int high)
+{
+	vector<LeafEntry> entries;
+	for (const LeafEntry& e : ref) {
+		if (e.key >= low && e.key <= high) {
+			entries.push_back(e);
+		}
+	}
+	return entries;
+}
+
+static vector<LeafEntry> ScanEntries(IndexFileScan* scan)
+{
+	vector<LeafEntry> entries;
+	RecordID rid;
+	int key;
+	while (scan != nullptr && scan->GetNext(rid, key) == OK) {
+		entries.push_back(MakeEntry(key, rid));
+	}
+	delete scan;
+	return entries;
+}
+
+
+// CrackFile: overlapping range scans, with duplicates and
+// with inserts, deletes and DeleteCurrent between them, return the
+// entries of the range, in any order.
+void BTreeTest::checkCrackFile() {
+	Status status;
+	CrackFile* cf = new CrackFile(status);
+	CHECK(status == OK);
+	vector<LeafEntry> ref;
+	for (int i = 0; i < 6000; i++) {
+		int key = (i * 7919) % 3000;	// every key twice
+		RecordID rid = CheckRid(i);
+		CHECK(cf->Insert(key, rid) == OK);
+		ref.push_back(MakeEntry(key, rid));
+	}
+
+	const int bounds[][2] = { { 1000, 2000 }, { 1500, 1600 }, { -10, 40 }, { 1999, 2999 },
+		{ 1550, 1550 }, { 700, 699 }, { 2990, 4000 }, { 0, 2999 } };
+	for (int round = 0; round < 3; round++) {
+		for (size_t b = 0; b < sizeof(bounds) / sizeof(bounds[0]); b++) {
+			CHECK(SameEntries(ScanEntries(cf->OpenScan(&bounds[b][0], &bounds[b][1])),
+				EntriesIn(ref, bounds[b][0], bounds[b][1])));
+		}
+		for (int i = 0; i < 300; i++) {	// lands in pieces of every size
+			int key = (i * 613 + round) % 3100 - 50;
+			RecordID rid = CheckRid(10000 + round * 300 + i);
+			CHECK(cf->Insert(key, rid) == OK);
+			ref.push_back(MakeEntry(key, rid));
+		}
+		for (int i = 0; i < 200; i++) {
+			size_t victim = (i * 4241 + round) % ref.size();
+			CHECK(cf->Delete(ref[victim].key, ref[victim].rid) == OK);
+			ref.erase(ref.begin() + victim);
+		}
+		CHECK(cf->Delete(5000, CheckRid(0)) != OK);
+		CHECK(cf->GetNumOfEntries() == (int) ref.size());
+	}
+
+	int low = 1200, high = 1300;	// drop the odd keys of the range as the scan passes them
+	IndexFileScan* scan = cf->OpenScan(&low, &high);
+	RecordID rid;
+	int key;
+	while (scan->GetNext(rid, key) == OK) {
+		if (key & 1) {
+			CHECK(scan->DeleteCurrent() == OK);
+			ref.erase(find_if(ref.begin(), ref.end(), [&](const LeafEntry& e) { return EntryEqual(e, MakeEntry(key, rid)); }));
+		}
+	}
+	delete scan;
+	CHECK(SameEntries(ScanEntries(cf->OpenScan(&low, &high)), EntriesIn(ref, low, high)));
+	CHECK(SameEntries(ScanEntries(cf->OpenScan(nullptr, nullptr)), ref));
+	CHECK(cf->GetNumOfEntries() == (int) ref.size());
+
+	CHECK(cf->DestroyFile() == OK);
+	delete cf;
+}
+
+
+// A record id no key of the checks is stored with.
+static RecordID MovedRid(int n)
+{
+	RecordID rid;
+	rid.pageNo = 100000 + n / 8;
+	rid.slotNo = n & 7;
+	return rid;
+}
+
+
+// RemapRids: a remap repoints exactly the mapped entries,
+// duplicates included, and a reader looking up keys while a remap
+// runs with concurrency on sees either the old or the new record id.
+void BTreeTest::checkRemapRids() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	vector<LeafEntry> ref;
+	for (int i = 0; i < 3000; i++) {
+		int key = (i * 7919) % 3000;
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref.push_back(MakeEntry(key, CheckRid(key)));
+	}
+	for (int key = 100; key < 140; key++) {	// a second entry, with its own record id
+		CHECK(btf->Insert(key, CheckRid(key + 5000)) == OK);
+		ref.push_back(MakeEntry(key, CheckRid(key + 5000)));
+	}
+
+	map<RecordID, RecordID> mapping;
+	for (size_t i = 0; i < ref.size(); i += 3) {
+		mapping[ref[i].rid] = MovedRid((int) i);
+		ref[i].rid = MovedRid((int) i);
+	}
+	mapping[CheckRid(9000)] = MovedRid(9000);	// moved record the index does not point at
+	CHECK(btf->RemapRids(mapping) == OK);
+	CHECK(SameEntries(RangeEntries(*btf), ref));
+	CHECK(btf->RemapRids(map<RecordID, RecordID>()) == OK);
+
+	// the mapped entries move back while a reader looks them up
+	mapping.clear();
+	for (size_t i = 0; i < ref.size(); i += 3) {
+		mapping[ref[i].rid] = CheckRid(ref[i].key);
+	}
+	btf->EnableConcurrency(true);
+	atomic<bool> stop(false);
+	atomic<int> wrong(0);
+	thread reader([&]() {
+		while (!stop.load()) {
+			for (int key = 140; key < 3000; key += 7) {
+				RecordID rid;
+				if (btf->Lookup(key, rid) != OK || (!(rid == CheckRid(key)) && rid.pageNo < 100000)) {
+					wrong++;
+				}
+			}
+		}
+	});
+	CHECK(btf->RemapRids(mapping) == OK);
+	stop = true;
+	reader.join();
+	btf->EnableConcurrency(false);
+	CHECK(wrong.load() == 0);
+	for (size_t i = 0; i < ref.size(); i += 3) {
+		ref[i].rid = CheckRid(ref[i].key);
+	}
+	CHECK(SameEntries(RangeEntries(*btf), ref));
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// Reorganize: a copy built a few pages per call finishes
+// while every call is followed by inserts, deletes and record moves
+// on both sides of the copied keys, and the new tree holds exactly
+// the entries of a reference list.
+void BTreeTest::checkReorganize() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	vector<LeafEntry> ref;
+	for (int i = 0; i < 4000; i++) {
+		int key = (i * 7919) % 4000;
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref.push_back(MakeEntry(key, CheckRid(key)));
+	}
+	for (int i = 0; i < 10; i++) {	// a run of equal keys for a call to stop in
+		CHECK(btf->Insert(1500, CheckRid(6000 + i)) == OK);
+		ref.push_back(MakeEntry(1500, CheckRid(6000 + i)));
+	}
+
+	bool finished = false;
+	int calls = 0;
+	int next = 10000;
+	while (!finished && calls < 1000) {
+		CHECK(btf->Reorganize(0.8f, 3, finished) == OK);
+		calls++;
+		for (int j = 0; j < 4 && !finished; j++) {
+			int key = (calls * 977 + j * 1999) % 4200;
+			CHECK(btf->Insert(key, CheckRid(next)) == OK);
+			ref.push_back(MakeEntry(key, CheckRid(next)));
+			next++;
+			size_t victim = (calls * 4241 + j * 31) % ref.size();
+			CHECK(btf->Delete(ref[victim].key, ref[victim].rid) == OK);
+			ref.erase(ref.begin() + victim);
+			size_t moved = (calls * 613 + j * 17) % ref.size();
+			CHECK(btf->UpdateRid(ref[moved].key, ref[moved].rid, CheckRid(next)) == OK);
+			ref[moved].rid = CheckRid(next);
+			next++;
+		}
+	}
+	CHECK(finished);
+	CHECK(calls > 20);
+	CHECK(SameEntries(RangeEntries(*btf), ref));
+	for (int key = 0; key < 4200; key += 13) {
+		RecordID rid;
+		bool inRef = false;
+		for (const LeafEntry& e : ref) {
+			inRef = inRef || e.key == key;
+		}
+		CHECK((btf->Lookup(key, rid) == OK) == inRef);
+	}
+
+	CHECK(btf->Reorganize() == OK);	// in one go, with nothing to catch up on
+	CHECK(SameEntries(RangeEntries(*btf), ref));
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// MergeFrom: the merged tree holds the entries of both
+// trees, the entries of this tree first on equal keys, and the other
+// tree's file is gone.
+void BTreeTest::checkMergeFrom() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	BTreeFile* other = new BTreeFile(status, CHECK_INDEX "Other");
+	CHECK(status == OK);
+	vector<LeafEntry> ref;
+	for (int i = 0; i < 3000; i++) {
+		int key = (i * 7919) % 6000;
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref.push_back(MakeEntry(key, CheckRid(key)));
+	}
+	for (int i = 0; i < 2000; i++) {	// overlaps the keys of btf, with other record ids
+		int key = (i * 4241) % 7000;
+		CHECK(other->Insert(key, CheckRid(key + 10000)) == OK);
+		ref.push_back(MakeEntry(key, CheckRid(key + 10000)));
+	}
+
+	CHECK(btf->MergeFrom(*btf) != OK);
+	CHECK(btf->MergeFrom(*other) == OK);
+	delete other;
+	PageID pid;
+	CHECK(MINIBASE_DB->GetFileEntry(CHECK_INDEX "Other", pid) != OK);
+	CHECK(SameEntries(RangeEntries(*btf), ref));
+	int equalKeys = 0;
+	int prevKey = INT_MIN;
+	RecordID prevRid;
+	for (const LeafEntry& e : BTreeRange(*btf, nullptr, nullptr)) {
+		if (e.key == prevKey) {	// btf's entry, then other's
+			CHECK(prevRid == CheckRid(e.key) && e.rid == CheckRid(e.key + 10000));
+			equalKeys++;
+		}
+		prevKey = e.key;
+		prevRid = e.rid;
+	}
+	CHECK(equalKeys > 0);
+
+	BTreeFile* empty = new BTreeFile(status, CHECK_INDEX "Other");
+	CHECK(status == OK);
+	CHECK(btf->MergeFrom(*empty) == OK);
+	delete empty;
+	CHECK(SameEntries(RangeEntries(*btf), ref));
+	CHECK(btf->Insert(7500, CheckRid(7500)) == OK);	// still updatable
+	RecordID rid;
+	CHECK(btf->Lookup(7500, rid) == OK && rid == CheckRid(7500));
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// Sample: samples are entries of the tree within the
+// range, equal seeds give equal samples, and every part of the range
+// is sampled in proportion to its entries even where the leaves are
+// nearly empty.
+void BTreeTest::checkSample() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	map<int, RecordID> ref;
+	for (int i = 0; i < 6000; i++) {
+		int key = (i * 7919) % 6000;
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref[key] = CheckRid(key);
+	}
+	for (int key = 0; key < 3000; key++) {	// thin out the lower half, leaves there stay sparse
+		if (key % 5 != 0) {
+			CHECK(btf->Delete(key, ref[key]) == OK);
+			ref.erase(key);
+		}
+	}
+
+	const int n = 20000;
+	vector<LeafEntry> samples;
+	CHECK(btf->Sample(n, 7, samples) == OK);
+	CHECK(samples.size() == (size_t) n);
+	const int buckets = 6;	// entries per bucket: 200 in the lower half, 1000 in the upper
+	int counts[buckets] = { 0 };
+	for (const LeafEntry& e : samples) {
+		map<int, RecordID>::iterator it = ref.find(e.key);
+		CHECK(it != ref.end() && e.rid == it->second);
+		counts[min(max(e.key, 0) / 1000, buckets - 1)]++;
+	}
+	for (int b = 0; b < buckets; b++) {
+		double expected = (double) n * (b < 3 ? 200 : 1000) / ref.size();
+		CHECK(fabs(counts[b] - expected) < 0.15 * expected);
+	}
+
+	vector<LeafEntry> again;
+	CHECK(btf->Sample(n, 7, again) == OK);
+	CHECK(again.size() == samples.size() && equal(again.begin(), again.end(), samples.begin(), EntryEqual));
+
+	int low = 2500, high = 3499;
+	CHECK(btf->Sample(1000, 11, samples, &low, &high) == OK);
+	CHECK(samples.size() == 1000);
+	for (const LeafEntry& e : samples) {
+		CHECK(e.key >= low && e.key <= high && ref.count(e.key) > 0);
+	}
+	low = 1001, high = 1004;	// no entries there
+	CHECK(btf->Sample(10, 11, samples, &low, &high) == OK);
+	CHECK(samples.empty());
+	CHECK(btf->Sample(0, 11, samples) == OK && samples.empty());
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// BTreeFileT: long long keys beyond the int range and double
+// keys, with duplicate runs longer than a leaf, match a multimap
+// through inserts, lookups, range scans, deletes and a reopen.
+void BTreeTest::checkTemplate() {
+	Status status;
+	BTreeFileT<long long>* btf = new BTreeFileT<long long>(status, CHECK_INDEX);
+	CHECK(status == OK);
+	multimap<long long, RecordID> ref;
+	for (int i = 0; i < 4000; i++) {
+		long long key = (long long) ((i * 7919) % 2000 - 1000) * 5000000000LL;
+		RecordID rid = CheckRid(i);
+		CHECK(btf->Insert(key, rid) == OK);
+		ref.insert(make_pair(key, rid));
+	}
+	const long long dup = 3LL << 40;	// a run of 300 spans several leaves
+	for (int i = 0; i < 300; i++) {
+		CHECK(btf->Insert(dup, MovedRid(i)) == OK);
+		ref.insert(make_pair(dup, MovedRid(i)));
+	}
+	CHECK(TemplateEntries<long long>(*btf, nullptr, nullptr) == TemplateEntries<long long>(ref, nullptr, nullptr));
+
+	RecordID rid;
+	CHECK(btf->Lookup(dup, rid) == OK && rid.pageNo >= MovedRid(0).pageNo);
+	CHECK(btf->Lookup(-1000 * 5000000000LL, rid) == OK);
+	CHECK(btf->Lookup(5000000001LL, rid) == DONE);
+	CHECK(btf->Lookup(dup + 1, rid) == DONE);
+
+	long long bounds[][2] = { { -5000000000LL, 5000000000LL }, { dup, dup }, { dup - 1, dup + 1 },
+		{ 1, 4999999999LL }, { 995 * 5000000000LL, dup } };
+	for (long long* b : bounds) {
+		CHECK(TemplateEntries<long long>(*btf, &b[0], &b[1]) == TemplateEntries<long long>(ref, &b[0], &b[1]));
+	}
+	CHECK(TemplateEntries<long long>(*btf, &bounds[0][0], nullptr) == TemplateEntries<long long>(ref, &bounds[0][0], nullptr));
+	CHECK(TemplateEntries<long long>(*btf, nullptr, &bounds[0][1]) == TemplateEntries<long long>(ref, nullptr, &bounds[0][1]));
+
+	// every third entry by Delete, the middle of the run among them
+	int n = 0;
+	RecordID gone = CheckRid(-1);
+	for (multimap<long long, RecordID>::iterator it = ref.begin(); it != ref.end(); n++) {
+		if (n % 3 == 0) {
+			CHECK(btf->Delete(it->first, it->second) == OK);
+			if (it->first == dup) {
+				gone = it->second;
+			}
+			it = ref.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	CHECK(btf->Delete(dup, gone) == FAIL);	// deleted already
+	CHECK(btf->Delete(7, CheckRid(7)) == FAIL);
+
+	// every entry of [-100, 100] x 5e9 through the scan
+	long long low = -100 * 5000000000LL, high = 100 * 5000000000LL;
+	BTreeFileScanT<long long, less<long long> >* scan = btf->OpenScan(&low, &high);
+	long long key;
+	while (scan->GetNext(rid, key) == OK) {
+		CHECK(scan->DeleteCurrent() == OK);
+		CHECK(scan->DeleteCurrent() == DONE);
+	}
+	delete scan;
+	ref.erase(ref.lower_bound(low), ref.upper_bound(high));
+	CHECK(TemplateEntries<long long>(*btf, nullptr, nullptr) == TemplateEntries<long long>(ref, nullptr, nullptr));
+
+	delete btf;
+	btf = new BTreeFileT<long long>(status, CHECK_INDEX);
+	CHECK(status == OK);
+	CHECK(TemplateEntries<long long>(*btf, nullptr, nullptr) == TemplateEntries<long long>(ref, nullptr, nullptr));
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+
+	BTreeFileT<double>* dbf = new BTreeFileT<double>(status, CHECK_INDEX);
+	CHECK(status == OK);
+	multimap<double, RecordID> dref;
+	for (int i = 0; i < 3000; i++) {
+		double key = ((i * 7919) % 1500 - 750) / 8.0;	// every key twice
+		CHECK(dbf->Insert(key, CheckRid(i)) == OK);
+		dref.insert(make_pair(key, CheckRid(i)));
+	}
+	CHECK(TemplateEntries<double>(*dbf, nullptr, nullptr) == TemplateEntries<double>(dref, nullptr, nullptr));
+	double dbounds[][2] = { { -0.1, 0.1 }, { -10.0625, 10.0625 }, { 0.01, 0.1 }, { 93.75, 1e9 } };
+	for (double* b : dbounds) {
+		CHECK(TemplateEntries<double>(*dbf, &b[0], &b[1]) == TemplateEntries<double>(dref, &b[0], &b[1]));
+	}
+	CHECK(dbf->Lookup(-93.75, rid) == OK && dbf->Lookup(-93.7, rid) == DONE);
+	CHECK(dbf->DestroyFile() == OK);
+	delete dbf;
+}
+
+
+// A row of the composite key check: (tenant, time, score, name).
+struct CompositeRow {
+	int tenant;
+	long long time;
+	double score;
+	const char* name;
+};
+
+// Orders rows as tuples, the order their encoded keys must have.
+static int CompareRows(const CompositeRow& a, const CompositeRow& b)
+{
+	if (a.tenant != b.tenant) {
+		return a.tenant < b.tenant ? -1 : 1;
+	}
+	if (a.time != b.time) {
+		return a.time < b.time ? -1 : 1;
+	}
+	if (a.score != b.score) {
+		return a.score < b.score ? -1 : 1;
+	}
+	int c = strcmp(a.name, b.name);
+	return c < 0 ? -1 : (c > 0 ? 1 : 0);
+}
+
+static FixedKey<32> RowKey(const CompositeRow& row)
+{
+	return CompositeKeyBuilder<32>().AddInt(row.tenant).AddLong(row.time)
+		.AddDouble(row.score).AddString(row.name, 8).GetKey();
+}
+
+// Composite keys: every column comes back from its key, keys
+// sort like their tuples, and a prefix scan returns exactly the rows
+// with that prefix.
+void BTreeTest::checkComposite() {
+	const char* names[] = { "", "ab", "abc", "abd", "b", "zzzzzzzz" };
+	const int numRows = 2000;
+	vector<CompositeRow> rows(numRows);
+	for (int i = 0; i < numRows; i++) {
+		rows[i].tenant = (i % 7 - 3) * 100000000;
+		rows[i].time = (long long) (i % 50 - 25) * 3000000000LL;
+		rows[i].score = (i % 11 - 5) * 0.75 + (i % 3) * 1e-9;
+		rows[i].name = names[i % 6];
+	}
+
+	for (const CompositeRow& row : rows) {
+		CompositeKeyReader<32> reader(RowKey(row));
+		char name[9];
+		CHECK(reader.ReadInt() == row.tenant);
+		CHECK(reader.ReadLong() == row.time);
+		CHECK(reader.ReadDouble() == row.score);
+		reader.ReadString(name, 8);
+		CHECK(strcmp(name, row.name) == 0);
+	}
+
+	vector<int> order(numRows);
+	for (int i = 0; i < numRows; i++) {
+		order[i] = i;
+	}
+	sort(order.begin(), order.end(), [&](int a, int b) { return CompareRows(rows[a], rows[b]) < 0; });
+	int misordered = 0;
+	for (int i = 1; i < numRows; i++) {
+		const CompositeRow& a = rows[order[i - 1]];
+		const CompositeRow& b = rows[order[i]];
+		FixedKey<32> ka = RowKey(a), kb = RowKey(b);
+		if (CompareRows(a, b) == 0 ? !(ka == kb) : !(ka < kb)) {
+			misordered++;
+		}
+	}
+	CHECK(misordered == 0);
+
+	CompositeKeyBuilder<32> full;
+	full.AddLong(1).AddLong(2).AddLong(3).AddLong(4);
+	CHECK(full.IsValid() && full.GetLength() == 32);
+	CHECK(!full.AddInt(5).IsValid());
+	CHECK(!CompositeKeyBuilder<32>().AddInt(1).AddString("x", 29).IsValid());
+
+	Status status;
+	BTreeFileT<FixedKey<32> >* btf = new BTreeFileT<FixedKey<32> >(status, CHECK_INDEX);
+	CHECK(status == OK);
+	for (int i = 0; i < numRows; i++) {
+		CHECK(btf->Insert(RowKey(rows[i]), CheckRid(i)) == OK);
+	}
+
+	// prefixes of one, two and three columns, some with no rows
+	int nonEmpty = 0;
+	int tenants[] = { -300000000, 0, 300000000, 1, -2147483647 - 1 };
+	long long times[] = { -75000000000LL, 0, 72000000000LL, 5 };
+	for (int tenant : tenants) {
+		for (int columns = 1; columns <= 3; columns++) {
+			for (long long time : times) {
+				double score = -3.75;	// the score of a row with this tenant and time, if any
+				for (const CompositeRow& row : rows) {
+					if (row.tenant == tenant && row.time == time) {
+						score = row.score;
+						break;
+					}
+				}
+				CompositeKeyBuilder<32> prefix;
+				prefix.AddInt(tenant);
+				if (columns >= 2) {
+					prefix.AddLong(time);
+				}
+				if (columns >= 3) {
+					prefix.AddDouble(score);
+				}
+				vector<int> expected;
+				for (int i = 0; i < numRows; i++) {
+					if (rows[i].tenant == tenant && (columns < 2 || rows[i].time == time)
+						&& (columns < 3 || rows[i].score == score)) {
+						expected.push_back(i);
+					}
+				}
+				vector<int> found;
+				FixedKey<32> key, last = prefix.GetKey();
+				RecordID rid;
+				BTreeFileScanT<FixedKey<32>, less<FixedKey<32> > >* scan = OpenPrefixScan(*btf, prefix);
+				while (scan->GetNext(rid, key) == OK) {
+					CHECK(!(key < last));	// in key order
+					last = key;
+					int i = (rid.pageNo - 1) * 8 + rid.slotNo;
+					CHECK(i >= 0 && i < numRows && rid == CheckRid(i) && key == RowKey(rows[i]));
+					found.push_back(i);
+				}
+				delete scan;
+				sort(found.begin(), found.end());
+				CHECK(found == expected);
+				nonEmpty += found.empty() ? 0 : 1;
+				if (columns == 1) {
+					break;	// the times do not matter
+				}
+			}
+		}
+	}
+	CHECK(nonEmpty == 3 * (1 + 3 + 3));
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// Appends entries to an empty frozen page until it is full, and
+// returns them.  The page must decode and find each of them.
+static vector<LeafEntry> FillFrozenPage(BTFrozenPage* page, LeafEntry (*entry)(int))
+{
+	page->InitFrozen(1);
+	vector<LeafEntry> entries;
+	while (page->Append(entry((int) entries.size()).key, entry((int) entries.size()).rid)) {
+		entries.push_back(entry((int) entries.size()));
+	}
+	return entries;
+}
+
+// Dense keys on clustered record pages.
+static LeafEntry ClusteredEntry(int i)
+{
+	return MakeEntry(i * 2, CheckRid(8000 + i));
+}
+
+// Keys over the whole int range on record pages at both ends of it.
+static LeafEntry ScatteredEntry(int i)
+{
+	RecordID rid;
+	rid.pageNo = (i % 2 == 0) ? INT_MAX - i : i;
+	rid.slotNo = i % 2 == 0 ? 0 : 1000000 + i;
+	return MakeEntry(INT_MIN + i * 40000000, rid);
+}
+
+// Frozen page format: record page deltas beyond the int
+// range survive a page, a frozen tree and a reopen, and clustered
+// entries still pack over three times as densely as LeafEntry.
+void BTreeTest::checkFrozenRids() {
+	LeafEntry (*kinds[])(int) = { ClusteredEntry, ScatteredEntry };
+	for (LeafEntry (*kind)(int) : kinds) {
+		Page page;
+		BTFrozenPage* frozen = (BTFrozenPage *) &page;
+		vector<LeafEntry> entries = FillFrozenPage(frozen, kind);
+		vector<LeafEntry> decoded;
+		frozen->Decode(decoded);
+		CHECK(SameEntries(decoded, entries));
+		CHECK(frozen->GetNumOfEntries() == (int) entries.size());
+		int misses = 0;
+		for (const LeafEntry& e : entries) {
+			RecordID rid;
+			misses += (frozen->Find(e.key, rid) == OK && rid == e.rid) ? 0 : 1;
+		}
+		CHECK(misses == 0);
+		if (kind == ClusteredEntry) {
+			CHECK(entries.size() > 3 * (HEAPPAGE_DATA_SIZE / sizeof(LeafEntry)));
+		}
+		else {
+			CHECK(entries.size() > 10);
+		}
+	}
+
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	vector<LeafEntry> ref;
+	for (int i = 0; i < 100; i++) {
+		LeafEntry e = ScatteredEntry(i);
+		CHECK(btf->Insert(e.key, e.rid) == OK);
+		ref.push_back(e);
+	}
+	for (int i = 0; i < 2000; i++) {
+		LeafEntry e = ClusteredEntry(i);
+		e.key += 2000000000;
+		CHECK(btf->Insert(e.key, e.rid) == OK);
+		ref.push_back(e);
+	}
+	sort(ref.begin(), ref.end(), EntryLess);
+	CHECK(btf->Freeze() == OK);
+	for (int pass = 0; pass < 2; pass++) {
+		CHECK(ScanEntries(btf->OpenScan(nullptr, nullptr)).size() == ref.size());
+		CHECK(SameEntries(ScanEntries(btf->OpenScan(nullptr, nullptr)), ref));
+		int misses = 0;
+		for (const LeafEntry& e : ref) {
+			RecordID rid;
+			misses += (btf->Lookup(e.key, rid) == OK && rid == e.rid) ? 0 : 1;
+		}
+		CHECK(misses == 0);
+
+		delete btf;
+		btf = new BTreeFile(status, CHECK_INDEX);
+		CHECK(status == OK);
+		CHECK(btf->IsFrozen());
+	}
+
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// The entries of a BTreeRange in the order it returns them, and
+// whether their keys are in order.
+static vector<LeafEntry> RangeInOrder(BTreeFile& btf, const int* lowKey, const int* highKey, bool& ordered)
+{
+	vector<LeafEntry> entries;
+	ordered = true;
+	for (const LeafEntry& e : BTreeRange(btf, lowKey, highKey)) {
+		ordered = ordered && (entries.empty() || entries.back().key <= e.key);
+		entries.push_back(e);
+	}
+	return entries;
+}
+
+// BTreeRange: ranges return every entry within their bounds,
+// duplicates included, in key order; empty ranges return nothing; and
+// with concurrency on, a range read while another thread splits and
+// merges leaves returns each stable entry exactly once.
+void BTreeTest::checkRange() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	vector<LeafEntry> ref;
+	for (int i = 0; i < 3000; i++) {
+		int key = (i * 7919) % 3000 * 4;
+		int copies = (key % 40 == 0) ? 8 : 1;	// runs of equal keys, some across leaves
+		for (int c = 0; c < copies; c++) {
+			CHECK(btf->Insert(key, CheckRid(key * 8 + c)) == OK);
+			ref.push_back(MakeEntry(key, CheckRid(key * 8 + c)));
+		}
+	}
+	sort(ref.begin(), ref.end(), EntryLess);
+
+	const int bounds[][2] = { { 0, 11996 }, { 400, 400 }, { 401, 403 }, { 399, 441 }, { -100, 3 },
+		{ 11990, 20000 }, { 12000, 12100 }, { -100, -1 }, { 500, 100 }, { INT_MIN, INT_MAX }, { 6000, 6000 } };
+	for (int pass = 0; pass < 2; pass++) {	// as built, then frozen
+		for (const int* b : bounds) {
+			bool ordered;
+			CHECK(SameEntries(RangeInOrder(*btf, &b[0], &b[1], ordered), EntriesIn(ref, b[0], b[1])));
+			CHECK(ordered);
+		}
+		bool ordered;
+		CHECK(SameEntries(RangeInOrder(*btf, nullptr, nullptr, ordered), ref) && ordered);
+		int shortRuns = 0;	// runs that begin a leaf before the one their key descends to
+		for (int key = 0; key < 12000; key += 40) {
+			shortRuns += (RangeInOrder(*btf, &key, &key, ordered).size() == 8) ? 0 : 1;
+		}
+		CHECK(shortRuns == 0);
+		CHECK(SameEntries(RangeInOrder(*btf, &bounds[3][0], nullptr, ordered), EntriesIn(ref, 399, INT_MAX)));
+		CHECK(SameEntries(RangeInOrder(*btf, nullptr, &bounds[3][1], ordered), EntriesIn(ref, INT_MIN, 441)));
+
+		// iterators move, and stopping early leaves no page pinned
+		{
+			BTreeRange range(*btf, &bounds[3][0], &bounds[3][1]);
+			BTreeRange::Iterator it = range.begin();
+			CHECK(it != range.end() && it->key == 400);
+			++it;
+			BTreeRange::Iterator moved = std::move(it);
+			CHECK(it == range.end() && moved != range.end() && moved->key == 400);
+		}
+		int seen = 0;
+		for (const LeafEntry& e : BTreeRange(*btf)) {
+			if (++seen == 100) {
+				CHECK(e.key >= 0);
+				break;
+			}
+		}
+
+		if (pass == 0) {
+			CHECK(btf->Freeze() == OK);
+		}
+	}
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+
+	// with concurrency on: odd keys come and go while the even ones stay
+	btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	vector<LeafEntry> stable;
+	for (int key = 0; key < 6000; key += 2) {
+		int copies = (key % 100 == 0) ? 5 : 1;
+		for (int c = 0; c < copies; c++) {
+			CHECK(btf->Insert(key, CheckRid(key * 8 + c)) == OK);
+			stable.push_back(MakeEntry(key, CheckRid(key * 8 + c)));
+		}
+	}
+	sort(stable.begin(), stable.end(), EntryLess);
+	btf->EnableConcurrency(true);
+	atomic<bool> stop(false);
+	thread writer([&]() {
+		for (int round = 0; !stop.load(); round++) {
+			for (int key = 1; key < 6000 && !stop.load(); key += 2) {
+				btf->Insert(key, CheckRid(key * 8));
+			}
+			for (int key = 1; key < 6000 && !stop.load(); key += 2) {
+				btf->Delete(key, CheckRid(key * 8));
+			}
+		}
+	});
+	int low = 1000, high = 4999;
+	for (int round = 0; round < 30; round++) {
+		bool ordered;
+		vector<LeafEntry> entries = RangeInOrder(*btf, round % 2 ? &low : nullptr, round % 2 ? &high : nullptr, ordered);
+		CHECK(ordered);
+		vector<LeafEntry> even;
+		int strays = 0;
+		for (const LeafEntry& e : entries) {
+			if (e.key % 2 == 0) {
+				even.push_back(e);
+			}
+			else if (!(e.rid == CheckRid(e.key * 8))) {
+				strays++;
+			}
+		}
+		CHECK(strays == 0);
+		CHECK(SameEntries(even, round % 2 ? EntriesIn(stable, low, high) : stable));
+	}
+	stop = true;
+	writer.join();
+	btf->EnableConcurrency(false);
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+}
+
+
+// Swizzling: with index pages swizzled, lookups, batches and
+// scans match a map through splits and deletes; the table holds one
+// pin per swizzled page and no more than it may; and turning it off,
+// freezing or destroying the tree gives every frame back.
+void BTreeTest::checkSwizzle() {
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	map<int, RecordID> ref;
+	for (int i = 0; i < 4000; i++) {
+		int key = (i * 7919) % 8000;
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref[key] = CheckRid(key);
+	}
+	const unsigned int unpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+
+	btf->EnableSwizzling(true, 2);
+	CHECK(LookupMismatches(btf, ref, -10, 8010) == 0);
+	CHECK(unpinned - MINIBASE_BM->GetNumOfUnpinnedFrames() == 2);	// the root and one more
+	for (int i = 0; i < 4000; i++) {	// splits leaves and index pages
+		int key = 8000 + (i * 4241) % 8000;
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref[key] = CheckRid(key);
+	}
+	for (int key = 2000; key < 12000; key++) {
+		if (key % 3 != 0 && ref.count(key) > 0) {
+			CHECK(btf->Delete(key, ref[key]) == OK);
+			ref.erase(key);
+		}
+	}
+	CHECK(LookupMismatches(btf, ref, -10, 16010) == 0);
+	CHECK(unpinned - MINIBASE_BM->GetNumOfUnpinnedFrames() == 2);
+
+	btf->EnableSwizzling(false);
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+	btf->EnableSwizzling(true);
+	const int n = 3000;
+	vector<int> keys(n);
+	for (int i = 0; i < n; i++) {
+		keys[i] = (i * 4241) % 16100 - 50;
+	}
+	vector<RecordID> rids(n);
+	bool* found = new bool[n];
+	CHECK(btf->LookupBatch(keys.data(), n, rids.data(), found) == OK);
+	int wrong = 0;
+	for (int i = 0; i < n; i++) {
+		map<int, RecordID>::iterator it = ref.find(keys[i]);
+		wrong += (found[i] != (it != ref.end()) || (found[i] && !(rids[i] == it->second))) ? 1 : 0;
+	}
+	delete [] found;
+	CHECK(wrong == 0);
+	int low = 1990, high = 12010;
+	vector<int> expected;
+	for (map<int, RecordID>::iterator it = ref.lower_bound(low); it != ref.end() && it->first <= high; ++it) {
+		expected.push_back(it->first);
+	}
+	CHECK(ScanKeys(btf->OpenScan(&low, &high)) == expected);
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() < unpinned);
+
+	CHECK(btf->Freeze() == OK);		// frees the index pages the table holds
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+	CHECK(LookupMismatches(btf, ref, -10, 16010) == 0);
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+
+	btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	ref.clear();
+	btf->EnableSwizzling(true);
+	for (int key = 0; key < 6000; key++) {
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref[key] = CheckRid(key);
+	}
+	CHECK(LookupMismatches(btf, ref, -10, 6010) == 0);
+	CHECK(btf->DestroyFile() == OK);	// with pages still swizzled
+	delete btf;
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+}
+
+
+// CSBTreeFile: lookups and scans, duplicates included, match
+// a reference list through inserts, deletes and DeleteCurrent, without
+// a frame of the buffer pool; DestroyFile leaves an empty, usable index.
+void BTreeTest::checkCSBTree() {
+	const unsigned int unpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+	Status status;
+	CSBTreeFile* csb = new CSBTreeFile(status);
+	CHECK(status == OK);
+	vector<LeafEntry> ref;
+	for (int i = 0; i < 20000; i++) {
+		int key = (i * 7919) % 5000;	// every key four times
+		CHECK(csb->Insert(key, CheckRid(i)) == OK);
+		ref.push_back(MakeEntry(key, CheckRid(i)));
+	}
+	for (int i = 0; i < 300; i++) {	// a run over many leaves
+		CHECK(csb->Insert(2500, MovedRid(i)) == OK);
+		ref.push_back(MakeEntry(2500, MovedRid(i)));
+	}
+	sort(ref.begin(), ref.end(), EntryLess);
+	CHECK(csb->GetNumOfEntries() == (int) ref.size());
+	CHECK(csb->GetHeight() >= 2);
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+
+	const int bounds[][2] = { { 0, 4999 }, { 2500, 2500 }, { 2499, 2501 }, { -100, 3 }, { 4990, 9000 },
+		{ 5000, 6000 }, { 300, 200 }, { INT_MIN, INT_MAX } };
+	for (int pass = 0; pass < 2; pass++) {
+		for (const int* b : bounds) {
+			vector<LeafEntry> entries = ScanEntries(csb->OpenScan(&b[0], &b[1]));
+			CHECK(is_sorted(entries.begin(), entries.end(), [](const LeafEntry& x, const LeafEntry& y) { return x.key < y.key; }));
+			CHECK(SameEntries(entries, EntriesIn(ref, b[0], b[1])));
+		}
+		CHECK(SameEntries(ScanEntries(csb->OpenScan(nullptr, nullptr)), ref));
+		int wrong = 0;
+		for (int key = -5; key < 5005; key++) {
+			RecordID rid;
+			Status s = csb->Lookup(key, rid);
+			vector<LeafEntry> equal = EntriesIn(ref, key, key);
+			bool inRef = find_if(equal.begin(), equal.end(), [&](const LeafEntry& e) { return e.rid == rid; }) != equal.end();
+			wrong += ((s == OK) != !equal.empty() || (s == OK && !inRef)) ? 1 : 0;
+		}
+		CHECK(wrong == 0);
+
+		if (pass == 0) {	// every third entry, then all of [1000, 1999] through a scan
+			vector<LeafEntry> kept;
+			for (size_t i = 0; i < ref.size(); i++) {
+				if (i % 3 == 0) {
+					CHECK(csb->Delete(ref[i].key, ref[i].rid) == OK);
+				}
+				else {
+					kept.push_back(ref[i]);
+				}
+			}
+			CHECK(csb->Delete(ref[0].key, ref[0].rid) == FAIL);
+			CHECK(csb->Delete(7000, CheckRid(7000)) == FAIL);
+			ref = kept;
+			int low = 1000, high = 1999;
+			IndexFileScan* scan = csb->OpenScan(&low, &high);
+			RecordID rid;
+			int key;
+			while (scan->GetNext(rid, key) == OK) {
+				CHECK(scan->DeleteCurrent() == OK);
+			}
+			delete scan;
+			ref.erase(remove_if(ref.begin(), ref.end(), [&](const LeafEntry& e) { return e.key >= low && e.key <= high; }), ref.end());
+			CHECK(csb->GetNumOfEntries() == (int) ref.size());
+		}
+	}
+
+	size_t bytes = csb->GetNumOfBytes();
+	CHECK(csb->DestroyFile() == OK);
+	CHECK(csb->GetNumOfEntries() == 0 && csb->GetNumOfBytes() < bytes);
+	CHECK(ScanEntries(csb->OpenScan(nullptr, nullptr)).empty());
+	RecordID rid;
+	CHECK(csb->Lookup(2500, rid) == DONE);
+	CHECK(csb->Insert(7, CheckRid(7)) == OK && csb->Lookup(7, rid) == OK && rid == CheckRid(7));
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+	delete csb;
+}
+
+
+// Latch coupling: four writers split and merge leaves of
+// their own keys while readers look up, batch and sample the keys that
+// stay; readers never see a wrong record id, the tree ends up with
+// exactly the entries of a reference list, and no frame stays pinned.
+void BTreeTest::checkLatching() {
+	const unsigned int unpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	const int numKeys = 6000;
+	map<int, RecordID> ref;
+	for (int key = 0; key < numKeys; key += 4) {	// the keys that stay
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref[key] = CheckRid(key);
+	}
+	for (int key = 1; key < numKeys; key += 4) {	// what the writers leave behind
+		ref[key] = MovedRid(key);
+	}
+
+	btf->EnableConcurrency(true);
+	atomic<int> writing(4);
+	atomic<int> failed(0), wrong(0), reads(0);
+	vector<thread> threads;
+	for (int t = 0; t < 4; t++) {	// writer t owns the other keys k with k / 4 % 4 == t
+		threads.push_back(thread([&, t]() {
+			for (int pass = 0; pass < 2; pass++) {
+				for (int key = t * 4; key < numKeys; key += 16) {
+					for (int k = key + 1; k < key + 4; k++) {
+						failed += (pass == 0 || k % 4 == 1) && btf->Insert(k, CheckRid(k)) != OK;
+					}
+				}
+				for (int key = t * 4; key < numKeys && pass == 0; key += 16) {
+					for (int k = key + 1; k < key + 4; k++) {
+						failed += btf->Delete(k, CheckRid(k)) != OK;
+					}
+				}
+			}
+			for (int key = t * 4 + 1; key < numKeys; key += 16) {
+				failed += btf->UpdateRid(key, CheckRid(key), MovedRid(key)) != OK;
+			}
+			writing--;
+		}));
+	}
+	for (int t = 0; t < 2; t++) {
+		threads.push_back(thread([&, t]() {
+			vector<int> keys;
+			for (int key = t * 4; key < numKeys; key += 40) {
+				keys.push_back(numKeys - 4 - key);
+			}
+			vector<RecordID> rids(keys.size());
+			bool found[numKeys / 40 + 1];
+			while (writing.load() > 0) {
+				for (int key = t * 4; key < numKeys; key += 8) {
+					RecordID rid;
+					wrong += btf->Lookup(key, rid) != OK || !(rid == CheckRid(key));
+				}
+				wrong += btf->LookupBatch(keys.data(), (int) keys.size(), rids.data(), found) != OK;
+				for (size_t i = 0; i < keys.size(); i++) {
+					wrong += !found[i] || !(rids[i] == CheckRid(keys[i]));
+				}
+				vector<LeafEntry> samples;
+				wrong += btf->Sample(20, (unsigned int) reads.load(), samples) != OK;
+				for (const LeafEntry& e : samples) {
+					wrong += e.key < 0 || e.key >= numKeys || !(e.rid == CheckRid(e.key) || e.rid == MovedRid(e.key));
+				}
+				reads++;
+			}
+		}));
+	}
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+	CHECK(failed.load() == 0);
+	CHECK(wrong.load() == 0);
+	CHECK(reads.load() > 0);
+
+	vector<LeafEntry> entries;
+	for (map<int, RecordID>::const_iterator it = ref.begin(); it != ref.end(); ++it) {
+		entries.push_back(MakeEntry(it->first, it->second));
+	}
+	CHECK(SameEntries(RangeEntries(*btf), entries));
+	CHECK(LookupMismatches(btf, ref, -10, numKeys + 10) == 0);
+	btf->EnableConcurrency(false);
+	CHECK(SameEntries(RangeEntries(*btf), entries));
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+}
+
+
+// Optimistic readers: scans and lookups running alongside
+// two writers see every key that stays exactly once, in key order,
+// with its own record id, and never a record id of another key; once
+// the writers are done the tree holds exactly the reference keys.
+void BTreeTest::checkOptimisticReads() {
+	const unsigned int unpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	const int numKeys = 6000;
+	map<int, RecordID> ref;
+	for (int key = 0; key < numKeys; key += 3) {	// the keys that stay
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref[key] = CheckRid(key);
+	}
+	for (int key = 1; key < numKeys; key += 6) {	// what the writers leave behind
+		ref[key] = CheckRid(key);
+	}
+
+	btf->EnableConcurrency(true);
+	atomic<int> writing(2);
+	atomic<int> failed(0), wrong(0), scans(0);
+	vector<thread> threads;
+	for (int t = 0; t < 2; t++) {	// writer t owns the keys k with k % 3 == t + 1
+		threads.push_back(thread([&, t]() {
+			for (int round = 0; round < 3; round++) {
+				for (int key = t + 1; key < numKeys; key += 3) {
+					failed += btf->Insert(key, CheckRid(key)) != OK;
+				}
+				for (int key = t + 1; key < numKeys; key += 3) {
+					failed += (round < 2 || key % 6 != 1) && btf->Delete(key, CheckRid(key)) != OK;
+				}
+			}
+			writing--;
+		}));
+	}
+	for (int t = 0; t < 3; t++) {
+		threads.push_back(thread([&, t]() {
+			for (int round = 0; writing.load() > 0; round++) {
+				int low = (round * 997 + t * 1500) % numKeys, high = low + 1500;
+				vector<int> keys = ScanKeys(btf->OpenScan(&low, &high));
+				vector<int> stable;
+				for (size_t i = 0; i < keys.size(); i++) {
+					wrong += keys[i] < low || keys[i] > high || (i > 0 && keys[i] <= keys[i - 1]);
+					if (keys[i] % 3 == 0) {
+						stable.push_back(keys[i]);
+					}
+				}
+				int expected = (min(high, numKeys - 1) / 3) - (low + 2) / 3 + 1;
+				wrong += (int) stable.size() != expected;
+				for (int key = low - low % 3; key <= high && key < numKeys; key += 30) {
+					RecordID rid;
+					wrong += btf->Lookup(key, rid) != OK || !(rid == CheckRid(key));
+				}
+				scans++;
+			}
+		}));
+	}
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+	CHECK(failed.load() == 0);
+	CHECK(wrong.load() == 0);
+	CHECK(scans.load() > 0);
+
+	vector<int> keys;
+	for (map<int, RecordID>::const_iterator it = ref.begin(); it != ref.end(); ++it) {
+		keys.push_back(it->first);
+	}
+	CHECK(ScanKeys(btf->OpenScan(nullptr, nullptr)) == keys);
+	CHECK(LookupMismatches(btf, ref, -10, numKeys + 10) == 0);
+	btf->EnableConcurrency(false);
+	CHECK(ScanKeys(btf->OpenScan(nullptr, nullptr)) == keys);
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+}
+
+
+// Concurrent buffer pool: threads pinning more pages than
+// the pool has frames always find a page as they left it, no write is
+// lost when a frame is taken for another page, and the pins, misses
+// and frames of the global buffer manager add up afterwards.
+void BTreeTest::checkBufferPool() {
+	const unsigned int unpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+	const int numPages = 40, numFrames = 8, numThreads = 4, numPins = 2000;
+	PageID firstPid;
+	Page* page;
+	CHECK(MINIBASE_BM->NewPage(firstPid, page, numPages) == OK);
+	CHECK(MINIBASE_BM->UnpinPage(firstPid, false) == OK);
+	for (int i = 0; i < numPages; i++) {	// the pid, then a write count per thread
+		CHECK(MINIBASE_BM->PinPage(firstPid + i, page, true) == OK);
+		int* ints = (int *) page;
+		ints[0] = firstPid + i;
+		fill(ints + 1, ints + 1 + numThreads, 0);
+		CHECK(MINIBASE_BM->UnpinPage(firstPid + i, true) == OK);
+	}
+
+	vector<vector<int> > writes(numThreads, vector<int>(numPages, 0));
+	{
+		ConcurrentBufMgr pool(numFrames);
+		Page* pages[numFrames];
+		for (int i = 0; i < numFrames; i++) {
+			CHECK(pool.PinPage(firstPid + i, pages[i]) == OK);
+		}
+		CHECK(pool.PinPage(firstPid + numFrames, page) == FAIL);	// every frame is pinned
+		CHECK(pool.PinPage(firstPid, page) == OK && page == pages[0]);
+		CHECK(pool.FreePage(firstPid) == FAIL);
+		CHECK(pool.UnpinPage(firstPid, false) == OK);
+		for (int i = 0; i < numFrames; i++) {
+			CHECK(pool.UnpinPage(firstPid + i, false) == OK);
+		}
+		CHECK(pool.UnpinPage(firstPid, false) == FAIL);
+		pool.ResetStat();
+
+		atomic<int> failed(0), wrong(0);
+		vector<thread> threads;
+		for (int t = 0; t < numThreads; t++) {	// thread t only writes its own count
+			threads.push_back(thread([&, t]() {
+				for (int i = 0; i < numPins; i++) {
+					int p = (i * (2 * t + 3) + t) % numPages;
+					Page* mine;
+					if (pool.PinPage(firstPid + p, mine) != OK) {
+						failed++;
+						continue;
+					}
+					int* ints = (int *) mine;
+					wrong += ints[0] != firstPid + p || ints[1 + t] != writes[t][p];
+					ints[1 + t]++;
+					writes[t][p]++;
+					failed += pool.UnpinPage(firstPid + p, true) != OK;
+				}
+			}));
+		}
+		for (size_t i = 0; i < threads.size(); i++) {
+			threads[i].join();
+		}
+		CHECK(failed.load() == 0);
+		CHECK(wrong.load() == 0);
+		long pins, misses;
+		CHECK(pool.GetStat(pins, misses) == OK);
+		CHECK(pins == (long) numThreads * numPins);
+		CHECK(misses > numPages - numFrames && misses < pins);
+		CHECK(pool.FlushAllPages() == OK);
+
+		int lost = 0;
+		for (int i = 0; i < numPages; i++) {	// the global buffer manager has every write
+			CHECK(MINIBASE_BM->PinPage(firstPid + i, page) == OK);
+			int* ints = (int *) page;
+			lost += ints[0] != firstPid + i;
+			for (int t = 0; t < numThreads; t++) {
+				lost += ints[1 + t] != writes[t][i];
+			}
+			CHECK(MINIBASE_BM->UnpinPage(firstPid + i, false) == OK);
+		}
+		CHECK(lost == 0);
+		for (int i = 0; i < numPages; i++) {
+			CHECK(pool.PinPage(firstPid + i, page) == OK && pool.UnpinPage(firstPid + i, false) == OK);
+			CHECK(pool.FreePage(firstPid + i) == OK);
+		}
+	}
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+}
+
+
+// Runs a ParallelScan of [low, high] on nThreads threads.  The entries
+// are kept per partition; a partition number out of [0, nThreads) is
+// counted in outside.
+static Status ParallelEntries(BTreeFile& btf, const int* low, const int* high, int nThreads,
+	vector<vector<LeafEntry> >& parts, int& outside)
+{
+	parts.assign(nThreads, vector<LeafEntry>());
+	atomic<int> wrongPart(0);
+	Status s = btf.ParallelScan(low, high, nThreads, [&](int part, int key, const RecordID& rid) {
+		if (part < 0 || part >= nThreads) {
+			wrongPart++;
+			return;
+		}
+		parts[part].push_back(MakeEntry(key, rid));
+	});
+	outside = wrongPart.load();
+	return s;
+}
+
+// The partitions one after another, and whether their keys ascend.
+static vector<LeafEntry> Concatenated(const vector<vector<LeafEntry> >& parts, bool& ordered)
+{
+	vector<LeafEntry> entries;
+	ordered = true;
+	for (const vector<LeafEntry>& part : parts) {
+		for (const LeafEntry& e : part) {
+			ordered = ordered && (entries.empty() || entries.back().key <= e.key);
+			entries.push_back(e);
+		}
+	}
+	return entries;
+}
+
+
+// ParallelScan: the partitions of a range, read one after
+// another, hold exactly the entries of a reference list in key order,
+// duplicates included, for open and closed, empty and one-key ranges
+// and any number of threads; a full scan is cut into partitions of
+// about the same size; with concurrency on the keys that stay are all
+// found while a writer changes the others; a frozen tree scans alike.
+void BTreeTest::checkParallelScan() {
+	const unsigned int unpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	const int numKeys = 6000;
+	vector<LeafEntry> ref;
+	for (int key = 0; key < numKeys; key += 2) {
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		ref.push_back(MakeEntry(key, CheckRid(key)));
+		if (key % 100 == 0) {	// duplicates
+			CHECK(btf->Insert(key, MovedRid(key)) == OK);
+			ref.push_back(MakeEntry(key, MovedRid(key)));
+		}
+	}
+	sort(ref.begin(), ref.end(), EntryLess);
+
+	const int ranges[][2] = { { 1001, 4999 }, { 100, 100 }, { 3001, 3001 }, { 4000, 3000 }, { -50, 20 }, { 5990, 9000 } };
+	vector<vector<LeafEntry> > parts;
+	int outside;
+	bool ordered;
+	for (int nThreads = 1; nThreads <= 8; nThreads += 3) {
+		CHECK(ParallelEntries(*btf, nullptr, nullptr, nThreads, parts, outside) == OK);
+		CHECK(outside == 0);
+		CHECK(SameEntries(Concatenated(parts, ordered), ref) && ordered);
+		for (const int* range : ranges) {
+			CHECK(ParallelEntries(*btf, &range[0], &range[1], nThreads, parts, outside) == OK);
+			CHECK(outside == 0);
+			CHECK(SameEntries(Concatenated(parts, ordered), EntriesIn(ref, range[0], range[1])) && ordered);
+		}
+		CHECK(ParallelEntries(*btf, nullptr, &ranges[0][1], nThreads, parts, outside) == OK);
+		CHECK(SameEntries(Concatenated(parts, ordered), EntriesIn(ref, INT_MIN, ranges[0][1])) && ordered);
+		CHECK(ParallelEntries(*btf, &ranges[0][0], nullptr, nThreads, parts, outside) == OK);
+		CHECK(SameEntries(Concatenated(parts, ordered), EntriesIn(ref, ranges[0][0], INT_MAX)) && ordered);
+	}
+
+	const int nThreads = 4;
+	CHECK(ParallelEntries(*btf, nullptr, nullptr, nThreads, parts, outside) == OK);
+	for (const vector<LeafEntry>& part : parts) {	// cut at separators, so about even
+		CHECK(part.size() > ref.size() / nThreads / 2 && part.size() < ref.size() / nThreads * 2);
+	}
+
+	btf->EnableConcurrency(true);
+	atomic<bool> writing(true);
+	atomic<int> failed(0);
+	thread writer([&]() {	// the odd keys come and go
+		for (int round = 0; round < 3; round++) {
+			for (int key = 1; key < numKeys; key += 2) {
+				failed += btf->Insert(key, CheckRid(key)) != OK;
+			}
+			for (int key = 1; key < numKeys; key += 2) {
+				failed += btf->Delete(key, CheckRid(key)) != OK;
+			}
+		}
+		writing = false;
+	});
+	int scans = 0, wrong = 0;
+	while (writing.load() || scans == 0) {
+		if (ParallelEntries(*btf, &ranges[0][0], &ranges[0][1], nThreads, parts, outside) != OK || outside > 0) {
+			wrong++;
+		}
+		vector<LeafEntry> stay;
+		for (const LeafEntry& e : Concatenated(parts, ordered)) {
+			if (e.key % 2 == 0) {
+				stay.push_back(e);
+			}
+			else {
+				wrong += e.key < ranges[0][0] || e.key > ranges[0][1] || !(e.rid == CheckRid(e.key));
+			}
+		}
+		wrong += !ordered || !SameEntries(stay, EntriesIn(ref, ranges[0][0], ranges[0][1]));
+		scans++;
+	}
+	writer.join();
+	CHECK(failed.load() == 0);
+	CHECK(wrong == 0);
+	btf->EnableConcurrency(false);
+	CHECK(SameEntries(RangeEntries(*btf), ref));
+
+	CHECK(btf->Freeze() == OK);
+	CHECK(ParallelEntries(*btf, nullptr, nullptr, nThreads, parts, outside) == OK);
+	CHECK(outside == 0);
+	CHECK(SameEntries(Concatenated(parts, ordered), ref) && ordered);
+	CHECK(ParallelEntries(*btf, &ranges[0][0], &ranges[0][1], nThreads, parts, outside) == OK);
+	CHECK(SameEntries(Concatenated(parts, ordered), EntriesIn(ref, ranges[0][0], ranges[0][1])) && ordered);
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+}
+
+
+// Fills numPages new heap pages with records of 24 bytes whose int at
+// keyOffset is a key of keys, in order, and adds each key and its
+// record id to ref.
+static Status FillHeap(const vector<int>& keys, const int numPages, const int keyOffset,
+	vector<PageID>& heapPids, vector<LeafEntry>& ref)
+{
+	PageID firstPid;
+	Page* page;
+	if (MINIBASE_BM->NewPage(firstPid, page, numPages) != OK || MINIBASE_BM->UnpinPage(firstPid, false) != OK) {
+		return FAIL;
+	}
+	size_t next = 0;
+	for (int i = 0; i < numPages; i++) {
+		HeapPage* heapPage;
+		if (MINIBASE_BM->PinPage(firstPid + i, (Page *&) heapPage, true) != OK) {
+			return FAIL;
+		}
+		heapPage->Init(firstPid + i);
+		heapPids.push_back(firstPid + i);
+		size_t last = keys.size() * (i + 1) / numPages;
+		for (; next < last; next++) {
+			char record[24];
+			memset(record, '.', sizeof(record));
+			memcpy(record + keyOffset, &keys[next], sizeof(int));
+			RecordID rid;
+			if (heapPage->InsertRecord(record, (int) sizeof(record), rid) != OK) {
+				MINIBASE_BM->UnpinPage(firstPid + i, true);
+				return FAIL;
+			}
+			ref.push_back(MakeEntry(keys[next], rid));
+		}
+		if (MINIBASE_BM->UnpinPage(firstPid + i, true) != OK) {
+			return FAIL;
+		}
+	}
+	sort(ref.begin(), ref.end(), EntryLess);
+	return OK;
+}
+
+
+// CreateIndex: a tree built from a heap file on one or
+// several threads holds exactly the key and record id of every record,
+// duplicates included, replaces what the tree held before, and takes
+// inserts and deletes afterwards; a failed build leaves the tree as it
+// was.  The heap is a few dozen pages, so the DB stays small.
+void BTreeTest::checkCreateIndex() {
+	const unsigned int unpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+	Status status;
+	BTreeFile* btf = new BTreeFile(status, CHECK_INDEX);
+	CHECK(status == OK);
+	vector<LeafEntry> old;
+	for (int key = 100000; key < 100500; key++) {	// replaced by the build
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		old.push_back(MakeEntry(key, CheckRid(key)));
+	}
+
+	const int numPages = 30, keyOffset = 6;
+	vector<int> keys;
+	for (int i = 0; i < 900; i++) {
+		keys.push_back((i * 7919) % 600 - 100);	// unsorted, negative keys and duplicates
+	}
+	vector<PageID> heapPids;
+	vector<LeafEntry> ref;
+	CHECK(FillHeap(keys, numPages, keyOffset, heapPids, ref) == OK);
+
+	CHECK(btf->CreateIndex(heapPids, 40, 3) == FAIL);	// past the end of every record
+	CHECK(SameEntries(RangeEntries(*btf), old));
+
+	for (int nThreads = 1; nThreads <= 3; nThreads += 2) {	// each loader takes a run of BT_BULK_EXTENT pages
+		CHECK(btf->CreateIndex(heapPids, keyOffset, nThreads) == OK);
+		bool ordered;
+		CHECK(SameEntries(RangeInOrder(*btf, nullptr, nullptr, ordered), ref) && ordered);
+		const int low = -20, high = 250;
+		CHECK(SameEntries(RangeInOrder(*btf, &low, &high, ordered), EntriesIn(ref, low, high)) && ordered);
+		int missing = 0;
+		for (const LeafEntry& e : ref) {
+			RecordID rid;
+			missing += btf->Lookup(e.key, rid) != OK;
+		}
+		CHECK(missing == 0);
+	}
+
+	vector<LeafEntry> changed;
+	for (const LeafEntry& e : ref) {
+		if (e.key % 5 == 0) {
+			CHECK(btf->Delete(e.key, e.rid) == OK);
+		}
+		else {
+			changed.push_back(e);
+		}
+	}
+	for (int key = 1000; key < 1600; key++) {
+		CHECK(btf->Insert(key, CheckRid(key)) == OK);
+		changed.push_back(MakeEntry(key, CheckRid(key)));
+	}
+	CHECK(SameEntries(RangeEntries(*btf), changed));
+
+	for (size_t i = 0; i < heapPids.size(); i++) {
+		CHECK(MINIBASE_BM->FreePage(heapPids[i]) == OK);
+	}
+	CHECK(btf->DestroyFile() == OK);
+	delete btf;
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+}
+
+
+// The keys of ref, in order, that lie in [low, high].
+static vector<int> KeysIn(const map<int, RecordID>& ref, int low, int high)
+{
+	vector<int> keys;
+	for (map<int, RecordID>::const_iterator it = ref.lower_bound(low); it != ref.end() && it->first <= high; ++it) {
+		keys.push_back(it->first);
+	}
+	return keys;
+}
+
+
+// PartitionedBTreeFile: keys inserted and deleted from
+// several threads at once end up in exactly one partition each, spread
+// over all of them, and merged scans return the keys of a reference
+// map in key order, for hash and for range partitioning; DeleteCurrent
+// goes through the merged scan; a reopened file holds what it held;
+// bad partition counts and bounds are refused.
+void BTreeTest::checkPartitioned() {
+	const unsigned int unpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+	Status status;
+	const int bounds[] = { 1000, 2000, 3000 };
+	const int unsorted[] = { 1000, 3000, 2000 };
+	{
+		PartitionedBTreeFile bad(status, CHECK_INDEX, 0, PART_HASH);
+		CHECK(status == FAIL);
+	}
+	{
+		PartitionedBTreeFile bad(status, CHECK_INDEX, PART_MAX_PARTITIONS + 1, PART_HASH);
+		CHECK(status == FAIL);
+	}
+	{
+		PartitionedBTreeFile bad(status, CHECK_INDEX, 4, PART_RANGE);
+		CHECK(status == FAIL);
+	}
+	{
+		PartitionedBTreeFile bad(status, CHECK_INDEX, 4, PART_RANGE, unsorted);
+		CHECK(status == FAIL);
+	}
+
+	const int numKeys = 4000, numParts = 4;
+	for (int kind = PART_HASH; kind <= PART_RANGE; kind++) {
+		PartitionedBTreeFile* pf = new PartitionedBTreeFile(status, CHECK_INDEX, numParts, (PartitionKind) kind, bounds);
+		CHECK(status == OK && pf->GetNumOfPartitions() == numParts);
+		if (kind == PART_RANGE) {
+			CHECK(pf->PartitionOf(INT_MIN) == 0 && pf->PartitionOf(999) == 0 && pf->PartitionOf(1000) == 1);
+			CHECK(pf->PartitionOf(2999) == 2 && pf->PartitionOf(3000) == 3 && pf->PartitionOf(INT_MAX) == 3);
+		}
+		vector<int> perPart(numParts, 0);
+		map<int, RecordID> ref;
+		for (int key = 0; key < numKeys; key++) {
+			CHECK(pf->PartitionOf(key) >= 0 && pf->PartitionOf(key) < numParts);
+			perPart[pf->PartitionOf(key)]++;
+			if (key % 3 != 1) {
+				ref[key] = CheckRid(key);
+			}
+		}
+		for (int p = 0; p < numParts; p++) {	// an ascending stream reaches every tree
+			CHECK(perPart[p] > numKeys / numParts / 2 && perPart[p] < numKeys / numParts * 2);
+		}
+
+		pf->EnableConcurrency(true);
+		atomic<int> failed(0);
+		vector<thread> threads;
+		for (int t = 0; t < 4; t++) {	// thread t inserts the keys k with k % 4 == t, ascending
+			threads.push_back(thread([&, t]() {
+				for (int key = t; key < numKeys; key += 4) {
+					failed += pf->Insert(key, CheckRid(key)) != OK;
+				}
+				for (int key = t; key < numKeys; key += 4) {
+					failed += key % 3 == 1 && pf->Delete(key, CheckRid(key)) != OK;
+				}
+			}));
+		}
+		for (size_t i = 0; i < threads.size(); i++) {
+			threads[i].join();
+		}
+		pf->EnableConcurrency(false);
+		CHECK(failed.load() == 0);
+
+		CHECK(ScanKeys(pf->OpenScan(nullptr, nullptr)) == KeysIn(ref, INT_MIN, INT_MAX));
+		const int ranges[][2] = { { 1200, 1800 }, { 950, 3050 }, { -10, 5 }, { 3995, 5000 }, { 2500, 2400 } };
+		for (const int* range : ranges) {
+			CHECK(ScanKeys(pf->OpenScan(&range[0], &range[1])) == KeysIn(ref, range[0], range[1]));
+		}
+		CHECK(ScanKeys(pf->OpenScan(nullptr, &ranges[1][0])) == KeysIn(ref, INT_MIN, ranges[1][0]));
+		CHECK(ScanKeys(pf->OpenScan(&ranges[1][1], nullptr)) == KeysIn(ref, ranges[1][1], INT_MAX));
+		CHECK(LookupMismatches(pf, ref, -10, numKeys + 10) == 0);
+
+		const int low = 1500, high = 2500;
+		IndexFileScan* scan = pf->OpenScan(&low, &high);
+		CHECK(scan->DeleteCurrent() == FAIL);	// nothing returned yet
+		RecordID rid;
+		int key, deleted = 0;
+		while (scan->GetNext(rid, key) == OK) {
+			if (key % 2 == 0) {
+				CHECK(scan->DeleteCurrent() == OK);
+				ref.erase(key);
+				deleted++;
+			}
+		}
+		delete scan;
+		CHECK(deleted > 0);
+		CHECK(ScanKeys(pf->OpenScan(nullptr, nullptr)) == KeysIn(ref, INT_MIN, INT_MAX));
+
+		delete pf;	// reopen with the same kind and bounds
+		pf = new PartitionedBTreeFile(status, CHECK_INDEX, numParts, (PartitionKind) kind, bounds);
+		CHECK(status == OK);
+		CHECK(ScanKeys(pf->OpenScan(nullptr, nullptr)) == KeysIn(ref, INT_MIN, INT_MAX));
+		CHECK(LookupMismatches(pf, ref, -10, numKeys + 10) == 0);
+		CHECK(pf->DestroyFile() == OK);
+		delete pf;
+	}
+	CHECK(MINIBASE_BM->GetNumOfUnpinnedFrames() == unpinned);
+}
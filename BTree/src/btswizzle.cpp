@@ -0,0 +1,141 @@
+#include "bufmgr.h"
+#include "btswizzle.h"
+
+
+//-------------------------------------------------------------------
+// BTSwizzleTable::Resolve
+//
+// Input   : pid - a page of the tree a descent has reached
+// Output  : indexPage - the frame of pid if it is an index page
+//           isLeaf - true if pid is a leaf
+//           mustUnpin - true if indexPage was pinned for this call
+//                       only (the table is full), and the caller must
+//                       unpin it when done
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Turn a child pid into a page.  A swizzled page or a known
+//           leaf costs nothing; otherwise the page is pinned once to
+//           learn its type, and an index page is swizzled while there
+//           is room for it.
+//-------------------------------------------------------------------
+
+Status
+BTSwizzleTable::Resolve(const PageID pid, BTIndexPage*& indexPage, bool& isLeaf, bool& mustUnpin)
+{
+	indexPage = Get(pid);
+	isLeaf = false;
+	mustUnpin = false;
+	if (indexPage != nullptr)
+	{
+		return OK;
+	}
+	Grow(pid);
+	if (kinds[pid] == LEAF)
+	{
+		isLeaf = true;
+		return OK;
+	}
+	SortedPage* page;
+	PIN(pid, page);
+	if (page->GetType() == LEAF_NODE)
+	{
+		kinds[pid] = LEAF;
+		isLeaf = true;
+		UNPIN(pid, CLEAN);
+		return OK;
+	}
+	indexPage = (BTIndexPage *) page;
+	if ((int) swizzled.size() >= maxPages)
+	{
+		mustUnpin = true;
+		return OK;
+	}
+	kinds[pid] = SWIZZLED;
+	frames[pid] = indexPage;	// the pin of PIN above stays with the table
+	swizzled.push_back(pid);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTSwizzleTable::Unswizzle
+//
+// Input   : pid - a swizzled page
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Give the page back to the buffer manager: forget its
+//           frame and drop the table's pin, after which it can be
+//           evicted.  Updates made through the frame were already
+//           marked dirty by the pins that made them.
+//-------------------------------------------------------------------
+
+Status
+BTSwizzleTable::Unswizzle(const PageID pid)
+{
+	if (Get(pid) == nullptr)
+	{
+		return OK;
+	}
+	kinds[pid] = UNKNOWN;
+	frames[pid] = nullptr;
+	for (size_t i = 0; i < swizzled.size(); i++)
+	{
+		if (swizzled[i] == pid)
+		{
+			swizzled[i] = swizzled.back();
+			swizzled.pop_back();
+			break;
+		}
+	}
+	UNPIN(pid, CLEAN);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// BTSwizzleTable::Clear
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Unswizzle every page and forget the known leaves.  Called
+//           before pages of the tree are freed, since their pids may
+//           be reused for pages of another kind.
+//-------------------------------------------------------------------
+
+Status
+BTSwizzleTable::Clear()
+{
+	Status s = OK;
+	for (size_t i = 0; i < swizzled.size(); i++)
+	{
+		if (MINIBASE_BM->UnpinPage(swizzled[i], CLEAN) != OK)
+		{
+			cerr << "Unable to unpin page " << swizzled[i] << endl;
+			s = FAIL;
+		}
+	}
+	swizzled.clear();
+	kinds.clear();
+	frames.clear();
+	return s;
+}
+
+
+//-------------------------------------------------------------------
+// BTSwizzleTable::Grow
+//
+// Input   : pid - a page id
+// Output  : None
+// Return  : None
+// Purpose : Make room for pid in the tables indexed by pid.
+//-------------------------------------------------------------------
+
+void
+BTSwizzleTable::Grow(const PageID pid)
+{
+	if (pid >= (PageID) kinds.size())
+	{
+		kinds.resize(pid + 1, UNKNOWN);
+		frames.resize(pid + 1, nullptr);
+	}
+}
@@ -0,0 +1,422 @@
+#include <thread>
+
+#include "bufmgr.h"
+#include "cbufmgr.h"
+
+// serializes all calls of the global buffer manager made by threads
+static std::mutex baseLatch;
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::ConcurrentBufMgr
+//
+// Input   : numFrames - the number of frames of the pool
+// Output  : None
+// Purpose : Create a pool of empty frames.
+//-------------------------------------------------------------------
+
+ConcurrentBufMgr::ConcurrentBufMgr(const int numFrames) : numFrames(numFrames), frames(numFrames), hand(0)
+{
+	for (int i = 0; i < numFrames; i++)
+	{
+		frames[i].pid = INVALID_PAGE;
+		frames[i].data = nullptr;
+		frames[i].pinCount.store(0);
+		frames[i].referenced.store(false);
+		frames[i].dirty.store(false);
+	}
+	ResetStat();
+}
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::PinPage
+//
+// Input   : pid - the page to pin
+//           emptyPage - the page is about to be overwritten whole, so
+//                       on a miss it need not be read
+// Output  : page - the frame holding the page
+// Return  : OK if successful, FAIL if every frame is pinned or the
+//           page cannot be read.
+// Purpose : Pin a page.  A hit takes the latch of the pid's partition
+//           only.  On a miss a frame is claimed by the clock sweep and
+//           filled from the global buffer manager; if another thread
+//           filled one with the same page meanwhile, the claimed frame
+//           is left empty and the page is pinned again.
+//-------------------------------------------------------------------
+
+Status
+ConcurrentBufMgr::PinPage(const PageID pid, Page*& page, const bool emptyPage)
+{
+	StatSlot& stat = MyStats();
+	stat.pins.fetch_add(1, std::memory_order_relaxed);
+	Partition& part = PartitionOf(pid);
+	while (true)
+	{
+		bool refilling = false;
+		{
+			std::lock_guard<std::mutex> guard(part.latch);
+			std::unordered_map<PageID, int>::iterator it = part.table.find(pid);
+			if (it != part.table.end())
+			{
+				PoolFrame& frame = frames[it->second];
+				int pins = frame.pinCount.load(std::memory_order_relaxed);
+				while (pins >= 0 && !frame.pinCount.compare_exchange_weak(pins, pins + 1, std::memory_order_acquire))
+				{
+				}
+				if (pins >= 0)
+				{
+					frame.referenced.store(true, std::memory_order_relaxed);
+					page = frame.data;
+					return OK;
+				}
+				refilling = true;	// a sweep claimed it, and is about to drop it from the table
+			}
+		}
+		if (refilling)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		int f = ClaimFrame();
+		if (f == INVALID_FRAME)
+		{
+			cerr << "No unpinned frame for page " << pid << endl;
+			return FAIL;
+		}
+		PoolFrame& frame = frames[f];
+		std::lock_guard<std::mutex> guard(part.latch);
+		if (part.table.count(pid) > 0)
+		{
+			frame.pinCount.store(0, std::memory_order_release);
+			continue;
+		}
+		LockBase();
+		Status s = MINIBASE_BM->PinPage(pid, frame.data, emptyPage);
+		UnlockBase();
+		if (s != OK)
+		{
+			cerr << "Unable to pin page " << pid << endl;
+			frame.pinCount.store(0, std::memory_order_release);
+			return FAIL;
+		}
+		frame.pid = pid;
+		frame.dirty.store(false, std::memory_order_relaxed);
+		frame.referenced.store(true, std::memory_order_relaxed);
+		frame.pinCount.store(1, std::memory_order_release);
+		part.table[pid] = f;
+		stat.misses.fetch_add(1, std::memory_order_relaxed);
+		page = frame.data;
+		return OK;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::UnpinPage
+//
+// Input   : pid - the page to unpin
+//           dirty - whether the page was changed
+// Output  : None
+// Return  : OK if successful, FAIL if the page is not pinned.
+// Purpose : Drop a pin of a page.  The frame stays filled until the
+//           clock sweep takes it.
+//-------------------------------------------------------------------
+
+Status
+ConcurrentBufMgr::UnpinPage(const PageID pid, const int dirty)
+{
+	Partition& part = PartitionOf(pid);
+	std::lock_guard<std::mutex> guard(part.latch);
+	std::unordered_map<PageID, int>::iterator it = part.table.find(pid);
+	if (it == part.table.end() || frames[it->second].pinCount.load(std::memory_order_relaxed) <= 0)
+	{
+		cerr << "Unable to unpin page " << pid << endl;
+		return FAIL;
+	}
+	PoolFrame& frame = frames[it->second];
+	if (dirty)
+	{
+		frame.dirty.store(true, std::memory_order_relaxed);
+	}
+	frame.pinCount.fetch_sub(1, std::memory_order_release);
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::NewPage
+//
+// Input   : howMany - the number of consecutive pages to allocate
+// Output  : firstPid - the first page allocated
+//           firstPage - the frame holding it
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Allocate pages in the DB file and pin the first, as
+//           BufMgr::NewPage does.
+//-------------------------------------------------------------------
+
+Status
+ConcurrentBufMgr::NewPage(PageID& firstPid, Page*& firstPage, const int howMany)
+{
+	LockBase();
+	Status s = MINIBASE_BM->NewPage(firstPid, firstPage, howMany);
+	if (s == OK)
+	{
+		s = MINIBASE_BM->UnpinPage(firstPid, false);
+	}
+	UnlockBase();
+	if (s != OK)
+	{
+		cerr << "Unable to allocate " << howMany << " pages" << endl;
+		return FAIL;
+	}
+	return PinPage(firstPid, firstPage, true);
+}
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::FreePage
+//
+// Input   : pid - the page to free
+// Output  : None
+// Return  : OK if successful, FAIL if the page is pinned or cannot be
+//           freed.
+// Purpose : Drop the page from the pool, if it is there, and free it
+//           in the DB file.
+//-------------------------------------------------------------------
+
+Status
+ConcurrentBufMgr::FreePage(const PageID pid)
+{
+	Partition& part = PartitionOf(pid);
+	while (true)
+	{
+		std::unique_lock<std::mutex> guard(part.latch);
+		std::unordered_map<PageID, int>::iterator it = part.table.find(pid);
+		if (it == part.table.end())
+		{
+			break;
+		}
+		PoolFrame& frame = frames[it->second];
+		int unpinned = 0;
+		if (frame.pinCount.compare_exchange_strong(unpinned, -1, std::memory_order_acquire))
+		{
+			part.table.erase(it);
+			guard.unlock();
+			frame.pid = INVALID_PAGE;
+			LockBase();
+			Status s = MINIBASE_BM->UnpinPage(pid, false);
+			UnlockBase();
+			frame.pinCount.store(0, std::memory_order_release);
+			if (s != OK)
+			{
+				cerr << "Unable to unpin page " << pid << endl;
+				return FAIL;
+			}
+			break;
+		}
+		if (unpinned > 0)
+		{
+			cerr << "Unable to free pinned page " << pid << endl;
+			return FAIL;
+		}
+		guard.unlock();
+		std::this_thread::yield();	// a sweep claimed it, and is about to drop it from the table
+	}
+	LockBase();
+	Status s = MINIBASE_BM->FreePage(pid);
+	UnlockBase();
+	if (s != OK)
+	{
+		cerr << "Unable to free page " << pid << endl;
+		return FAIL;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::ClaimFrame
+//
+// Input   : None
+// Output  : None
+// Return  : The claimed frame, empty and with pinCount -1, or
+//           INVALID_FRAME if every frame stayed pinned for two turns
+//           of the clock.
+// Purpose : Clock sweep.  The hand is a shared counter, so sweeping
+//           threads take different frames without a latch.  A frame
+//           referenced since the last turn gets its bit cleared and
+//           is passed; an unpinned one is claimed by setting its pin
+//           count from 0 to -1, which keeps it from being pinned
+//           until it is filled again.
+//-------------------------------------------------------------------
+
+int
+ConcurrentBufMgr::ClaimFrame()
+{
+	for (int i = 0; i < 2 * numFrames + 1; i++)
+	{
+		PoolFrame& frame = frames[hand.fetch_add(1, std::memory_order_relaxed) % numFrames];
+		if (frame.pinCount.load(std::memory_order_relaxed) != 0)
+		{
+			continue;
+		}
+		if (frame.referenced.exchange(false, std::memory_order_relaxed))
+		{
+			continue;
+		}
+		int unpinned = 0;
+		if (frame.pinCount.compare_exchange_strong(unpinned, -1, std::memory_order_acquire))
+		{
+			EmptyFrame(frame);
+			return (int) (&frame - &frames[0]);
+		}
+	}
+	return INVALID_FRAME;
+}
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::EmptyFrame
+//
+// Input   : frame - a claimed frame
+// Output  : None
+// Return  : OK if successful, FAIL if the page cannot be unpinned.
+// Purpose : Drop the page of a claimed frame from the page table and
+//           give it back to the global buffer manager.
+//-------------------------------------------------------------------
+
+Status
+ConcurrentBufMgr::EmptyFrame(PoolFrame& frame)
+{
+	PageID pid = frame.pid;
+	if (pid == INVALID_PAGE)
+	{
+		return OK;
+	}
+	{
+		Partition& part = PartitionOf(pid);
+		std::lock_guard<std::mutex> guard(part.latch);
+		part.table.erase(pid);
+	}
+	frame.pid = INVALID_PAGE;
+	LockBase();
+	Status s = MINIBASE_BM->UnpinPage(pid, frame.dirty.load(std::memory_order_relaxed));
+	UnlockBase();
+	if (s != OK)
+	{
+		cerr << "Unable to unpin page " << pid << endl;
+		return FAIL;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::FlushAllPages
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL if a page cannot be unpinned.
+// Purpose : Give every unpinned frame back to the global buffer
+//           manager, so its page can be written or freed there.
+//-------------------------------------------------------------------
+
+Status
+ConcurrentBufMgr::FlushAllPages()
+{
+	Status s = OK;
+	for (int i = 0; i < numFrames; i++)
+	{
+		int unpinned = 0;
+		if (frames[i].pinCount.compare_exchange_strong(unpinned, -1, std::memory_order_acquire))
+		{
+			if (EmptyFrame(frames[i]) != OK)
+			{
+				s = FAIL;
+			}
+			frames[i].pinCount.store(0, std::memory_order_release);
+		}
+	}
+	return s;
+}
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::GetStat, ConcurrentBufMgr::ResetStat
+//
+// Input   : None
+// Output  : pinNo - the number of pins
+//           missNo - the number of pins that had to fill a frame
+// Return  : OK
+// Purpose : Add up, or clear, the counts of all threads.  Counts
+//           taken while other threads pin pages are approximate.
+//-------------------------------------------------------------------
+
+Status
+ConcurrentBufMgr::GetStat(long& pinNo, long& missNo)
+{
+	pinNo = 0;
+	missNo = 0;
+	for (int i = 0; i < CBM_NUM_STAT_SLOTS; i++)
+	{
+		pinNo += stats[i].pins.load(std::memory_order_relaxed);
+		missNo += stats[i].misses.load(std::memory_order_relaxed);
+	}
+	return OK;
+}
+
+void
+ConcurrentBufMgr::ResetStat()
+{
+	for (int i = 0; i < CBM_NUM_STAT_SLOTS; i++)
+	{
+		stats[i].pins.store(0, std::memory_order_relaxed);
+		stats[i].misses.store(0, std::memory_order_relaxed);
+	}
+}
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::MyStats
+//
+// Input   : None
+// Output  : None
+// Return  : The statistics slot of the calling thread.
+// Purpose : Threads are given slots in the order they first pin a
+//           page, so up to CBM_NUM_STAT_SLOTS threads never write the
+//           same cache line.
+//-------------------------------------------------------------------
+
+ConcurrentBufMgr::StatSlot&
+ConcurrentBufMgr::MyStats()
+{
+	static std::atomic<int> nextSlot(0);
+	static thread_local int slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % CBM_NUM_STAT_SLOTS;
+	return stats[slot];
+}
+
+
+//-------------------------------------------------------------------
+// ConcurrentBufMgr::LockBase, ConcurrentBufMgr::UnlockBase
+//
+// Input   : None
+// Output  : None
+// Return  : None
+// Purpose : Hold the global buffer manager.  A thread that calls it
+//           directly while others may be using a pool takes this
+//           latch first.
+//-------------------------------------------------------------------
+
+void
+ConcurrentBufMgr::LockBase()
+{
+	baseLatch.lock();
+}
+
+void
+ConcurrentBufMgr::UnlockBase()
+{
+	baseLatch.unlock();
+}
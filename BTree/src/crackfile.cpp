@@ -0,0 +1,386 @@
+#include <climits>
+
+#include "minirel.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "new_error.h"
+#include "heappage.h"
+#include "crackfile.h"
+#include "crackfilescan.h"
+
+
+// Keeps the page of one position of the cracker column pinned while a
+// partition walks over it, so a page is pinned once per visit rather
+// than once per entry.
+
+class CrackCursor {
+
+public:
+
+	CrackCursor(const std::vector<PageID>& pages) : pages(pages), pageNo(-1), entries(nullptr), dirty(false) {}
+	~CrackCursor() { Release(); }
+
+	LeafEntry* At(const int pos)
+	{
+		int p = pos / CRACK_ENTRIES_PER_PAGE;
+		if (p != pageNo)
+		{
+			Release();
+			if (MINIBASE_BM->PinPage(pages[p], (Page *&) entries) != OK)
+			{
+				return nullptr;
+			}
+			pageNo = p;
+		}
+		return entries + pos % CRACK_ENTRIES_PER_PAGE;
+	}
+	void MarkDirty() { dirty = true; }
+	void Release()
+	{
+		if (pageNo >= 0)
+		{
+			MINIBASE_BM->UnpinPage(pages[pageNo], dirty);
+		}
+		pageNo = -1;
+		dirty = false;
+	}
+
+private:
+
+	const std::vector<PageID>& pages;
+	int pageNo;
+	LeafEntry* entries;
+	bool dirty;
+};
+
+
+//-------------------------------------------------------------------
+// CrackFile::CrackFile
+//
+// Input   : None
+// Output  : returnStatus - OK
+// Purpose : Create an empty cracking index.
+//-------------------------------------------------------------------
+
+CrackFile::CrackFile(Status& returnStatus)
+{
+	numEntries = 0;
+	returnStatus = OK;
+}
+
+
+//-------------------------------------------------------------------
+// CrackFile::~CrackFile
+//
+// Input   : None
+// Output  : None
+// Purpose : Free the cracker column.
+//-------------------------------------------------------------------
+
+CrackFile::~CrackFile()
+{
+	DestroyFile();
+}
+
+
+//-------------------------------------------------------------------
+// CrackFile::DestroyFile
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Free all pages and forget all entries and pieces.
+//-------------------------------------------------------------------
+
+Status
+CrackFile::DestroyFile()
+{
+	for (size_t i = 0; i < pages.size(); i++){
+		FREEPAGE(pages[i]);
+	}
+	pages.clear();
+	boundaries.clear();
+	numEntries = 0;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CrackFile::Insert
+//
+// Input   : key, rid - the entry to insert
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Ripple insert.  The hole starts at the end of the column
+//           and walks left: each piece after the one key belongs to
+//           moves its first entry into the hole at its end.  The hole
+//           ends up at the end of the piece of key.
+//-------------------------------------------------------------------
+
+Status
+CrackFile::Insert(const int key, const RecordID rid)
+{
+	if (numEntries == (int) pages.size() * CRACK_ENTRIES_PER_PAGE){
+		PageID pid;
+		Page* page;
+		NEWPAGE(pid,page);
+		UNPIN(pid,DIRTY);
+		pages.push_back(pid);
+	}
+	int hole = numEntries;
+	for (std::map<int, int>::reverse_iterator it = boundaries.rbegin(); it != boundaries.rend() && it->first > key; ++it){
+		int start = it->second;
+		if (start != hole){ //an empty piece has nothing to move
+			if (Move(start, hole) != OK){
+				return FAIL;
+			}
+			hole = start;
+		}
+		it->second = start + 1;
+	}
+	LeafEntry entry;
+	entry.key = key;
+	entry.rid = rid;
+	if (Write(hole, entry) != OK){
+		return FAIL;
+	}
+	numEntries++;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CrackFile::Delete
+//
+// Input   : key, rid - the entry to delete
+// Output  : None
+// Return  : OK if successful, FAIL if the entry is not in the index.
+// Purpose : Ripple delete, the reverse of Insert.  The last entry of
+//           the piece fills the deleted slot, and every later piece
+//           moves its last entry into the hole in front of it.
+//-------------------------------------------------------------------
+
+Status
+CrackFile::Delete(const int key, const RecordID rid)
+{
+	int lo, hi;
+	PieceOf(key, lo, hi);
+	int pos = -1;
+	{
+		CrackCursor cursor(pages);
+		for (int i = lo; i < hi && pos < 0; i++){
+			LeafEntry* entry = cursor.At(i);
+			if (entry == nullptr){
+				return FAIL;
+			}
+			if (entry->key == key && entry->rid == rid){
+				pos = i;
+			}
+		}
+	}
+	if (pos < 0){
+		return FAIL;
+	}
+	if (Move(hi - 1, pos) != OK){
+		return FAIL;
+	}
+	int hole = hi - 1;
+	for (std::map<int, int>::iterator it = boundaries.upper_bound(key); it != boundaries.end(); ++it){
+		std::map<int, int>::iterator next = it;
+		++next;
+		int end = (next == boundaries.end()) ? numEntries : next->second;
+		if (end != it->second){ //an empty piece has nothing to move
+			if (Move(end - 1, hole) != OK){
+				return FAIL;
+			}
+			hole = end - 1;
+		}
+		it->second--;
+	}
+	numEntries--;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CrackFile::OpenScan
+//
+// Input   : lowKey, highKey - pointer to keys, indicate the range
+//                             to scan; nullptr leaves that end open.
+// Output  : None
+// Return  : A scan over the entries with lowKey <= key <= highKey.
+// Purpose : Crack the column at both bounds, which makes the range a
+//           run of whole pieces, and scan that run.
+//-------------------------------------------------------------------
+
+IndexFileScan*
+CrackFile::OpenScan(const int* lowKey, const int* highKey)
+{
+	CrackFileScan* scan = new CrackFileScan();
+	scan->crackfile = this;
+	scan->scanned = false;
+	scan->cur = 0;
+	scan->end = 0;
+	if (lowKey != nullptr && highKey != nullptr && *lowKey > *highKey){
+		return scan;
+	}
+	int start = 0;
+	int end = numEntries;
+	if (lowKey != nullptr && Crack(*lowKey, start) != OK){
+		return scan;
+	}
+	if (highKey != nullptr && *highKey != INT_MAX && Crack(*highKey + 1, end) != OK){
+		return scan;
+	}
+	scan->cur = start;
+	scan->end = end;
+	return scan;
+}
+
+
+//-------------------------------------------------------------------
+// CrackFile::Crack
+//
+// Input   : key - the boundary to add
+// Output  : pos - the first position of the keys not less than key
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Make key a piece boundary.  Only the one piece that
+//           contains key is partitioned.
+//-------------------------------------------------------------------
+
+Status
+CrackFile::Crack(const int key, int& pos)
+{
+	std::map<int, int>::iterator it = boundaries.find(key);
+	if (it != boundaries.end()){
+		pos = it->second;
+		return OK;
+	}
+	int lo, hi;
+	PieceOf(key, lo, hi);
+	if (Partition(lo, hi, key, pos) != OK){
+		return FAIL;
+	}
+	boundaries[key] = pos;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CrackFile::Partition
+//
+// Input   : lo, hi - the positions [lo, hi) of one piece
+//           key - the pivot
+// Output  : split - the first position of the keys not less than key
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Partition the piece in place, smaller keys first, by
+//           swapping from both ends towards the middle.
+//-------------------------------------------------------------------
+
+Status
+CrackFile::Partition(int lo, int hi, const int key, int& split)
+{
+	CrackCursor left(pages), right(pages);
+	int i = lo, j = hi - 1;
+	while (true){
+		LeafEntry* a = nullptr;
+		LeafEntry* b = nullptr;
+		while (i <= j){
+			if ((a = left.At(i)) == nullptr){
+				return FAIL;
+			}
+			if (a->key >= key){
+				break;
+			}
+			i++;
+		}
+		while (i < j){
+			if ((b = right.At(j)) == nullptr){
+				return FAIL;
+			}
+			if (b->key < key){
+				break;
+			}
+			j--;
+		}
+		if (i >= j){
+			break;
+		}
+		LeafEntry tmp = *a;
+		*a = *b;
+		*b = tmp;
+		left.MarkDirty();
+		right.MarkDirty();
+		i++;
+		j--;
+	}
+	split = i;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CrackFile::PieceOf
+//
+// Input   : key - a key
+// Output  : lo, hi - the positions [lo, hi) of the piece of key
+// Return  : None
+// Purpose : Look the piece that holds key up in the cracker tree.
+//-------------------------------------------------------------------
+
+void
+CrackFile::PieceOf(const int key, int& lo, int& hi)
+{
+	std::map<int, int>::iterator it = boundaries.upper_bound(key);
+	hi = (it == boundaries.end()) ? numEntries : it->second;
+	if (it == boundaries.begin()){
+		lo = 0;
+	}
+	else{
+		--it;
+		lo = it->second;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// CrackFile::Move, Read, Write
+//
+// Copy one entry between positions, or in and out of a position, of
+// the cracker column.
+//-------------------------------------------------------------------
+
+Status
+CrackFile::Move(const int from, const int to)
+{
+	LeafEntry entry;
+	if (from == to){
+		return OK;
+	}
+	if (Read(from, entry) != OK){
+		return FAIL;
+	}
+	return Write(to, entry);
+}
+
+Status
+CrackFile::Read(const int pos, LeafEntry& entry)
+{
+	LeafEntry* entries;
+	PageID pid = pages[pos / CRACK_ENTRIES_PER_PAGE];
+	PIN(pid,entries);
+	entry = entries[pos % CRACK_ENTRIES_PER_PAGE];
+	UNPIN(pid,CLEAN);
+	return OK;
+}
+
+Status
+CrackFile::Write(const int pos, const LeafEntry& entry)
+{
+	LeafEntry* entries;
+	PageID pid = pages[pos / CRACK_ENTRIES_PER_PAGE];
+	PIN(pid,entries);
+	entries[pos % CRACK_ENTRIES_PER_PAGE] = entry;
+	UNPIN(pid,DIRTY);
+	return OK;
+}
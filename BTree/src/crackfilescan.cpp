@@ -0,0 +1,64 @@
+#include "minirel.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "new_error.h"
+#include "crackfile.h"
+#include "crackfilescan.h"
+
+
+//-------------------------------------------------------------------
+// CrackFileScan::GetNext
+//
+// Input   : None
+// Output  : rid  - record id of the scanned entry.
+//           key  - key of the scanned entry
+// Purpose : Return the next entry of the cracked range.
+// Return  : OK if successful, DONE if no more entries to read.
+//-------------------------------------------------------------------
+
+Status
+CrackFileScan::GetNext(RecordID& rid, int& key)
+{
+	if (this->cur >= this->end){
+		return DONE;
+	}
+	LeafEntry entry;
+	if (crackfile->Read(this->cur, entry) != OK){
+		return FAIL;
+	}
+	this->cur++;
+	rid = entry.rid;
+	key = entry.key;
+	this->lastKey = key;
+	this->lastRid = rid;
+	this->scanned = true;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CrackFileScan::DeleteCurrent
+//
+// Input   : None
+// Output  : None
+// Purpose : Delete the entry returned by the previous GetNext.  The
+//           ripple delete fills its slot with an entry of the same
+//           piece, which is inside the range and not returned yet,
+//           and moves the end of the range one to the left.
+// Return  : OK if successful, DONE if there is no current entry.
+//-------------------------------------------------------------------
+
+Status
+CrackFileScan::DeleteCurrent()
+{
+	if (!this->scanned){
+		return DONE;
+	}
+	if (crackfile->Delete(this->lastKey, this->lastRid) != OK){
+		return DONE;
+	}
+	this->scanned = false;
+	this->cur--;
+	this->end--;
+	return OK;
+}
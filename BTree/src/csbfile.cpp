@@ -0,0 +1,313 @@
+#include <string.h>
+
+#include "minirel.h"
+#include "csbfile.h"
+#include "csbfilescan.h"
+
+
+//-------------------------------------------------------------------
+// CSBTreeFile::CSBTreeFile
+//
+// Input   : None
+// Output  : returnStatus - OK
+// Purpose : Create an empty index, a root leaf with no entries.
+//-------------------------------------------------------------------
+
+CSBTreeFile::CSBTreeFile(Status& returnStatus)
+{
+	Init();
+	returnStatus = OK;
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFile::Init
+//
+// Input   : None
+// Output  : None
+// Return  : None
+// Purpose : Start over with an empty root leaf.
+//-------------------------------------------------------------------
+
+void
+CSBTreeFile::Init()
+{
+	CSBLeaf* leaf = (CSBLeaf *) arena.Allocate(sizeof(CSBLeaf));
+	leaf->numKeys = 0;
+	root = leaf;
+	height = 0;
+	numEntries = 0;
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFile::DestroyFile
+//
+// Input   : None
+// Output  : None
+// Return  : OK
+// Purpose : Drop all entries.  The arena gives all nodes back at once,
+//           and the index is left empty and usable.
+//-------------------------------------------------------------------
+
+Status
+CSBTreeFile::DestroyFile()
+{
+	arena.Clear();
+	Init();
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFile::Insert
+//
+// Input   : key, rid - the entry to insert
+// Output  : None
+// Return  : OK
+// Purpose : Insert the entry after the entries with an equal key.  A
+//           split of the root puts a new root above the old one, with
+//           both halves as its group of children.
+//-------------------------------------------------------------------
+
+Status
+CSBTreeFile::Insert(const int key, const RecordID rid)
+{
+	bool split;
+	int upKey;
+	alignas(ARENA_LINE) char right[sizeof(CSBLeaf)];
+	InsertHelper(root, height, key, rid, split, upKey, right);
+	numEntries++;
+	if (split){
+		size_t nodeSize = NodeSize(height);
+		char halves[2 * sizeof(CSBLeaf)];
+		memcpy(halves, root, nodeSize);
+		memcpy(halves + nodeSize, right, nodeSize);
+		arena.Release(root, nodeSize);
+		CSBInner* newRoot = (CSBInner *) arena.Allocate(sizeof(CSBInner));
+		newRoot->numKeys = 1;
+		newRoot->keys[0] = upKey;
+		newRoot->children = NewGroup(halves, 2, nodeSize);
+		root = newRoot;
+		height++;
+	}
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFile::InsertHelper
+//
+// Input   : node - a node on the path of key
+//           level - its height above the leaves, 0 for a leaf
+//           key, rid - the entry to insert
+//           right - room for a node of the size of node
+// Output  : split - true if node was split
+//           upKey - if split, the lowest key of the right half
+//           right - if split, the right half; node is the left half
+// Return  : None
+// Purpose : Insert below node.  When a child splits, the group of
+//           children is copied into a new group with the right half
+//           after the child, and the old group is released.  If node
+//           is full it splits too, and its children are divided into
+//           two new groups.
+//-------------------------------------------------------------------
+
+void
+CSBTreeFile::InsertHelper(void* node, const int level, const int key, const RecordID rid, bool& split, int& upKey, void* right)
+{
+	split = false;
+	if (level == 0){
+		CSBLeaf* leaf = (CSBLeaf *) node;
+		int slot = UpperBound(leaf->keys, leaf->numKeys, key);
+		if (leaf->numKeys < CSB_LEAF_KEYS){
+			memmove(leaf->keys + slot + 1, leaf->keys + slot, (leaf->numKeys - slot) * sizeof(int));
+			memmove(leaf->rids + slot + 1, leaf->rids + slot, (leaf->numKeys - slot) * sizeof(RecordID));
+			leaf->keys[slot] = key;
+			leaf->rids[slot] = rid;
+			leaf->numKeys++;
+			return;
+		}
+		int keys[CSB_LEAF_KEYS + 1];
+		RecordID rids[CSB_LEAF_KEYS + 1];
+		memcpy(keys, leaf->keys, slot * sizeof(int));
+		memcpy(rids, leaf->rids, slot * sizeof(RecordID));
+		keys[slot] = key;
+		rids[slot] = rid;
+		memcpy(keys + slot + 1, leaf->keys + slot, (CSB_LEAF_KEYS - slot) * sizeof(int));
+		memcpy(rids + slot + 1, leaf->rids + slot, (CSB_LEAF_KEYS - slot) * sizeof(RecordID));
+		int keep = (CSB_LEAF_KEYS + 1) / 2;
+		CSBLeaf* rightLeaf = (CSBLeaf *) right;
+		leaf->numKeys = keep;
+		memcpy(leaf->keys, keys, keep * sizeof(int));
+		memcpy(leaf->rids, rids, keep * sizeof(RecordID));
+		rightLeaf->numKeys = CSB_LEAF_KEYS + 1 - keep;
+		memcpy(rightLeaf->keys, keys + keep, rightLeaf->numKeys * sizeof(int));
+		memcpy(rightLeaf->rids, rids + keep, rightLeaf->numKeys * sizeof(RecordID));
+		upKey = rightLeaf->keys[0];
+		split = true;
+		return;
+	}
+
+	CSBInner* inner = (CSBInner *) node;
+	size_t childSize = NodeSize(level - 1);
+	char* children = (char *) inner->children;
+	int childSlot = UpperBound(inner->keys, inner->numKeys, key);
+	bool childSplit;
+	int childKey;
+	alignas(ARENA_LINE) char childRight[sizeof(CSBLeaf)];
+	InsertHelper(children + childSlot * childSize, level - 1, key, rid, childSplit, childKey, childRight);
+	if (!childSplit){
+		return;
+	}
+
+	//the new group: the old one with the right half after the child
+	int n = inner->numKeys + 1;
+	alignas(ARENA_LINE) char group[(CSB_INNER_KEYS + 2) * sizeof(CSBLeaf)];
+	memcpy(group, children, (childSlot + 1) * childSize);
+	memcpy(group + (childSlot + 1) * childSize, childRight, childSize);
+	memcpy(group + (childSlot + 2) * childSize, children + (childSlot + 1) * childSize, (n - childSlot - 1) * childSize);
+	int keys[CSB_INNER_KEYS + 1];
+	memcpy(keys, inner->keys, childSlot * sizeof(int));
+	keys[childSlot] = childKey;
+	memcpy(keys + childSlot + 1, inner->keys + childSlot, (inner->numKeys - childSlot) * sizeof(int));
+	arena.Release(children, n * childSize);
+
+	int numKeys = inner->numKeys + 1;
+	if (numKeys <= CSB_INNER_KEYS){
+		memcpy(inner->keys, keys, numKeys * sizeof(int));
+		inner->numKeys = numKeys;
+		inner->children = NewGroup(group, numKeys + 1, childSize);
+		return;
+	}
+
+	//node is full: the middle key moves up, the children are divided
+	int keep = numKeys / 2;
+	CSBInner* rightInner = (CSBInner *) right;
+	inner->numKeys = keep;
+	memcpy(inner->keys, keys, keep * sizeof(int));
+	inner->children = NewGroup(group, keep + 1, childSize);
+	upKey = keys[keep];
+	rightInner->numKeys = numKeys - keep - 1;
+	memcpy(rightInner->keys, keys + keep + 1, rightInner->numKeys * sizeof(int));
+	rightInner->children = NewGroup(group + (keep + 1) * childSize, rightInner->numKeys + 1, childSize);
+	split = true;
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFile::NewGroup
+//
+// Input   : nodes - n nodes of nodeSize bytes each
+// Output  : None
+// Return  : A new node group in the arena holding a copy of nodes.
+// Purpose : Allocate a node group.
+//-------------------------------------------------------------------
+
+void*
+CSBTreeFile::NewGroup(const void* nodes, const int n, const size_t nodeSize)
+{
+	void* group = arena.Allocate(n * nodeSize);
+	memcpy(group, nodes, n * nodeSize);
+	return group;
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFile::Delete
+//
+// Input   : key, rid - the entry to delete
+// Output  : None
+// Return  : OK if deleted, FAIL if there is no such entry.
+// Purpose : Remove the entry from its leaf.  Nodes are not merged; a
+//           leaf may become empty and stays in the tree.
+//-------------------------------------------------------------------
+
+Status
+CSBTreeFile::Delete(const int key, const RecordID rid)
+{
+	CSBTreeFileScan scan(this, &key, &key);
+	RecordID curRid;
+	int curKey;
+	while (scan.GetNext(curRid, curKey) == OK){
+		if (curRid == rid){
+			return scan.DeleteCurrent();
+		}
+	}
+	return FAIL;
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFile::Lookup
+//
+// Input   : key - the key to look up
+// Output  : rid - the record id of the first entry with key
+// Return  : OK if found, DONE if key is not in the index.
+// Purpose : Point lookup.
+//-------------------------------------------------------------------
+
+Status
+CSBTreeFile::Lookup(const int key, RecordID& rid)
+{
+	CSBTreeFileScan scan(this, &key, &key);
+	int curKey;
+	return scan.GetNext(rid, curKey);
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFile::OpenScan
+//
+// Input   : lowKey, highKey - the range, nullptr for no bound
+// Output  : None
+// Return  : A scan of the entries with lowKey <= key <= highKey.  The
+//           caller deletes it.
+// Purpose : Range scan.
+//-------------------------------------------------------------------
+
+IndexFileScan*
+CSBTreeFile::OpenScan(const int* lowKey, const int* highKey)
+{
+	return new CSBTreeFileScan(this, lowKey, highKey);
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFile::LowerBound, CSBTreeFile::UpperBound
+//
+// Input   : keys - n sorted keys
+//           key - the key to search for
+// Output  : None
+// Return  : The number of keys less than key (LowerBound), or not
+//           greater than key (UpperBound).
+// Purpose : Binary search within a node.
+//-------------------------------------------------------------------
+
+int
+CSBTreeFile::LowerBound(const int* keys, const int n, const int key)
+{
+	int lo = 0, hi = n;
+	while (lo < hi){
+		int mid = (lo + hi) / 2;
+		if (keys[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+int
+CSBTreeFile::UpperBound(const int* keys, const int n, const int key)
+{
+	int lo = 0, hi = n;
+	while (lo < hi){
+		int mid = (lo + hi) / 2;
+		if (key < keys[mid])
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
@@ -0,0 +1,152 @@
+#include <climits>
+#include <string.h>
+
+#include "minirel.h"
+#include "csbfile.h"
+#include "csbfilescan.h"
+
+
+//-------------------------------------------------------------------
+// CSBTreeFileScan::CSBTreeFileScan
+//
+// Input   : file - the index to scan
+//           lowKey, highKey - the range, nullptr for no bound
+// Output  : None
+// Purpose : Position the scan on the first entry not less than lowKey.
+//           The descent takes the leftmost child that can hold lowKey,
+//           as a run of equal keys may start left of its separator.
+//-------------------------------------------------------------------
+
+CSBTreeFileScan::CSBTreeFileScan(CSBTreeFile* file, const int* lowKey, const int* highKey)
+{
+	this->csbfile = file;
+	this->highKey = (highKey != nullptr) ? *highKey : INT_MAX;
+	this->scanned = false;
+	if (file->height > 0){
+		CSBInner* inner = (CSBInner *) file->root;
+		path[0].node = inner;
+		path[0].slot = (lowKey != nullptr) ? CSBTreeFile::LowerBound(inner->keys, inner->numKeys, *lowKey) : 0;
+	}
+	Descend(0, lowKey);
+	if (lowKey != nullptr && highKey != nullptr && *lowKey > *highKey){
+		this->leaf = nullptr;
+	}
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFileScan::Descend
+//
+// Input   : level - the lowest level of path already set
+//           lowKey - the key to descend to, nullptr for the leftmost
+// Output  : None
+// Return  : None
+// Purpose : Fill in the path below level, and the leaf and slot.
+//-------------------------------------------------------------------
+
+void
+CSBTreeFileScan::Descend(int level, const int* lowKey)
+{
+	int height = csbfile->height;
+	if (height == 0){
+		this->leaf = (CSBLeaf *) csbfile->root;
+	}
+	else{
+		for (int i = level + 1; i <= height; i++){
+			char* child = (char *) path[i-1].node->children + path[i-1].slot * CSBTreeFile::NodeSize(height - i);
+			if (i == height){
+				this->leaf = (CSBLeaf *) child;
+				break;
+			}
+			CSBInner* inner = (CSBInner *) child;
+			path[i].node = inner;
+			path[i].slot = (lowKey != nullptr) ? CSBTreeFile::LowerBound(inner->keys, inner->numKeys, *lowKey) : 0;
+		}
+	}
+	this->slot = (lowKey != nullptr) ? CSBTreeFile::LowerBound(leaf->keys, leaf->numKeys, *lowKey) : 0;
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFileScan::NextLeaf
+//
+// Input   : None
+// Output  : None
+// Return  : None
+// Purpose : Move to the first slot of the next leaf: up to the lowest
+//           node with a child right of the path, then down its
+//           leftmost branch.  leaf is nullptr after the last leaf.
+//-------------------------------------------------------------------
+
+void
+CSBTreeFileScan::NextLeaf()
+{
+	int i = csbfile->height - 1;
+	while (i >= 0 && path[i].slot == path[i].node->numKeys){
+		i--;
+	}
+	if (i < 0){
+		this->leaf = nullptr;
+		return;
+	}
+	path[i].slot++;
+	Descend(i, nullptr);
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFileScan::GetNext
+//
+// Input   : None
+// Output  : rid  - record id of the scanned entry.
+//           key  - key of the scanned entry
+// Purpose : Return the next entry of the range.
+// Return  : OK if successful, DONE if no more entries to read.
+//-------------------------------------------------------------------
+
+Status
+CSBTreeFileScan::GetNext(RecordID& rid, int& key)
+{
+	this->scanned = false;
+	while (this->leaf != nullptr){
+		if (this->slot < leaf->numKeys){
+			if (leaf->keys[this->slot] > this->highKey){
+				this->leaf = nullptr;
+				break;
+			}
+			key = leaf->keys[this->slot];
+			rid = leaf->rids[this->slot];
+			this->slot++;
+			this->scanned = true;
+			return OK;
+		}
+		NextLeaf();
+	}
+	return DONE;
+}
+
+
+//-------------------------------------------------------------------
+// CSBTreeFileScan::DeleteCurrent
+//
+// Input   : None
+// Output  : None
+// Purpose : Delete the entry returned by the previous GetNext.
+// Return  : OK if successful, DONE if there is no such entry.
+//-------------------------------------------------------------------
+
+Status
+CSBTreeFileScan::DeleteCurrent()
+{
+	if (!this->scanned){
+		return DONE;
+	}
+	this->slot--;
+	int rest = leaf->numKeys - this->slot - 1;
+	memmove(leaf->keys + this->slot, leaf->keys + this->slot + 1, rest * sizeof(int));
+	memmove(leaf->rids + this->slot, leaf->rids + this->slot + 1, rest * sizeof(RecordID));
+	leaf->numKeys--;
+	csbfile->numEntries--;
+	this->scanned = false;
+	return OK;
+}
@@ -34,9 +34,11 @@ int main(int argc, char *argv[]) {
 		cout << "Commands should be of the form:" << endl;
 		cout << "insert <low> <high>" << endl;
 		cout << "scan <low> <high>" << endl;
+		cout << "lookup <low> <high>" << endl;
 		cout << "delete <low> <high>" << endl;
 		cout << "print" << endl;
 		cout << "stats" << endl;
+		cout << "check <name>  (see checks.txt for the names)" << endl;
 		cout << "quit" << endl;
 		cout << "Note that (<low>==-1)=>min and (<high>==-1)=>max" << endl;
 
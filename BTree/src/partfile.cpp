@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <string>
+
+#include "minirel.h"
+#include "bufmgr.h"
+#include "partfile.h"
+#include "partfilescan.h"
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFile::PartitionedBTreeFile
+//
+// Input   : filename - name of the index
+//           numParts - the number of partitions, 1 to
+//                      PART_MAX_PARTITIONS
+//           kind - how keys are assigned to partitions
+//           bounds - PART_RANGE only: numParts - 1 ascending keys,
+//                    the lowest key of every partition but the first
+// Output  : status - OK if successful, FAIL otherwise.
+// Purpose : Open the B+ tree of every partition, creating the ones
+//           that do not exist.
+//-------------------------------------------------------------------
+
+PartitionedBTreeFile::PartitionedBTreeFile(Status& status, const char* filename, const int numParts, const PartitionKind kind, const int* bounds)
+{
+	this->kind = kind;
+	status = FAIL;
+	if (numParts < 1 || numParts > PART_MAX_PARTITIONS || (kind == PART_RANGE && numParts > 1 && bounds == nullptr)){
+		return;
+	}
+	if (kind == PART_RANGE){
+		this->bounds.assign(bounds, bounds + numParts - 1);
+		for (int i = 1; i < numParts - 1; i++){
+			if (bounds[i] <= bounds[i-1]){
+				return;
+			}
+		}
+	}
+	names.reserve(numParts); //the trees keep pointers to the names
+	for (int i = 0; i < numParts; i++){
+		names.push_back(std::string(filename) + "." + std::to_string(i));
+		Status s;
+		parts.push_back(new BTreeFile(s, names[i].c_str()));
+		if (s != OK){
+			return;
+		}
+	}
+	status = OK;
+}
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFile::~PartitionedBTreeFile
+//
+// Input   : None
+// Output  : None
+// Purpose : Close the partitions.
+//-------------------------------------------------------------------
+
+PartitionedBTreeFile::~PartitionedBTreeFile()
+{
+	for (size_t i = 0; i < parts.size(); i++){
+		delete parts[i];
+	}
+}
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFile::DestroyFile
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Delete the B+ tree of every partition.
+//-------------------------------------------------------------------
+
+Status
+PartitionedBTreeFile::DestroyFile()
+{
+	Status s = OK;
+	for (size_t i = 0; i < parts.size(); i++){
+		if (parts[i]->DestroyFile() != OK){
+			s = FAIL;
+		}
+	}
+	return s;
+}
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFile::Insert, PartitionedBTreeFile::Delete,
+// PartitionedBTreeFile::Lookup
+//
+// Input   : as for BTreeFile
+// Output  : as for BTreeFile
+// Return  : as for BTreeFile
+// Purpose : Call the tree of the key's partition.
+//-------------------------------------------------------------------
+
+Status
+PartitionedBTreeFile::Insert(const int key, const RecordID rid)
+{
+	return parts[PartitionOf(key)]->Insert(key, rid);
+}
+
+Status
+PartitionedBTreeFile::Delete(const int key, const RecordID rid)
+{
+	return parts[PartitionOf(key)]->Delete(key, rid);
+}
+
+Status
+PartitionedBTreeFile::Lookup(const int key, RecordID& rid)
+{
+	return parts[PartitionOf(key)]->Lookup(key, rid);
+}
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFile::OpenScan
+//
+// Input   : lowKey, highKey - the range, as for BTreeFile
+// Output  : None
+// Return  : A pointer to IndexFileScan class.
+// Purpose : Initialize a merged scan of the partitions.
+//-------------------------------------------------------------------
+
+IndexFileScan*
+PartitionedBTreeFile::OpenScan(const int* lowKey, const int* highKey)
+{
+	return new PartitionedBTreeFileScan(this, lowKey, highKey);
+}
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFile::EnableConcurrency
+//
+// Input   : enable - whether threads will use the file at once
+//           poolFrames - most frames of the pool of each partition
+// Output  : None
+// Return  : None
+// Purpose : Switch latching on or off in every partition.  The pools
+//           together take at most half of the unpinned frames of the
+//           global buffer pool, as the one of a single BTreeFile does.
+//-------------------------------------------------------------------
+
+void
+PartitionedBTreeFile::EnableConcurrency(bool enable, const int poolFrames)
+{
+	int share = (int) (MINIBASE_BM->GetNumOfUnpinnedFrames() / (2 * parts.size()));
+	for (size_t i = 0; i < parts.size(); i++){
+		parts[i]->EnableConcurrency(enable, std::max(1, std::min(poolFrames, share)));
+	}
+}
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFile::PartitionOf
+//
+// Input   : key - a key
+// Output  : None
+// Return  : the partition the key belongs to.
+// Purpose : Range partitions are found by binary search in bounds.
+//           The hash mixes all bits of the key (the finalizer of
+//           MurmurHash3), so keys that differ in a few low bits, or
+//           only in their high bits, still spread evenly.
+//-------------------------------------------------------------------
+
+int
+PartitionedBTreeFile::PartitionOf(const int key)
+{
+	if (kind == PART_RANGE){
+		return (int) (std::upper_bound(bounds.begin(), bounds.end(), key) - bounds.begin());
+	}
+	unsigned int h = (unsigned int) key;
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return (int) (h % parts.size());
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+
+#include "minirel.h"
+#include "partfile.h"
+#include "partfilescan.h"
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFileScan::PartitionedBTreeFileScan
+//
+// Input   : file - the index to scan
+//           lowKey, highKey - the range, nullptr for no bound
+// Output  : None
+// Purpose : Open a scan of every partition that can hold keys of the
+//           range, which with range partitioning are the ones between
+//           the partitions of lowKey and highKey, and read the first
+//           entry of each.
+//-------------------------------------------------------------------
+
+PartitionedBTreeFileScan::PartitionedBTreeFileScan(PartitionedBTreeFile* file, const int* lowKey, const int* highKey)
+{
+	int numParts = file->GetNumOfPartitions();
+	int first = 0, last = numParts - 1;
+	if (file->kind == PART_RANGE){
+		first = (lowKey != nullptr) ? file->PartitionOf(*lowKey) : 0;
+		last = (highKey != nullptr) ? file->PartitionOf(*highKey) : numParts - 1;
+	}
+	scans.assign(numParts, nullptr);
+	current = -1;
+	s = OK;
+	for (int i = first; i <= last; i++){
+		scans[i] = file->parts[i]->OpenScan(lowKey, highKey);
+		if (Advance(i) != OK){
+			s = FAIL;
+		}
+	}
+}
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFileScan::~PartitionedBTreeFileScan
+//
+// Input   : None
+// Output  : None
+// Purpose : Close the scans of the partitions.
+//-------------------------------------------------------------------
+
+PartitionedBTreeFileScan::~PartitionedBTreeFileScan()
+{
+	for (size_t i = 0; i < scans.size(); i++){
+		delete scans[i];
+	}
+}
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFileScan::GetNext
+//
+// Input   : None
+// Output  : rid  - record id of the scanned record.
+//           key  - key of the scanned record
+// Return  : OK if successful, DONE if no more records to read, FAIL
+//           otherwise.
+// Purpose : Return the smallest entry in the heap.  The partition
+//           scan it came from is moved on only by the next call, so
+//           that DeleteCurrent still finds it current.
+//-------------------------------------------------------------------
+
+Status
+PartitionedBTreeFileScan::GetNext(RecordID& rid, int& key)
+{
+	if (s != OK){
+		return s;
+	}
+	if (current >= 0){
+		if (Advance(current) != OK){
+			s = FAIL;
+			return s;
+		}
+		current = -1;
+	}
+	if (heap.empty()){
+		return DONE;
+	}
+	std::pop_heap(heap.begin(), heap.end(), After);
+	Head head = heap.back();
+	heap.pop_back();
+	key = head.key;
+	rid = head.rid;
+	current = head.part;
+	return OK;
+}
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFileScan::DeleteCurrent
+//
+// Input   : None
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Delete the entry returned last, through the scan of its
+//           partition.
+//-------------------------------------------------------------------
+
+Status
+PartitionedBTreeFileScan::DeleteCurrent()
+{
+	if (current < 0){
+		return FAIL;
+	}
+	return scans[current]->DeleteCurrent();
+}
+
+
+//-------------------------------------------------------------------
+// PartitionedBTreeFileScan::Advance
+//
+// Input   : part - a partition whose scan has no entry in the heap
+// Output  : None
+// Return  : OK if successful, FAIL otherwise.
+// Purpose : Read the next entry of the partition scan into the heap,
+//           unless the scan is done.
+//-------------------------------------------------------------------
+
+Status
+PartitionedBTreeFileScan::Advance(const int part)
+{
+	Head head;
+	Status next = scans[part]->GetNext(head.rid, head.key);
+	if (next == DONE){
+		return OK;
+	}
+	if (next != OK){
+		return FAIL;
+	}
+	head.part = part;
+	heap.push_back(head);
+	std::push_heap(heap.begin(), heap.end(), After);
+	return OK;
+}